@@ -60,6 +60,8 @@ namespace json_commander::arg {
     validate::Validator validator;
     std::optional<nlohmann::json> default_value;
     bool repeated;
+    // Set when values are also read from stdin, split on this character.
+    std::optional<char> stdin_delimiter = std::nullopt;
   };
 
   using ArgSpec =
@@ -99,6 +101,32 @@ namespace json_commander::arg {
       return resolve_env(*binding);
     }
 
+    // `value`, given as JSON for an argument converted by `converter` (a
+    // default or a config file value), in the form the parser gives it:
+    // lists the converter packs are packed, each occurrence's when the
+    // argument is repeated.
+    inline nlohmann::json
+    typed_value(
+      const conv::Converter& converter, bool repeated, nlohmann::json value) {
+      if (!conv::is_packed(converter)) { return value; }
+      if (!repeated) { return conv::pack(converter, std::move(value)); }
+      if (value.is_array()) {
+        for (auto& element : value) {
+          element = conv::pack(converter, std::move(element));
+        }
+      }
+      return value;
+    }
+
+    inline std::optional<nlohmann::json>
+    typed_default(
+      const conv::Converter& converter,
+      bool repeated,
+      const std::optional<nlohmann::json>& value) {
+      if (!value.has_value()) { return std::nullopt; }
+      return typed_value(converter, repeated, *value);
+    }
+
   } // namespace detail
 
   // -------------------------------------------------------------------------
@@ -133,26 +161,37 @@ namespace json_commander::arg {
 
   inline OptionSpec
   make(const model::Option& opt) {
+    auto converter = conv::make(opt.type, opt.choices);
+    bool repeated = opt.repeated.value_or(false);
+    auto default_value =
+      detail::typed_default(converter, repeated, opt.default_value);
     return {
       opt.names,
       opt.dest.value_or(detail::resolve_dest(opt.names)),
-      conv::make(opt.type, opt.choices),
+      std::move(converter),
       validate::from_option(opt),
-      opt.default_value,
-      opt.repeated.value_or(false),
+      std::move(default_value),
+      repeated,
       detail::resolve_env_opt(opt.env),
     };
   }
 
   inline PositionalSpec
   make(const model::Positional& pos) {
+    auto converter = conv::make(pos.type);
+    bool repeated = pos.repeated.value_or(false);
+    auto default_value =
+      detail::typed_default(converter, repeated, pos.default_value);
     return {
       pos.name,
       pos.name,
-      conv::make(pos.type),
+      std::move(converter),
       validate::from_positional(pos),
-      pos.default_value,
-      pos.repeated.value_or(false),
+      std::move(default_value),
+      repeated,
+      pos.from_stdin.has_value()
+        ? std::optional<char>(*pos.from_stdin == "nul" ? '\0' : '\n')
+        : std::nullopt,
     };
   }
 
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <json_commander/cmd.hpp>
+#include <json_commander/parse.hpp>
+#include <json_commander/thread_pool.hpp>
+
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace json_commander::batch {
+
+  // -------------------------------------------------------------------------
+  // Batch parsing
+  // -------------------------------------------------------------------------
+
+  // Each input is one argument vector, without the program name. `root` is
+  // shared read-only by all threads; specs from cmd::make carry their
+  // tables and command index, so nothing is rebuilt per input. `env` is
+  // called concurrently; without one, the environment is snapshotted once
+  // (parse::EnvSnapshot) for the whole batch.
+
+  // Parses every input as parse::try_parse would. Results are in input
+  // order.
+  inline std::vector<parse::TryResult>
+  try_parse(
+    const cmd::RootSpec& root,
+    std::span<const std::vector<std::string>> inputs,
+    thread_pool::Pool& pool,
+    const parse::EnvLookup& env) {
+    std::vector<std::optional<parse::TryResult>> slots(inputs.size());
+    pool.parallel_for(inputs.size(), [&](std::size_t i) {
+      slots[i].emplace(parse::try_parse(root, inputs[i], env));
+    });
+    std::vector<parse::TryResult> results;
+    results.reserve(slots.size());
+    for (auto& slot : slots) {
+      results.push_back(std::move(*slot));
+    }
+    return results;
+  }
+
+  inline std::vector<parse::TryResult>
+  try_parse(
+    const cmd::RootSpec& root,
+    std::span<const std::vector<std::string>> inputs,
+    thread_pool::Pool& pool) {
+    return try_parse(root, inputs, pool, parse::env_snapshot(root));
+  }
+
+  // Parses every input as parse::parse_all would. Results are in input
+  // order.
+  inline std::vector<parse::ParseResult>
+  parse_all(
+    const cmd::RootSpec& root,
+    std::span<const std::vector<std::string>> inputs,
+    thread_pool::Pool& pool,
+    const parse::EnvLookup& env) {
+    std::vector<parse::ParseResult> results(inputs.size());
+    pool.parallel_for(inputs.size(), [&](std::size_t i) {
+      results[i] = parse::parse_all(root, inputs[i], env);
+    });
+    return results;
+  }
+
+  inline std::vector<parse::ParseResult>
+  parse_all(
+    const cmd::RootSpec& root,
+    std::span<const std::vector<std::string>> inputs,
+    thread_pool::Pool& pool) {
+    return parse_all(root, inputs, pool, parse::env_snapshot(root));
+  }
+
+} // namespace json_commander::batch
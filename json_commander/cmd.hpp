@@ -1,13 +1,205 @@
 #pragma once
 
 #include <json_commander/arg.hpp>
+#include <json_commander/command_index.hpp>
 
+#include <array>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace json_commander::cmd {
 
+  class Error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  // -------------------------------------------------------------------------
+  // Per-level lookup tables
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    enum class MatchKind { Flag, Option, FlagGroup };
+
+    struct MatchResult {
+      std::size_t arg_index;
+      MatchKind kind;
+      std::size_t entry_index;
+      bool
+      operator==(const MatchResult&) const = default;
+    };
+
+    using command_index::detail::NameHash;
+    using command_index::detail::NameMap;
+    using command_index::detail::PrefixTable;
+
+    // Long names are hashed (looked up by string_view, so callers never
+    // build a key string); single-character names also get a direct slot so
+    // short groups like -abc resolve without hashing.
+    class NameIndex {
+      NameMap<MatchResult> entries_;
+      std::array<std::optional<MatchResult>, 256> shorts_{};
+      PrefixTable<MatchResult> long_names_;
+
+    public:
+      void
+      insert(const std::string& cli_name, MatchResult result) {
+        if (!entries_.emplace(cli_name, result).second) { return; }
+        if (cli_name.size() == 2 && cli_name[0] == '-' && cli_name[1] != '-') {
+          shorts_[static_cast<unsigned char>(cli_name[1])] = result;
+        } else {
+          long_names_.insert(cli_name, result);
+        }
+      }
+
+      // Called by build_index once every name is in.
+      void
+      seal() {
+        long_names_.sort();
+      }
+
+      std::optional<MatchResult>
+      lookup(std::string_view cli_name) const {
+        auto it = entries_.find(cli_name);
+        if (it == entries_.end()) { return std::nullopt; }
+        return it->second;
+      }
+
+      std::optional<MatchResult>
+      lookup_short(char c) const {
+        return shorts_[static_cast<unsigned char>(c)];
+      }
+
+      // Long names ("--" included), in lexical order.
+      std::span<const std::pair<std::string, MatchResult>>
+      long_names() const {
+        return long_names_.entries();
+      }
+
+      // Long names starting with `prefix`, in lexical order.
+      std::span<const std::pair<std::string, MatchResult>>
+      long_with_prefix(std::string_view prefix) const {
+        return long_names_.with_prefix(prefix);
+      }
+
+      // The argument every long name starting with `prefix` belongs to, if
+      // there is exactly one.
+      std::optional<MatchResult>
+      lookup_prefix(std::string_view prefix) const {
+        return long_names_.unique(prefix);
+      }
+    };
+
+    inline std::string
+    cli_name(const std::string& name) {
+      if (name.size() == 1) { return "-" + name; }
+      return "--" + name;
+    }
+
+    inline NameIndex
+    build_index(const std::vector<arg::ArgSpec>& args) {
+      NameIndex index;
+      for (std::size_t i = 0; i < args.size(); ++i) {
+        std::visit(
+          [&](const auto& spec) {
+            using T = std::decay_t<decltype(spec)>;
+            if constexpr (std::is_same_v<T, arg::FlagSpec>) {
+              for (const auto& name : spec.names) {
+                index.insert(cli_name(name), {i, MatchKind::Flag, 0});
+              }
+            } else if constexpr (std::is_same_v<T, arg::OptionSpec>) {
+              for (const auto& name : spec.names) {
+                index.insert(cli_name(name), {i, MatchKind::Option, 0});
+              }
+            } else if constexpr (std::is_same_v<T, arg::FlagGroupSpec>) {
+              for (std::size_t e = 0; e < spec.entries.size(); ++e) {
+                for (const auto& name : spec.entries[e].names) {
+                  index.insert(cli_name(name), {i, MatchKind::FlagGroup, e});
+                }
+              }
+            }
+            // PositionalSpec: not indexed
+          },
+          args[i]);
+      }
+      index.seal();
+      return index;
+    }
+
+  } // namespace detail
+
+  // Index of a config key (an argument dest) within its level. Several
+  // arguments may share a dest; they then share a key.
+  using KeyHandle = std::size_t;
+
+  // Everything the parser needs to know about one command level that can be
+  // derived from its args alone. Built once by make() and shared (immutable)
+  // between copies of the spec.
+  struct LevelTable {
+    detail::NameIndex names;
+    std::vector<std::size_t> positionals;
+    std::vector<std::size_t> env_bound;
+    std::vector<std::string> keys; // distinct dests, in declaration order
+    std::vector<KeyHandle> key_of; // arg index -> key
+    detail::NameMap<KeyHandle> key_index;
+    std::size_t arg_count = 0;
+
+    std::optional<KeyHandle>
+    key(std::string_view dest) const {
+      auto it = key_index.find(dest);
+      if (it == key_index.end()) { return std::nullopt; }
+      return it->second;
+    }
+  };
+
+  namespace detail {
+
+    inline const std::string&
+    dest_of(const arg::ArgSpec& a) {
+      return std::visit(
+        [](const auto& spec) -> const std::string& { return spec.dest; }, a);
+    }
+
+  } // namespace detail
+
+  inline LevelTable
+  make_table(const std::vector<arg::ArgSpec>& args) {
+    LevelTable table;
+    table.names = detail::build_index(args);
+    table.arg_count = args.size();
+    table.key_of.reserve(args.size());
+    for (std::size_t i = 0; i < args.size(); ++i) {
+      const auto& dest = detail::dest_of(args[i]);
+      auto [it, inserted] = table.key_index.emplace(dest, table.keys.size());
+      if (inserted) { table.keys.push_back(dest); }
+      table.key_of.push_back(it->second);
+      std::visit(
+        [&](const auto& spec) {
+          using T = std::decay_t<decltype(spec)>;
+          if constexpr (std::is_same_v<T, arg::PositionalSpec>) {
+            table.positionals.push_back(i);
+          } else if constexpr (
+            std::is_same_v<T, arg::FlagSpec> ||
+            std::is_same_v<T, arg::OptionSpec>) {
+            if (spec.env.has_value()) { table.env_bound.push_back(i); }
+          }
+        },
+        args[i]);
+    }
+    return table;
+  }
+
   // -------------------------------------------------------------------------
   // Spec types
   // -------------------------------------------------------------------------
@@ -17,6 +209,7 @@ namespace json_commander::cmd {
     model::DocString doc;
     std::vector<arg::ArgSpec> args;
     std::vector<CommandSpec> commands;
+    std::shared_ptr<const LevelTable> table; // reset after editing args
   };
 
   struct RootSpec {
@@ -26,8 +219,44 @@ namespace json_commander::cmd {
     std::vector<CommandSpec> commands;
     std::optional<std::string> version;
     std::optional<model::Config> config;
+    std::optional<model::Parsing> parsing;
+    std::shared_ptr<const LevelTable> table; // reset after editing args
+    std::shared_ptr<const command_index::Index> index; // reset after edits
   };
 
+  // Returns the table make() built, or builds one into `scratch` for specs
+  // assembled by hand. The table is trusted as is: a spec whose args are
+  // edited after make() must reset its `table` to have it rebuilt.
+  inline const LevelTable&
+  table_for(
+    const std::vector<arg::ArgSpec>& args,
+    const std::shared_ptr<const LevelTable>& table,
+    std::optional<LevelTable>& scratch) {
+    if (table) { return *table; }
+    scratch = make_table(args);
+    return *scratch;
+  }
+
+  // As table_for, but hands out shared ownership so the table can outlive
+  // the call (parse results keep it to resolve key handles).
+  inline std::shared_ptr<const LevelTable>
+  shared_table(
+    const std::vector<arg::ArgSpec>& args,
+    const std::shared_ptr<const LevelTable>& table) {
+    if (table) { return table; }
+    return std::make_shared<const LevelTable>(make_table(args));
+  }
+
+  // Returns the command index built by make(), or builds one for specs
+  // assembled by hand. Like the level tables it is trusted as is: a spec
+  // whose command tree is edited after make() must reset its `index`.
+  inline std::shared_ptr<const command_index::Index>
+  shared_index(const RootSpec& root) {
+    if (root.index) { return root.index; }
+    return std::make_shared<const command_index::Index>(
+      command_index::make(root));
+  }
+
   // -------------------------------------------------------------------------
   // Forward declarations
   // -------------------------------------------------------------------------
@@ -41,21 +270,30 @@ namespace json_commander::cmd {
 
   inline CommandSpec
   make(const model::Command& cmd) {
+    auto args = cmd.args.has_value() ? arg::make_all(*cmd.args)
+                                     : std::vector<arg::ArgSpec>{};
+    auto table = std::make_shared<const LevelTable>(make_table(args));
     return {
       cmd.name,
       cmd.doc,
-      cmd.args.has_value() ? arg::make_all(*cmd.args)
-                           : std::vector<arg::ArgSpec>{},
+      std::move(args),
       cmd.commands.has_value() ? make_all(*cmd.commands)
                                : std::vector<CommandSpec>{},
+      std::move(table),
     };
   }
 
+  // Throws cmd::Error when two sibling commands share a name: only the
+  // first could ever be invoked.
   inline std::vector<CommandSpec>
   make_all(const std::vector<model::Command>& commands) {
     std::vector<CommandSpec> specs;
     specs.reserve(commands.size());
+    std::unordered_set<std::string_view> seen;
     for (const auto& c : commands) {
+      if (!seen.insert(c.name).second) {
+        throw Error("duplicate command name: " + c.name);
+      }
       specs.push_back(make(c));
     }
     return specs;
@@ -63,16 +301,24 @@ namespace json_commander::cmd {
 
   inline RootSpec
   make(const model::Root& root) {
-    return {
+    auto args = root.args.has_value() ? arg::make_all(*root.args)
+                                      : std::vector<arg::ArgSpec>{};
+    auto table = std::make_shared<const LevelTable>(make_table(args));
+    RootSpec spec{
       root.name,
       root.doc,
-      root.args.has_value() ? arg::make_all(*root.args)
-                            : std::vector<arg::ArgSpec>{},
+      std::move(args),
       root.commands.has_value() ? make_all(*root.commands)
                                 : std::vector<CommandSpec>{},
       root.version,
       root.config,
+      root.parsing,
+      std::move(table),
+      nullptr,
     };
+    spec.index =
+      std::make_shared<const command_index::Index>(command_index::make(spec));
+    return spec;
   }
 
 } // namespace json_commander::cmd
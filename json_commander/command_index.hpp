@@ -0,0 +1,265 @@
+#pragma once
+
+#include <json_commander/model.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace json_commander::command_index {
+
+  // -------------------------------------------------------------------------
+  // Detail: hashing and tree access
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    struct NameHash {
+      using is_transparent = void;
+      std::size_t
+      operator()(std::string_view s) const {
+        return std::hash<std::string_view>{}(s);
+      }
+    };
+
+    // String-keyed hash map that can be probed with a string_view.
+    template <class Value>
+    using NameMap =
+      std::unordered_map<std::string, Value, NameHash, std::equal_to<>>;
+
+    // Names in lexical order, so all names starting with a given prefix form
+    // one contiguous run found by binary search: O(len log n) per lookup.
+    template <class Value>
+    class PrefixTable {
+    public:
+      using Entry = std::pair<std::string, Value>;
+
+      void
+      insert(std::string name, Value value) {
+        entries_.emplace_back(std::move(name), std::move(value));
+      }
+
+      // Must be called once all names are inserted.
+      void
+      sort() {
+        std::sort(
+          entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+            return a.first < b.first;
+          });
+      }
+
+      std::span<const Entry>
+      with_prefix(std::string_view prefix) const {
+        auto first = std::lower_bound(
+          entries_.begin(),
+          entries_.end(),
+          prefix,
+          [](const Entry& e, std::string_view p) { return e.first < p; });
+        auto last =
+          std::partition_point(first, entries_.end(), [&](const Entry& e) {
+            return std::string_view(e.first).starts_with(prefix);
+          });
+        return {first, last};
+      }
+
+      const std::vector<Entry>&
+      entries() const {
+        return entries_;
+      }
+
+      // The value shared by every name starting with `prefix`; nullopt when
+      // no name matches or the matches disagree.
+      std::optional<Value>
+      unique(std::string_view prefix) const {
+        auto run = with_prefix(prefix);
+        if (run.empty()) { return std::nullopt; }
+        for (const auto& entry : run) {
+          if (!(entry.second == run.front().second)) { return std::nullopt; }
+        }
+        return run.front().second;
+      }
+
+    private:
+      std::vector<Entry> entries_;
+    };
+
+    template <class T>
+    struct is_optional : std::false_type {};
+
+    template <class T>
+    struct is_optional<std::optional<T>> : std::true_type {};
+
+    // model::Root/Command keep subcommands in an optional vector, the
+    // compiled cmd::RootSpec/CommandSpec in a plain one.
+    template <class Node>
+    const auto*
+    subcommands(const Node& node) {
+      using Commands = std::decay_t<decltype(node.commands)>;
+      if constexpr (is_optional<Commands>::value) {
+        return node.commands.has_value() ? &*node.commands : nullptr;
+      } else {
+        return &node.commands;
+      }
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Index
+  // -------------------------------------------------------------------------
+
+  // Flattened view of a command tree. Each node records its position within
+  // its parent's command list rather than a pointer, so one index serves
+  // every copy of the tree it was built from, as well as the model::Root and
+  // the cmd::RootSpec compiled from it (cmd::make keeps command order).
+  class Index {
+  public:
+    using Node = std::size_t;
+    static constexpr Node root = 0;
+
+    std::optional<Node>
+    child(Node parent, std::string_view name) const {
+      const auto& children = nodes_[parent].children;
+      auto it = children.find(name);
+      if (it == children.end()) { return std::nullopt; }
+      return it->second;
+    }
+
+    // Subcommands of `parent` in lexical order.
+    std::span<const std::pair<std::string, Node>>
+    children(Node parent) const {
+      return nodes_[parent].prefixes.entries();
+    }
+
+    // Subcommands of `parent` whose names start with `prefix`.
+    std::span<const std::pair<std::string, Node>>
+    children_with_prefix(Node parent, std::string_view prefix) const {
+      return nodes_[parent].prefixes.with_prefix(prefix);
+    }
+
+    // The only subcommand of `parent` whose name starts with `prefix`.
+    std::optional<Node>
+    child_by_prefix(Node parent, std::string_view prefix) const {
+      return nodes_[parent].prefixes.unique(prefix);
+    }
+
+    std::optional<Node>
+    find(const std::vector<std::string>& path) const {
+      Node node = root;
+      for (const auto& segment : path) {
+        auto next = child(node, segment);
+        if (!next.has_value()) { return std::nullopt; }
+        node = *next;
+      }
+      return node;
+    }
+
+    // Index of `node` within its parent's command list.
+    std::size_t
+    position(Node node) const {
+      return nodes_[node].route.back();
+    }
+
+    std::size_t
+    child_count(Node node) const {
+      return nodes_[node].children.size();
+    }
+
+    std::size_t
+    size() const {
+      return nodes_.size();
+    }
+
+    // Returns the command for `node` in `tree`, or nullptr for the root.
+    template <class Tree>
+    const auto*
+    resolve(const Tree& tree, Node node) const {
+      using Command = typename std::decay_t<
+        decltype(*detail::subcommands(tree))>::value_type;
+      const Command* current = nullptr;
+      const auto* commands = detail::subcommands(tree);
+      for (auto pos : nodes_[node].route) {
+        current = &(*commands)[pos];
+        commands = detail::subcommands(*current);
+      }
+      return current;
+    }
+
+    template <class Tree>
+    friend Index
+    make(const Tree& tree);
+
+  private:
+    struct Entry {
+      std::vector<std::size_t> route; // positions from the root down
+      detail::NameMap<Node> children;
+      detail::PrefixTable<Node> prefixes;
+    };
+
+    template <class Parent>
+    void
+    add_children(Node parent, const Parent& node) {
+      const auto* commands = detail::subcommands(node);
+      if (commands == nullptr) { return; }
+      for (std::size_t i = 0; i < commands->size(); ++i) {
+        const auto& command = (*commands)[i];
+        Node id = nodes_.size();
+        auto route = nodes_[parent].route;
+        route.push_back(i);
+        nodes_.push_back({std::move(route), {}, {}});
+        // First definition wins, matching the order of a linear scan.
+        if (nodes_[parent].children.emplace(command.name, id).second) {
+          nodes_[parent].prefixes.insert(command.name, id);
+        }
+        add_children(id, command);
+      }
+      nodes_[parent].prefixes.sort();
+    }
+
+    std::vector<Entry> nodes_;
+  };
+
+  // -------------------------------------------------------------------------
+  // Factory
+  // -------------------------------------------------------------------------
+
+  // Builds the index for a model::Root or cmd::RootSpec.
+  template <class Tree>
+  Index
+  make(const Tree& tree) {
+    Index index;
+    index.nodes_.push_back({});
+    index.add_children(Index::root, tree);
+    return index;
+  }
+
+  // Looks up `path` in `tree`, throwing std::runtime_error naming the first
+  // segment that does not exist.
+  template <class Tree>
+  const auto&
+  find_command(
+    const Tree& tree,
+    const Index& index,
+    const std::vector<std::string>& path) {
+    if (path.empty()) { throw std::runtime_error("find_command: empty path"); }
+    Index::Node node = Index::root;
+    for (const auto& segment : path) {
+      auto next = index.child(node, segment);
+      if (!next.has_value()) {
+        throw std::runtime_error("subcommand not found: " + segment);
+      }
+      node = *next;
+    }
+    return *index.resolve(tree, node);
+  }
+
+} // namespace json_commander::command_index
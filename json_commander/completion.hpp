@@ -58,8 +58,17 @@ namespace json_commander::completion {
       return false;
     }
 
+    struct PositionalInfo {
+      std::string name;
+      std::string description;
+      bool is_file;
+      bool is_dir;
+      bool is_path;
+    };
+
     struct CompletionData {
       std::vector<OptionInfo> options;
+      std::vector<PositionalInfo> positionals; // in declaration order
       std::vector<std::string> subcommand_names;
       std::vector<std::string> subcommand_docs;
       bool has_file_positional = false;
@@ -122,6 +131,12 @@ namespace json_commander::completion {
                 data.options.push_back(info);
               }
             } else if constexpr (std::is_same_v<T, model::Positional>) {
+              data.positionals.push_back(
+                {a.name,
+                 first_doc_line(a.doc),
+                 is_file_type(a.type),
+                 is_dir_type(a.type),
+                 is_path_type(a.type)});
               if (is_file_type(a.type) || is_path_type(a.type)) {
                 data.has_file_positional = true;
               }
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <json_commander/mapped_file.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace json_commander::config_cache {
+
+  // Bumped whenever the layout of a cache entry changes.
+  inline constexpr int format_version = 1;
+
+  // What identifies one version of a source file: if none of these changed,
+  // neither did its contents.
+  struct Stamp {
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+    bool
+    operator==(const Stamp&) const = default;
+  };
+
+  // A source file and its stamp, taken before it was read.
+  struct Source {
+    std::filesystem::path path;
+    Stamp stamp;
+  };
+
+  // -------------------------------------------------------------------------
+  // Detail: stamps and keys
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // 64-bit FNV-1a: stable across builds and platforms, unlike std::hash,
+    // so every program using the cache names its entries the same way.
+    inline std::uint64_t
+    fnv1a(std::string_view text, std::uint64_t h = 14695981039346656037ull) {
+      for (unsigned char c : text) {
+        h ^= c;
+        h *= 1099511628211ull;
+      }
+      return h;
+    }
+
+    inline std::string
+    hex(std::uint64_t value) {
+      static constexpr char digits[] = "0123456789abcdef";
+      std::string out(16, '0');
+      for (int i = 15; i >= 0; --i, value >>= 4) {
+        out[static_cast<std::size_t>(i)] = digits[value & 0xf];
+      }
+      return out;
+    }
+
+    inline nlohmann::json
+    to_json(const std::vector<Source>& sources) {
+      auto out = nlohmann::json::array();
+      for (const auto& s : sources) {
+        out.push_back(
+          {s.path.string(),
+           s.stamp.dev,
+           s.stamp.ino,
+           s.stamp.size,
+           s.stamp.mtime_ns});
+      }
+      return out;
+    }
+
+    inline int
+    process_id() {
+#ifdef _WIN32
+      return ::_getpid();
+#else
+      return static_cast<int>(::getpid());
+#endif
+    }
+
+    // Writes `bytes` to a temporary file next to `path` and renames it into
+    // place, so a concurrent reader sees the old file or the new one, never
+    // part of one. The temporary's name is unique to the process and the
+    // call, so concurrent writers (threads included) never share one.
+    // Returns false if it could not be written.
+    inline bool
+    write_atomic(
+      const std::filesystem::path& path,
+      const std::vector<std::uint8_t>& bytes) {
+      static std::atomic<std::uint64_t> writes{0};
+      std::error_code ec;
+      std::filesystem::create_directories(path.parent_path(), ec);
+      if (ec) { return false; }
+      auto temp = path;
+      temp += ".tmp" + std::to_string(process_id()) + "." +
+              std::to_string(writes.fetch_add(1, std::memory_order_relaxed));
+      {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(
+          reinterpret_cast<const char*>(bytes.data()),
+          static_cast<std::streamsize>(bytes.size()));
+        if (!out.flush()) {
+          out.close();
+          std::filesystem::remove(temp, ec);
+          return false;
+        }
+      }
+      std::filesystem::rename(temp, path, ec);
+      if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+      }
+      return true;
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Public API
+  // -------------------------------------------------------------------------
+
+  // Stats `path`. Returns nullopt when it cannot be. Windows has no inode
+  // numbers, so only size and modification time are compared there.
+  inline std::optional<Stamp>
+  stamp(const std::filesystem::path& path) {
+#ifdef _WIN32
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) { return std::nullopt; }
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) { return std::nullopt; }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      time.time_since_epoch());
+    return Stamp{0, 0, size, static_cast<std::int64_t>(ns.count())};
+#else
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) { return std::nullopt; }
+#ifdef __APPLE__
+    const auto& mtime = st.st_mtimespec;
+#else
+    const auto& mtime = st.st_mtim;
+#endif
+    return Stamp{
+      static_cast<std::uint64_t>(st.st_dev),
+      static_cast<std::uint64_t>(st.st_ino),
+      static_cast<std::uint64_t>(st.st_size),
+      static_cast<std::int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec};
+#endif
+  }
+
+  // $XDG_CACHE_HOME/json-commander, falling back to ~/.cache (%LOCALAPPDATA%
+  // on Windows). Returns nullopt when the environment names neither.
+  inline std::optional<std::filesystem::path>
+  directory() {
+    std::filesystem::path base;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+      base = xdg;
+#ifdef _WIN32
+    } else if (const char* local = std::getenv("LOCALAPPDATA"); local) {
+      base = local;
+#else
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+      base = std::filesystem::path(home) / ".cache";
+#endif
+    } else {
+      return std::nullopt;
+    }
+    return base / "json-commander";
+  }
+
+  // The entry for `program` whose sources were found from `scope` (the
+  // config declaration and working directory, which decide what the
+  // sources are). Each program and scope has one entry, replaced as its
+  // sources change.
+  inline std::filesystem::path
+  entry_path(
+    const std::filesystem::path& dir,
+    std::string_view program,
+    std::string_view scope) {
+    auto key = detail::fnv1a(scope, detail::fnv1a(program));
+    return dir / (std::string(program) + "-" + detail::hex(key) + ".cbor");
+  }
+
+  // The merged config stored at `entry`, provided it was built by this
+  // format version from exactly `sources` with unchanged stamps, under a
+  // schema with this `fingerprint`. Anything else, including a missing or
+  // damaged entry, is a miss.
+  inline std::optional<nlohmann::json>
+  lookup(
+    const std::filesystem::path& entry,
+    const std::vector<Source>& sources,
+    std::uint64_t fingerprint) {
+    std::string error;
+    auto mapping = mapped_file::try_open(entry, error);
+    if (!mapping.has_value()) { return std::nullopt; }
+    auto bytes = mapping->view();
+    auto j = nlohmann::json::from_cbor(bytes.begin(), bytes.end(), true, false);
+    if (
+      !j.is_object() || j.value("version", 0) != format_version ||
+      !j.contains("schema") || j["schema"] != fingerprint ||
+      !j.contains("sources") || j["sources"] != detail::to_json(sources) ||
+      !j.contains("config")) {
+      return std::nullopt;
+    }
+    return std::move(j["config"]);
+  }
+
+  // Writes `config` as the entry for `sources`, atomically (see
+  // detail::write_atomic). Returns false if it could not be written; the
+  // cache is only an optimization.
+  inline bool
+  store(
+    const std::filesystem::path& entry,
+    const std::vector<Source>& sources,
+    std::uint64_t fingerprint,
+    const nlohmann::json& config) {
+    return detail::write_atomic(
+      entry,
+      nlohmann::json::to_cbor(
+        {{"version", format_version},
+         {"schema", fingerprint},
+         {"sources", detail::to_json(sources)},
+         {"config", config}}));
+  }
+
+} // namespace json_commander::config_cache
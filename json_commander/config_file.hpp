@@ -0,0 +1,402 @@
+#pragma once
+
+#include <json_commander/config_cache.hpp>
+#include <json_commander/config_schema.hpp>
+#include <json_commander/mapped_file.hpp>
+#include <json_commander/model.hpp>
+#include <json_commander/model_json.hpp>
+#include <json_commander/thread_pool.hpp>
+
+#include <nlohmann/json-schema.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace json_commander::config_file {
+
+  class Error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  // -------------------------------------------------------------------------
+  // Detail: locating files
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // The user's home directory, if the environment names one.
+    inline std::optional<std::filesystem::path>
+    home() {
+#ifdef _WIN32
+      const char* dir = std::getenv("USERPROFILE");
+#else
+      const char* dir = std::getenv("HOME");
+#endif
+      if (dir == nullptr || *dir == '\0') { return std::nullopt; }
+      return std::filesystem::path(dir);
+    }
+
+    // Expands a leading "~" to the home directory. Without one, the path is
+    // returned as it is.
+    inline std::filesystem::path
+    expand_user(const std::string& path) {
+      if (path != "~" && !path.starts_with("~/")) { return path; }
+      auto dir = home();
+      if (!dir.has_value()) { return path; }
+      return path.size() == 1 ? *dir : *dir / path.substr(2);
+    }
+
+    inline bool
+    is_file(const std::filesystem::path& path) {
+      std::error_code ec;
+      return std::filesystem::is_regular_file(path, ec);
+    }
+
+    // Looks for a relative `path` in `dir` and each of its parents, nearest
+    // first; an absolute one is only checked where it is.
+    inline std::optional<std::filesystem::path>
+    find_upward(
+      const std::filesystem::path& path, std::filesystem::path dir) {
+      if (path.is_absolute()) {
+        if (is_file(path)) { return path; }
+        return std::nullopt;
+      }
+      for (;;) {
+        if (auto candidate = dir / path; is_file(candidate)) {
+          return candidate;
+        }
+        auto parent = dir.parent_path();
+        if (parent == dir || parent.empty()) { return std::nullopt; }
+        dir = std::move(parent);
+      }
+    }
+
+    // The fragments of a drop-in directory: files with the format's
+    // extension, hidden ones skipped, sorted bytewise by name so every host
+    // merges them in the same order. A missing directory has none.
+    inline std::vector<std::filesystem::path>
+    fragments(const std::filesystem::path& dir, const std::string& format) {
+      std::vector<std::filesystem::path> found;
+      const auto extension = "." + format;
+      std::error_code ec;
+      std::filesystem::directory_iterator it(dir, ec), end;
+      for (; !ec && it != end; it.increment(ec)) {
+        const auto& path = it->path();
+        if (path.filename().string().starts_with('.')) { continue; }
+        if (path.extension() != extension || !is_file(path)) { continue; }
+        found.push_back(path);
+      }
+      std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) {
+        return a.filename().string() < b.filename().string();
+      });
+      return found;
+    }
+
+    // -----------------------------------------------------------------------
+    // Reading and merging
+    // -----------------------------------------------------------------------
+
+    // Parses the text of config file `path`. Empty text counts as an empty
+    // object.
+    inline std::optional<nlohmann::json>
+    parse_text(
+      const std::filesystem::path& path,
+      std::string_view text,
+      std::string& error) {
+      if (text.empty()) { return nlohmann::json::object(); }
+      auto j = nlohmann::json::parse(text.begin(), text.end(), nullptr, false);
+      if (j.is_discarded()) {
+        error = path.string() + ": invalid JSON";
+        return std::nullopt;
+      }
+      if (!j.is_object()) {
+        error = path.string() + ": expected an object";
+        return std::nullopt;
+      }
+      return j;
+    }
+
+    // Maps and parses one config file.
+    inline std::optional<nlohmann::json>
+    read(const std::filesystem::path& path, std::string& error) {
+      auto mapping = mapped_file::try_open(path, error);
+      if (!mapping.has_value()) {
+        error = path.string() + ": " + error;
+        return std::nullopt;
+      }
+      return parse_text(path, mapping->view(), error);
+    }
+
+    // Like read, but copies the file into memory instead of mapping it:
+    // a mapped file truncated by another process faults its reader, which
+    // is fine at startup but not for files that are being edited.
+    inline std::optional<nlohmann::json>
+    read_copy(const std::filesystem::path& path, std::string& error) {
+      std::ifstream in(path, std::ios::binary);
+      if (!in) {
+        error = path.string() + ": " + std::generic_category().message(errno);
+        return std::nullopt;
+      }
+      std::string text(std::istreambuf_iterator<char>(in), {});
+      return parse_text(path, text, error);
+    }
+
+    // One file's contents, or why it could not be read.
+    struct Parsed {
+      std::optional<nlohmann::json> value;
+      std::string error;
+    };
+
+    // Below this many files, or this many bytes among them, starting
+    // threads costs more than reading the files one after another.
+    inline constexpr std::size_t parallel_files = 4;
+    inline constexpr std::uintmax_t parallel_bytes = 1 << 20;
+    // Reading is mostly waiting on the disk; more threads than this do
+    // not help.
+    inline constexpr std::size_t max_read_threads = 4;
+
+    inline bool
+    worth_parallel(const std::vector<std::filesystem::path>& files) {
+      if (files.size() < parallel_files) { return false; }
+      std::uintmax_t bytes = 0;
+      for (const auto& path : files) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if (!ec) { bytes += size; }
+        if (bytes >= parallel_bytes) { return true; }
+      }
+      return false;
+    }
+
+    // Maps and parses `files`, several at a time when there are enough of
+    // them to pay for the threads. Each result has its own slot, so they
+    // come back in the order given whichever finished first.
+    inline std::vector<Parsed>
+    read_all(const std::vector<std::filesystem::path>& files) {
+      std::vector<Parsed> parsed(files.size());
+      auto read_one = [&](std::size_t i) {
+        parsed[i].value = read(files[i], parsed[i].error);
+      };
+      if (!worth_parallel(files)) {
+        for (std::size_t i = 0; i < files.size(); ++i) {
+          read_one(i);
+        }
+        return parsed;
+      }
+      auto threads = std::min(
+        {files.size(),
+         max_read_threads,
+         std::max<std::size_t>(1, std::thread::hardware_concurrency())});
+      thread_pool::Pool pool(threads);
+      pool.parallel_for(files.size(), read_one);
+      return parsed;
+    }
+
+    // Lays `layer` over `base`: objects are merged key by key, anything
+    // else in `layer` replaces what `base` had.
+    inline void
+    merge(nlohmann::json& base, const nlohmann::json& layer) {
+      for (const auto& [key, value] : layer.items()) {
+        auto it = base.find(key);
+        if (it != base.end() && it->is_object() && value.is_object()) {
+          merge(*it, value);
+        } else {
+          base[key] = value;
+        }
+      }
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Public API
+  // -------------------------------------------------------------------------
+
+  // The files `config` declares that exist, lowest precedence first:
+  // system, then the drop-in fragments in lexical order, then user (with
+  // "~" expanded), then local (the nearest one found from `dir` upward).
+  inline std::vector<std::filesystem::path>
+  paths(const model::Config& config, const std::filesystem::path& dir) {
+    std::vector<std::filesystem::path> found;
+    if (!config.paths.has_value()) { return found; }
+    const auto& p = *config.paths;
+    if (p.system.has_value() && detail::is_file(*p.system)) {
+      found.emplace_back(*p.system);
+    }
+    if (p.drop_in.has_value()) {
+      auto drop_in = detail::expand_user(*p.drop_in);
+      for (auto& fragment : detail::fragments(drop_in, config.format)) {
+        found.push_back(std::move(fragment));
+      }
+    }
+    if (p.user.has_value()) {
+      auto user = detail::expand_user(*p.user);
+      if (detail::is_file(user)) { found.push_back(std::move(user)); }
+    }
+    if (p.local.has_value()) {
+      auto local = detail::find_upward(detail::expand_user(*p.local), dir);
+      if (local.has_value()) { found.push_back(std::move(*local)); }
+    }
+    return found;
+  }
+
+  // What a cached load of `root` is keyed on besides the files: a hash of
+  // the whole model, so any change to it, and so to the config schema,
+  // misses. It costs a dump of the model; a caller that needs it more than
+  // once keeps it.
+  inline std::uint64_t
+  fingerprint(const model::Root& root) {
+    return config_cache::detail::fnv1a(nlohmann::json(root).dump());
+  }
+
+  namespace detail {
+
+    // -----------------------------------------------------------------------
+    // Cache
+    // -----------------------------------------------------------------------
+
+    // Where a load with `config.cache` set looks for and keeps its result.
+    // `fingerprint` is config_file::fingerprint of the root.
+    struct CacheSlot {
+      std::filesystem::path entry;
+      std::vector<config_cache::Source> sources;
+      std::uint64_t fingerprint = 0;
+    };
+
+    // Stamps `files` before they are read, so a file changed while it is
+    // being read gets a stamp that will not match next time. Returns
+    // nullopt when caching is off, there is no cache directory, or a file
+    // cannot be stat'ed.
+    inline std::optional<CacheSlot>
+    cache_slot(
+      const model::Root& root,
+      const std::vector<std::filesystem::path>& files,
+      const std::filesystem::path& dir,
+      std::optional<std::uint64_t> fingerprint) {
+      if (!root.config->cache.value_or(false)) { return std::nullopt; }
+      auto cache_dir = config_cache::directory();
+      if (!cache_dir.has_value()) { return std::nullopt; }
+      CacheSlot slot;
+      for (const auto& path : files) {
+        auto stamp = config_cache::stamp(path);
+        if (!stamp.has_value()) { return std::nullopt; }
+        slot.sources.push_back({path, *stamp});
+      }
+      // The declaration and directory decide which files are sources.
+      auto scope = nlohmann::json(*root.config).dump() + '\n' + dir.string();
+      slot.entry = config_cache::entry_path(*cache_dir, root.name, scope);
+      // Only worked out once caching is known to be on.
+      slot.fingerprint = fingerprint.has_value()
+                           ? *fingerprint
+                           : config_file::fingerprint(root);
+      return slot;
+    }
+
+    // try_load, with `fingerprint` when the caller has it. The validation
+    // schema is built only when the cache misses.
+    inline std::optional<nlohmann::json>
+    load(
+      const model::Root& root,
+      std::string& error,
+      const std::filesystem::path& dir,
+      std::optional<std::uint64_t> fingerprint) {
+      auto merged = nlohmann::json::object();
+      if (!root.config.has_value()) { return merged; }
+      auto files = paths(*root.config, dir);
+      if (files.empty()) { return merged; }
+      if (root.config->format != "json") {
+        error = files.front().string() + ": " + root.config->format +
+                " config files are not supported";
+        return std::nullopt;
+      }
+
+      auto cache = cache_slot(root, files, dir, fingerprint);
+      if (cache.has_value()) {
+        auto hit = config_cache::lookup(
+          cache->entry, cache->sources, cache->fingerprint);
+        if (hit.has_value()) { return hit; }
+      }
+
+      nlohmann::json_schema::json_validator validator;
+      validator.set_root_schema(config_schema::to_config_file_schema(root));
+      auto parsed = read_all(files);
+      for (std::size_t i = 0; i < files.size(); ++i) {
+        auto& layer = parsed[i].value;
+        if (!layer.has_value()) {
+          error = std::move(parsed[i].error);
+          return std::nullopt;
+        }
+        try {
+          validator.validate(*layer);
+        } catch (const std::exception& e) {
+          error = files[i].string() + ": " + e.what();
+          return std::nullopt;
+        }
+        merge(merged, *layer);
+      }
+      if (cache.has_value()) {
+        config_cache::store(
+          cache->entry, cache->sources, cache->fingerprint, merged);
+      }
+      return merged;
+    }
+
+  } // namespace detail
+
+  // Reads the config files `root` declares and merges them in the order
+  // paths() lists them into one object for parse::try_parse's `files`.
+  // Files are mapped and parsed (in parallel when there are many), then
+  // checked against config_schema::to_config_file_schema and merged one by
+  // one, so the result and the error reported are those of a sequential
+  // load. Missing files are skipped; with none, or no config declared, the
+  // result is an empty object. Returns nullopt with `error` set when a file
+  // cannot be read or does not match. Only the "json" format is read so far.
+  //
+  // With `cache` set in the declaration, the merged result is kept under
+  // config_cache::directory() and reused, without reading or validating
+  // anything, while every file's stamp and the model are unchanged.
+  inline std::optional<nlohmann::json>
+  try_load(
+    const model::Root& root,
+    std::string& error,
+    const std::filesystem::path& dir = std::filesystem::current_path()) {
+    return detail::load(root, error, dir, std::nullopt);
+  }
+
+  // As above, with the fingerprint(root) the caller already has.
+  inline std::optional<nlohmann::json>
+  try_load(
+    const model::Root& root,
+    std::uint64_t fingerprint,
+    std::string& error,
+    const std::filesystem::path& dir = std::filesystem::current_path()) {
+    return detail::load(root, error, dir, fingerprint);
+  }
+
+  // Throws config_file::Error where try_load sets `error`.
+  inline nlohmann::json
+  load(
+    const model::Root& root,
+    const std::filesystem::path& dir = std::filesystem::current_path()) {
+    std::string error;
+    auto merged = try_load(root, error, dir);
+    if (!merged.has_value()) { throw Error(error); }
+    return std::move(*merged);
+  }
+
+} // namespace json_commander::config_file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <json_commander/arg.hpp>
+#include <json_commander/command_index.hpp>
 #include <json_commander/model.hpp>
 #include <nlohmann/json.hpp>
 
@@ -22,6 +23,11 @@ namespace json_commander::config_schema {
         case model::ScalarType::Int:
           schema["type"] = "integer";
           break;
+        case model::ScalarType::Size:
+        case model::ScalarType::Duration:
+          schema["type"] = "integer";
+          schema["minimum"] = 0;
+          break;
         case model::ScalarType::Float:
           schema["type"] = "number";
           break;
@@ -48,8 +54,12 @@ namespace json_commander::config_schema {
           if constexpr (std::is_same_v<T, model::ScalarType>) {
             return scalar_type_schema(s, choices);
           } else if constexpr (std::is_same_v<T, model::ListType>) {
-            return {
+            nlohmann::json schema = {
               {"type", "array"}, {"items", scalar_type_schema(s.element)}};
+            if (s.max_elements.has_value()) {
+              schema["maxItems"] = *s.max_elements;
+            }
+            return schema;
           } else if constexpr (std::is_same_v<T, model::PairType>) {
             return {
               {"type", "array"},
@@ -213,6 +223,28 @@ namespace json_commander::config_schema {
       return {{"type", "object"}, {"oneOf", variants}};
     }
 
+    // One level of a config file: every argument is optional, and each
+    // subcommand's settings sit in an object under its name.
+    inline nlohmann::json
+    generate_file_schema(
+      const std::vector<model::Argument>& args,
+      const std::vector<model::Command>& commands) {
+      nlohmann::json properties = nlohmann::json::object();
+      for (const auto& a : args) {
+        auto [dest, schema] = arg_schema(a);
+        properties[dest] = schema;
+      }
+      for (const auto& cmd : commands) {
+        properties[cmd.name] = generate_file_schema(
+          cmd.args.value_or(std::vector<model::Argument>{}),
+          cmd.commands.value_or(std::vector<model::Command>{}));
+      }
+      return {
+        {"type", "object"},
+        {"properties", properties},
+        {"additionalProperties", false}};
+    }
+
   } // namespace detail
 
   // -------------------------------------------------------------------------
@@ -235,15 +267,15 @@ namespace json_commander::config_schema {
 
   inline nlohmann::json
   to_config_schema(
-    const model::Root& root, const std::vector<std::string>& command_path) {
+    const model::Root& root,
+    const command_index::Index& index,
+    const std::vector<std::string>& command_path) {
     if (command_path.empty()) { return to_config_schema(root); }
 
     std::vector<model::Argument> root_args;
     if (root.args.has_value()) { root_args = *root.args; }
 
     std::string display_name = root.name;
-    const std::vector<model::Command>* commands_ptr =
-      root.commands.has_value() ? &*root.commands : nullptr;
 
     struct PathEntry {
       const model::Command* cmd;
@@ -252,24 +284,16 @@ namespace json_commander::config_schema {
     std::vector<PathEntry> path_entries;
     std::string prefix;
 
+    auto node = command_index::Index::root;
     for (const auto& segment : command_path) {
-      if (!commands_ptr) {
-        throw std::runtime_error("subcommand not found: " + segment);
-      }
-      bool found = false;
-      for (const auto& cmd : *commands_ptr) {
-        if (cmd.name == segment) {
-          prefix = prefix.empty() ? segment : prefix + "." + segment;
-          path_entries.push_back({&cmd, prefix});
-          commands_ptr = cmd.commands.has_value() ? &*cmd.commands : nullptr;
-          display_name += "-" + segment;
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
+      auto next = index.child(node, segment);
+      if (!next.has_value()) {
         throw std::runtime_error("subcommand not found: " + segment);
       }
+      node = *next;
+      prefix = prefix.empty() ? segment : prefix + "." + segment;
+      path_entries.push_back({index.resolve(root, node), prefix});
+      display_name += "-" + segment;
     }
 
     nlohmann::json defs = nlohmann::json::object();
@@ -326,4 +350,25 @@ namespace json_commander::config_schema {
     return schema;
   }
 
+  inline nlohmann::json
+  to_config_schema(
+    const model::Root& root, const std::vector<std::string>& command_path) {
+    if (command_path.empty()) { return to_config_schema(root); }
+    return to_config_schema(root, command_index::make(root), command_path);
+  }
+
+  // The schema a config file declared by model::Config must match: the
+  // argument properties of to_config_schema, with subcommands nested by
+  // name instead of selected by "command", and nothing required, since a
+  // file usually sets only a few values.
+  inline nlohmann::json
+  to_config_file_schema(const model::Root& root) {
+    auto schema = detail::generate_file_schema(
+      root.args.value_or(std::vector<model::Argument>{}),
+      root.commands.value_or(std::vector<model::Command>{}));
+    schema["$schema"] = "http://json-schema.org/draft-07/schema#";
+    schema["title"] = root.name + " configuration file";
+    return schema;
+  }
+
 } // namespace json_commander::config_schema
@@ -4,12 +4,29 @@
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cctype>
 #include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if !defined(__cpp_lib_to_chars)
+#include <locale>
+#include <sstream>
+#endif
+
 namespace json_commander::conv {
 
   class Error : public std::runtime_error {
@@ -18,225 +35,906 @@ namespace json_commander::conv {
         : std::runtime_error(message) {}
   };
 
+  using ParseFn = std::function<nlohmann::json(const std::string&)>;
+  using FormatFn = std::function<std::string(const nlohmann::json&)>;
+  // Non-throwing form of a custom converter's parse: the converted value,
+  // or nullopt with `error` set to the message parse would have thrown.
+  using TryParse = std::function<std::optional<nlohmann::json>(
+    const std::string&, std::string& error)>;
+
+  // What a converter does. The built-in kinds are plain data dispatched by
+  // try_convert and format; Custom runs the functions it was built with.
+  enum class Kind : std::uint8_t {
+    String,
+    Int,
+    Float,
+    Bool,
+    Enum,
+    File,
+    Dir,
+    Path,
+    Size,
+    Duration,
+    List,
+    Pair,
+    Triple,
+    Custom
+  };
+
+  // How a packed list stores its elements, and the subtype of the binary
+  // value it is delivered as: 8 bytes per element, contiguous, in native
+  // byte order.
+  enum class Packed : std::uint8_t { Int64 = 1, UInt64 = 2, Float64 = 3 };
+
+  // A converter is a kind, its metavariable and, for the kinds that need
+  // one, a shared immutable payload (choices, element converters, custom
+  // functions). Scalar converters own no memory beyond a short docv, and
+  // copying any converter only shares its payload.
   struct Converter {
-    std::function<nlohmann::json(const std::string&)> parse;
-    std::function<std::string(const nlohmann::json&)> format;
+    struct Payload;
+
+    Kind kind = Kind::String;
     std::string docv;
+    std::shared_ptr<const Payload> payload = {};
+
+    Converter() = default;
+
+    Converter(Kind kind, std::string docv)
+        : kind(kind), docv(std::move(docv)) {}
+
+    // A custom converter. Without a try_parse, try_convert catches what
+    // parse throws.
+    Converter(
+      ParseFn parse,
+      FormatFn format,
+      std::string docv,
+      TryParse try_parse = {});
+
+    // Throws conv::Error when `s` is rejected.
+    nlohmann::json
+    parse(const std::string& s) const;
+
+    std::string
+    format(const nlohmann::json& j) const;
+  };
+
+  struct Converter::Payload {
+    // Enum: the accepted values.
+    std::vector<std::string> choices = {};
+    // List, Pair, Triple: the element converters (one for List) and what
+    // separates their values.
+    std::vector<Converter> parts = {};
+    std::string separator = {};
+    std::size_t max_elements = 0;
+    // List: deliver the elements as one binary value (see Packed).
+    bool packed = false;
+    // Custom
+    ParseFn parse = {};
+    FormatFn format = {};
+    TryParse try_parse = {};
   };
 
+  inline Converter::Converter(
+    ParseFn parse, FormatFn format, std::string docv, TryParse try_parse)
+      : kind(Kind::Custom), docv(std::move(docv)),
+        payload(std::make_shared<const Payload>(Payload{
+          .parse = std::move(parse),
+          .format = std::move(format),
+          .try_parse = std::move(try_parse)})) {}
+
+  // -------------------------------------------------------------------------
+  // Detail: conversion kernels
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // Reads a number spanning all of `s` with std::from_chars: no locale,
+    // no exceptions. Returns std::errc::invalid_argument when `s` is not
+    // one number of type T, std::errc::result_out_of_range when it does not
+    // fit, and std::errc{} with `value` set otherwise.
+    template <class T>
+    std::errc
+    from_chars_all(std::string_view s, T& value) {
+      const auto* end = s.data() + s.size();
+      if constexpr (std::is_floating_point_v<T>) {
+        // strtod took a leading '+'; from_chars does not.
+        if (s.size() > 1 && s[0] == '+' && s[1] != '-' && s[1] != '+') {
+          s.remove_prefix(1);
+        }
+#if defined(__cpp_lib_to_chars)
+        auto [ptr, ec] = std::from_chars(s.data(), end, value);
+        if (ec == std::errc{} && ptr != end) {
+          return std::errc::invalid_argument;
+        }
+        return ec;
+#else
+        // Without floating-point from_chars, a stream in the classic
+        // locale reads the same syntax.
+        std::istringstream in{std::string(s)};
+        in.imbue(std::locale::classic());
+        in >> std::noskipws >> value;
+        if (in.fail()) {
+          return value == 0 ? std::errc::invalid_argument
+                            : std::errc::result_out_of_range;
+        }
+        return in.peek() == EOF ? std::errc{} : std::errc::invalid_argument;
+#endif
+      } else {
+        auto [ptr, ec] = std::from_chars(s.data(), end, value);
+        if (ec == std::errc{} && ptr != end) {
+          return std::errc::invalid_argument;
+        }
+        return ec;
+      }
+    }
+
+    // The numeric kernels read one value of their type from `s` into
+    // `value`, or return false with `error` set. They take views, so list
+    // elements are read where they are, without copies.
+
+    inline bool
+    read_int(std::string_view s, std::int64_t& value, std::string& error) {
+      if (s.empty()) {
+        error = "expected integer, got empty string";
+        return false;
+      }
+      auto ec = from_chars_all(s, value);
+      if (ec == std::errc::result_out_of_range) {
+        error = "integer out of range: '" + std::string(s) + "'";
+        return false;
+      }
+      if (ec != std::errc{}) {
+        error = "expected integer, got '" + std::string(s) + "'";
+        return false;
+      }
+      return true;
+    }
+
+    inline bool
+    read_uint(std::string_view s, std::uint64_t& value, std::string& error) {
+      if (s.empty()) {
+        error = "expected integer, got empty string";
+        return false;
+      }
+      auto ec = from_chars_all(s, value);
+      if (ec == std::errc::result_out_of_range) {
+        error = "integer out of range: '" + std::string(s) + "'";
+        return false;
+      }
+      if (ec != std::errc{}) {
+        error = "expected integer, got '" + std::string(s) + "'";
+        return false;
+      }
+      return true;
+    }
+
+    inline bool
+    read_float(std::string_view s, double& value, std::string& error) {
+      if (s.empty()) {
+        error = "expected float, got empty string";
+        return false;
+      }
+      auto ec = from_chars_all(s, value);
+      if (ec == std::errc::result_out_of_range) {
+        error = "float value out of range: '" + std::string(s) + "'";
+        return false;
+      }
+      if (ec != std::errc{}) {
+        error = "expected float, got '" + std::string(s) + "'";
+        return false;
+      }
+      return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Sizes and durations
+    // -----------------------------------------------------------------------
+
+    // An unsigned decimal such as "1.5": its whole part and up to 18
+    // fraction digits.
+    struct Decimal {
+      std::uint64_t whole = 0;
+      std::uint64_t fraction = 0;
+      int digits = 0;
+    };
+
+    // Reads `s` as a Decimal; nullopt if it is not one or the whole part
+    // does not fit. Fraction digits beyond the 18th are dropped.
+    inline std::optional<Decimal>
+    read_decimal(std::string_view s) {
+      auto dot = s.find('.');
+      auto whole = s.substr(0, dot);
+      auto fraction = dot == std::string_view::npos ? std::string_view{}
+                                                    : s.substr(dot + 1);
+      if (whole.empty() && fraction.empty()) { return std::nullopt; }
+      Decimal d;
+      if (!whole.empty()) {
+        if (whole[0] == '+' || whole[0] == '-') { return std::nullopt; }
+        if (from_chars_all(whole, d.whole) != std::errc{}) {
+          return std::nullopt;
+        }
+      }
+      for (char c : fraction) {
+        if (c < '0' || c > '9') { return std::nullopt; }
+        if (d.digits == 18) { continue; }
+        d.fraction = d.fraction * 10 + static_cast<std::uint64_t>(c - '0');
+        ++d.digits;
+      }
+      return d;
+    }
+
+    // `d` times `unit`, truncated to a whole number; nullopt above `limit`.
+    inline std::optional<std::uint64_t>
+    scale(const Decimal& d, std::uint64_t unit, std::uint64_t limit) {
+      if (d.whole > limit / unit) { return std::nullopt; }
+      auto value = d.whole * unit;
+      auto part = static_cast<std::uint64_t>(
+        static_cast<double>(d.fraction) / std::pow(10.0, d.digits) *
+        static_cast<double>(unit));
+      if (part > limit - value) { return std::nullopt; }
+      return value + part;
+    }
+
+    // Bytes in "4K", "1.5G", "512" or "10MiB": a decimal and an optional
+    // binary unit, any case: K, M, G, T, P or E (1024 to 1024^6), with or
+    // without a trailing "B" or "iB"; "B" alone is bytes. Fractions of a
+    // byte are dropped.
+    inline bool
+    read_size(std::string_view s, std::uint64_t& value, std::string& error) {
+      auto end = std::min(s.find_first_not_of("0123456789."), s.size());
+      auto number = read_decimal(s.substr(0, end));
+      std::string unit(s.substr(end));
+      std::transform(
+        unit.begin(), unit.end(), unit.begin(), [](unsigned char c) {
+          return static_cast<char>(std::tolower(c));
+        });
+      if (unit.size() > 1 && unit.ends_with('b')) { unit.pop_back(); }
+      if (unit.size() == 2 && unit.ends_with('i')) { unit.pop_back(); }
+      // Index n stands for 1024^n.
+      static constexpr std::string_view units = "bkmgtpe";
+      auto power = unit.empty()       ? 0
+                   : unit.size() == 1 ? units.find(unit[0])
+                                      : std::string_view::npos;
+      if (!number.has_value() || power == std::string_view::npos) {
+        error = "expected size, got '" + std::string(s) + "'";
+        return false;
+      }
+      auto bytes = scale(
+        *number,
+        std::uint64_t{1} << (10 * power),
+        std::numeric_limits<std::uint64_t>::max());
+      if (!bytes.has_value()) {
+        error = "size out of range: '" + std::string(s) + "'";
+        return false;
+      }
+      value = *bytes;
+      return true;
+    }
+
+    struct DurationUnit {
+      std::string_view name;
+      std::int64_t milliseconds;
+    };
+
+    // Largest first, as format writes them.
+    inline constexpr std::array<DurationUnit, 5> duration_units = {{
+      {"d", 86400000},
+      {"h", 3600000},
+      {"m", 60000},
+      {"s", 1000},
+      {"ms", 1},
+    }};
+
+    // Milliseconds in "250ms", "2h" or "1h30m": one or more decimals, each
+    // with a unit (d, h, m, s, ms). "0" needs none. Fractions of a
+    // millisecond are dropped.
+    inline bool
+    read_duration(
+      std::string_view s, std::int64_t& value, std::string& error) {
+      if (s == "0") {
+        value = 0;
+        return true;
+      }
+      const auto limit =
+        static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+      std::uint64_t total = 0;
+      std::string_view rest = s;
+      bool valid = !rest.empty();
+      while (valid && !rest.empty()) {
+        constexpr std::string_view digits = "0123456789.";
+        auto at = std::min(rest.find_first_not_of(digits), rest.size());
+        auto next = std::min(rest.find_first_of(digits, at), rest.size());
+        auto number = read_decimal(rest.substr(0, at));
+        auto name = rest.substr(at, next - at);
+        rest.remove_prefix(next);
+        const DurationUnit* unit = nullptr;
+        for (const auto& u : duration_units) {
+          if (u.name == name) { unit = &u; }
+        }
+        valid = number.has_value() && unit != nullptr;
+        if (!valid) { break; }
+        auto ms = static_cast<std::uint64_t>(unit->milliseconds);
+        auto part = scale(*number, ms, limit);
+        if (!part.has_value() || *part > limit - total) {
+          error = "duration out of range: '" + std::string(s) + "'";
+          return false;
+        }
+        total += *part;
+      }
+      if (!valid) {
+        error = "expected duration, got '" + std::string(s) + "'";
+        return false;
+      }
+      value = static_cast<std::int64_t>(total);
+      return true;
+    }
+
+    // Milliseconds as read_duration reads them, largest units first:
+    // 5400000 is "1h30m", 250 is "250ms".
+    inline std::string
+    format_duration(std::int64_t milliseconds) {
+      if (milliseconds == 0) { return "0s"; }
+      std::string out;
+      if (milliseconds < 0) {
+        out = "-";
+        milliseconds = -milliseconds;
+      }
+      for (const auto& unit : duration_units) {
+        if (milliseconds < unit.milliseconds) { continue; }
+        out += std::to_string(milliseconds / unit.milliseconds);
+        out += unit.name;
+        milliseconds %= unit.milliseconds;
+      }
+      return out;
+    }
+
+    inline bool
+    equals_ignoring_case(std::string_view s, std::string_view lower) {
+      return std::equal(
+        s.begin(), s.end(), lower.begin(), lower.end(), [](char a, char b) {
+          return std::tolower(static_cast<unsigned char>(a)) == b;
+        });
+    }
+
+    inline std::optional<nlohmann::json>
+    parse_bool(std::string_view s, std::string& error) {
+      if (equals_ignoring_case(s, "true")) return true;
+      if (equals_ignoring_case(s, "false")) return false;
+      error = "expected 'true' or 'false', got '" + std::string(s) + "'";
+      return std::nullopt;
+    }
+
+    inline std::optional<nlohmann::json>
+    parse_enum(
+      const std::vector<std::string>& choices,
+      std::string_view s,
+      std::string& error) {
+      for (const auto& c : choices) {
+        if (c == s) return c;
+      }
+      error = "invalid choice '" + std::string(s) + "', expected one of:";
+      for (const auto& c : choices) {
+        error += " " + c;
+      }
+      return std::nullopt;
+    }
+
+    // A numeric kernel as a conversion of one value.
+    template <class T>
+    std::optional<nlohmann::json>
+    parse_number(
+      bool (*read)(std::string_view, T&, std::string&),
+      std::string_view s,
+      std::string& error) {
+      T value{};
+      if (!read(s, value, error)) { return std::nullopt; }
+      return value;
+    }
+
+    // An int value: int64, or uint64 for a positive one too large for
+    // int64, since JSON integers have room for both.
+    inline std::optional<nlohmann::json>
+    parse_integer(std::string_view s, std::string& error) {
+      std::int64_t value = 0;
+      if (read_int(s, value, error)) { return value; }
+      std::uint64_t large = 0;
+      std::string unsigned_error;
+      if (!s.starts_with('-') && read_uint(s, large, unsigned_error)) {
+        error.clear();
+        return large;
+      }
+      return std::nullopt;
+    }
+
+    // -----------------------------------------------------------------------
+    // Lists
+    // -----------------------------------------------------------------------
+
+    // How many parts `sep` splits a non-empty `s` into.
+    inline std::size_t
+    count_parts(std::string_view s, std::string_view sep) {
+      if (sep.size() == 1) {
+        auto found = std::count(s.begin(), s.end(), sep[0]);
+        return static_cast<std::size_t>(found) + 1;
+      }
+      std::size_t count = 1;
+      for (auto pos = s.find(sep); pos != std::string_view::npos;
+           pos = s.find(sep, pos + sep.size())) {
+        ++count;
+      }
+      return count;
+    }
+
+    // Calls `visit` with each part `sep` splits a non-empty `s` into, as a
+    // view into `s`, until it returns false. A one-character separator,
+    // by far the most common, is searched for with memchr, which the C
+    // library vectorizes. Returns false if `visit` stopped early.
+    template <class Visit>
+    bool
+    for_each_part(std::string_view s, std::string_view sep, Visit visit) {
+      if (sep.size() == 1) {
+        const char* begin = s.data();
+        const char* end = begin + s.size();
+        for (;;) {
+          const auto* hit = static_cast<const char*>(
+            std::memchr(begin, sep[0], static_cast<std::size_t>(end - begin)));
+          if (hit == nullptr) { return visit(std::string_view(begin, end)); }
+          if (!visit(std::string_view(begin, hit))) { return false; }
+          begin = hit + 1;
+        }
+      }
+      std::size_t start = 0;
+      for (;;) {
+        auto pos = s.find(sep, start);
+        if (pos == std::string_view::npos) { return visit(s.substr(start)); }
+        if (!visit(s.substr(start, pos - start))) { return false; }
+        start = pos + sep.size();
+      }
+    }
+
+    // The packed form of lists of `element`, if it has one.
+    inline std::optional<Packed>
+    packed_type(Kind element) {
+      switch (element) {
+        case Kind::Int:
+        case Kind::Duration:
+          return Packed::Int64;
+        case Kind::Size:
+          return Packed::UInt64;
+        case Kind::Float:
+          return Packed::Float64;
+        default:
+          return std::nullopt;
+      }
+    }
+
+    template <class T>
+    constexpr Packed
+    packed_as() {
+      if constexpr (std::is_floating_point_v<T>) {
+        return Packed::Float64;
+      } else if constexpr (std::is_unsigned_v<T>) {
+        return Packed::UInt64;
+      } else {
+        return Packed::Int64;
+      }
+    }
+
+    template <class T>
+    nlohmann::json
+    to_binary(std::vector<std::uint8_t> bytes) {
+      return nlohmann::json::binary(
+        std::move(bytes), static_cast<std::uint8_t>(packed_as<T>()));
+    }
+
+    // Reads every part of a list of numbers into one contiguous buffer of
+    // `count` values, then converts the buffer in a single step, instead of
+    // building a JSON value per part as it goes. With `packed`, the buffer
+    // is the result.
+    template <class T>
+    std::optional<nlohmann::json>
+    parse_numbers(
+      bool (*read)(std::string_view, T&, std::string&),
+      std::string_view s,
+      std::string_view sep,
+      std::size_t count,
+      bool packed,
+      std::string& error) {
+      if (packed) {
+        std::vector<std::uint8_t> bytes(count * sizeof(T));
+        auto* out = bytes.data();
+        bool complete = for_each_part(s, sep, [&](std::string_view part) {
+          T value{};
+          if (!read(part, value, error)) { return false; }
+          std::memcpy(out, &value, sizeof value);
+          out += sizeof value;
+          return true;
+        });
+        if (!complete) { return std::nullopt; }
+        return to_binary<T>(std::move(bytes));
+      }
+      std::vector<T> values;
+      values.reserve(count);
+      bool complete = for_each_part(s, sep, [&](std::string_view part) {
+        T value{};
+        if (!read(part, value, error)) { return false; }
+        values.push_back(value);
+        return true;
+      });
+      if (!complete) { return std::nullopt; }
+      return nlohmann::json(values);
+    }
+
+    // Splits a pair or triple into exactly `count` parts: every separator
+    // but the last part's is taken from the left, so the last part may
+    // contain more of them. Returns nullopt when there are too few.
+    inline std::optional<std::vector<std::string_view>>
+    split_tuple(std::string_view s, std::string_view sep, std::size_t count) {
+      std::vector<std::string_view> parts;
+      std::size_t start = 0;
+      while (parts.size() + 1 < count) {
+        auto pos = s.find(sep, start);
+        if (pos == std::string_view::npos) { return std::nullopt; }
+        parts.push_back(s.substr(start, pos - start));
+        start = pos + sep.size();
+      }
+      parts.push_back(s.substr(start));
+      return parts;
+    }
+
+    template <class T>
+    nlohmann::json
+    pack_array(const nlohmann::json& array) {
+      std::vector<std::uint8_t> bytes(array.size() * sizeof(T));
+      auto* out = bytes.data();
+      for (const auto& element : array) {
+        if (!element.is_number()) { return array; }
+        auto value = element.get<T>();
+        std::memcpy(out, &value, sizeof value);
+        out += sizeof value;
+      }
+      return to_binary<T>(std::move(bytes));
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Packed lists
+  // -------------------------------------------------------------------------
+
+  // Whether `c` converts to packed lists: a list converter built with
+  // `packed` whose elements are numbers.
+  inline bool
+  is_packed(const Converter& c) {
+    return c.kind == Kind::List && c.payload->packed;
+  }
+
+  // `value`, given for a list `c` converts as a JSON array of numbers (a
+  // default, or a config file value), in the form try_convert gives: packed
+  // when `c` packs. Anything else is returned as it is.
+  inline nlohmann::json
+  pack(const Converter& c, nlohmann::json value) {
+    if (!is_packed(c) || !value.is_array()) { return value; }
+    switch (*detail::packed_type(c.payload->parts[0].kind)) {
+      case Packed::Int64:
+        return detail::pack_array<std::int64_t>(value);
+      case Packed::UInt64:
+        return detail::pack_array<std::uint64_t>(value);
+      case Packed::Float64:
+        return detail::pack_array<double>(value);
+    }
+    return value;
+  }
+
+  // The elements of a packed list as T (std::int64_t, std::uint64_t or
+  // double, as its Packed type says), copied out with one memcpy. Throws
+  // conv::Error if `value` is not a packed list of T.
+  template <class T>
+  std::vector<T>
+  unpack(const nlohmann::json& value) {
+    if (
+      !value.is_binary() || !value.get_binary().has_subtype() ||
+      value.get_binary().subtype() !=
+        static_cast<std::uint8_t>(detail::packed_as<T>())) {
+      throw Error("not a packed list of the requested type");
+    }
+    const auto& bytes = value.get_binary();
+    std::vector<T> values(bytes.size() / sizeof(T));
+    if (!values.empty()) {
+      std::memcpy(values.data(), bytes.data(), values.size() * sizeof(T));
+    }
+    return values;
+  }
+
+  // `value` with each packed list in it, at any depth, replaced by the
+  // array of numbers it holds: for text output, where binary values have
+  // no natural form.
+  inline nlohmann::json
+  unpack_all(nlohmann::json value) {
+    if (value.is_structured()) {
+      for (auto& element : value) {
+        element = unpack_all(std::move(element));
+      }
+      return value;
+    }
+    if (!value.is_binary() || !value.get_binary().has_subtype()) {
+      return value;
+    }
+    switch (static_cast<Packed>(value.get_binary().subtype())) {
+      case Packed::Int64:
+        return unpack<std::int64_t>(value);
+      case Packed::UInt64:
+        return unpack<std::uint64_t>(value);
+      case Packed::Float64:
+        return unpack<double>(value);
+    }
+    return value;
+  }
+
+  // -------------------------------------------------------------------------
+  // Conversion
+  // -------------------------------------------------------------------------
+
+  // Converts `s` without throwing conv::Error. Custom converters without a
+  // try_parse fall back to parse, with the exception caught here. Only
+  // custom converters get a copy of `s`; the built-in kinds read it in
+  // place, so converting allocates no more than the value produced.
+  inline std::optional<nlohmann::json>
+  try_convert(const Converter& c, std::string_view s, std::string& error) {
+    switch (c.kind) {
+      case Kind::String:
+      case Kind::File:
+      case Kind::Dir:
+      case Kind::Path:
+        return nlohmann::json(s);
+      case Kind::Int:
+        return detail::parse_integer(s, error);
+      case Kind::Float:
+        return detail::parse_number(detail::read_float, s, error);
+      case Kind::Bool:
+        return detail::parse_bool(s, error);
+      case Kind::Size:
+        return detail::parse_number(detail::read_size, s, error);
+      case Kind::Duration:
+        return detail::parse_number(detail::read_duration, s, error);
+      case Kind::Enum:
+        return detail::parse_enum(c.payload->choices, s, error);
+      case Kind::List: {
+        const auto& p = *c.payload;
+        if (s.empty()) return pack(c, nlohmann::json::array());
+        auto count = detail::count_parts(s, p.separator);
+        if (count > p.max_elements) {
+          error = "list exceeds maximum element count (" +
+                  std::to_string(p.max_elements) + ")";
+          return std::nullopt;
+        }
+        switch (p.parts[0].kind) {
+          case Kind::Int:
+            return detail::parse_numbers(
+              detail::read_int, s, p.separator, count, p.packed, error);
+          case Kind::Float:
+            return detail::parse_numbers(
+              detail::read_float, s, p.separator, count, p.packed, error);
+          case Kind::Size:
+            return detail::parse_numbers(
+              detail::read_size, s, p.separator, count, p.packed, error);
+          case Kind::Duration:
+            return detail::parse_numbers(
+              detail::read_duration, s, p.separator, count, p.packed, error);
+          default:
+            break;
+        }
+        auto result = nlohmann::json::array();
+        bool complete =
+          detail::for_each_part(s, p.separator, [&](std::string_view part) {
+            auto value = try_convert(p.parts[0], part, error);
+            if (!value.has_value()) { return false; }
+            result.push_back(std::move(*value));
+            return true;
+          });
+        if (!complete) { return std::nullopt; }
+        return result;
+      }
+      case Kind::Pair:
+      case Kind::Triple: {
+        const auto& p = *c.payload;
+        auto parts = detail::split_tuple(s, p.separator, p.parts.size());
+        if (!parts.has_value()) {
+          const char* what = c.kind == Kind::Pair ? "pair" : "triple";
+          error = std::string("expected ") + what + " separated by '" +
+                  p.separator + "', got '" + std::string(s) + "'";
+          return std::nullopt;
+        }
+        auto result = nlohmann::json::array();
+        for (std::size_t i = 0; i < parts->size(); ++i) {
+          auto value = try_convert(p.parts[i], (*parts)[i], error);
+          if (!value.has_value()) { return std::nullopt; }
+          result.push_back(std::move(*value));
+        }
+        return result;
+      }
+      case Kind::Custom: {
+        std::string text(s);
+        if (c.payload->try_parse) { return c.payload->try_parse(text, error); }
+        try {
+          return c.payload->parse(text);
+        } catch (const Error& e) {
+          error = e.what();
+          return std::nullopt;
+        }
+      }
+    }
+    return nlohmann::json(s);
+  }
+
+  inline nlohmann::json
+  Converter::parse(const std::string& s) const {
+    if (kind == Kind::Custom && !payload->try_parse) {
+      return payload->parse(s);
+    }
+    std::string error;
+    auto value = try_convert(*this, s, error);
+    if (!value.has_value()) { throw Error(error); }
+    return std::move(*value);
+  }
+
+  inline std::string
+  Converter::format(const nlohmann::json& j) const {
+    switch (kind) {
+      case Kind::String:
+      case Kind::Enum:
+      case Kind::File:
+      case Kind::Dir:
+      case Kind::Path:
+        return j.get<std::string>();
+      case Kind::Int:
+        if (j.is_number_unsigned()) {
+          return std::to_string(j.get<std::uint64_t>());
+        }
+        return std::to_string(j.get<std::int64_t>());
+      case Kind::Size:
+        return std::to_string(j.get<std::uint64_t>());
+      case Kind::Duration:
+        return detail::format_duration(j.get<std::int64_t>());
+      case Kind::Float:
+        return j.dump();
+      case Kind::Bool:
+        return j.get<bool>() ? "true" : "false";
+      case Kind::List:
+      case Kind::Pair:
+      case Kind::Triple: {
+        if (j.is_binary()) { return format(unpack_all(j)); }
+        const auto& p = *payload;
+        std::string result;
+        for (std::size_t i = 0; i < j.size(); ++i) {
+          if (i > 0) result += p.separator;
+          const auto& part = kind == Kind::List ? p.parts[0] : p.parts[i];
+          result += part.format(j[i]);
+        }
+        return result;
+      }
+      case Kind::Custom:
+        return payload->format(j);
+    }
+    return j.dump();
+  }
+
   // -------------------------------------------------------------------------
   // Scalar converters
   // -------------------------------------------------------------------------
 
   inline Converter
   string_conv() {
-    return {
-      [](const std::string& s) -> nlohmann::json { return s; },
-      [](const nlohmann::json& j) -> std::string {
-        return j.get<std::string>();
-      },
-      "STRING",
-    };
+    return {Kind::String, "STRING"};
   }
 
   inline Converter
   int_conv() {
-    return {
-      [](const std::string& s) -> nlohmann::json {
-        if (s.empty()) { throw Error("expected integer, got empty string"); }
-        int value = 0;
-        auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
-        if (ec != std::errc{} || ptr != s.data() + s.size()) {
-          throw Error("expected integer, got '" + s + "'");
-        }
-        return value;
-      },
-      [](const nlohmann::json& j) -> std::string {
-        return std::to_string(j.get<int>());
-      },
-      "INT",
-    };
+    return {Kind::Int, "INT"};
   }
 
   inline Converter
   float_conv() {
-    return {
-      [](const std::string& s) -> nlohmann::json {
-        if (s.empty()) { throw Error("expected float, got empty string"); }
-        std::size_t pos = 0;
-        double value = 0;
-        try {
-          value = std::stod(s, &pos);
-        } catch (const std::invalid_argument&) {
-          throw Error("expected float, got '" + s + "'");
-        } catch (const std::out_of_range&) {
-          throw Error("float value out of range: '" + s + "'");
-        }
-        if (pos != s.size()) { throw Error("expected float, got '" + s + "'"); }
-        return value;
-      },
-      [](const nlohmann::json& j) -> std::string { return j.dump(); },
-      "FLOAT",
-    };
+    return {Kind::Float, "FLOAT"};
   }
 
   inline Converter
   bool_conv() {
-    return {
-      [](const std::string& s) -> nlohmann::json {
-        std::string lower = s;
-        std::transform(
-          lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
-            return std::tolower(c);
-          });
-        if (lower == "true") return true;
-        if (lower == "false") return false;
-        throw Error("expected 'true' or 'false', got '" + s + "'");
-      },
-      [](const nlohmann::json& j) -> std::string {
-        return j.get<bool>() ? "true" : "false";
-      },
-      "BOOL",
-    };
+    return {Kind::Bool, "BOOL"};
+  }
+
+  // Byte counts such as "4K" or "1.5G", as an unsigned integer.
+  inline Converter
+  size_conv() {
+    return {Kind::Size, "SIZE"};
+  }
+
+  // Durations such as "250ms" or "1h30m", as integer milliseconds.
+  inline Converter
+  duration_conv() {
+    return {Kind::Duration, "DURATION"};
   }
 
   inline Converter
   enum_conv(const std::vector<std::string>& choices) {
-    return {
-      [choices](const std::string& s) -> nlohmann::json {
-        for (const auto& c : choices) {
-          if (c == s) return s;
-        }
-        std::string msg = "invalid choice '" + s + "', expected one of:";
-        for (const auto& c : choices) {
-          msg += " " + c;
-        }
-        throw Error(msg);
-      },
-      [](const nlohmann::json& j) -> std::string {
-        return j.get<std::string>();
-      },
-      "ENUM",
-    };
+    Converter c{Kind::Enum, "ENUM"};
+    c.payload = std::make_shared<const Converter::Payload>(
+      Converter::Payload{.choices = choices});
+    return c;
   }
 
   inline Converter
   file_conv() {
-    return {
-      [](const std::string& s) -> nlohmann::json { return s; },
-      [](const nlohmann::json& j) -> std::string {
-        return j.get<std::string>();
-      },
-      "FILE",
-    };
+    return {Kind::File, "FILE"};
   }
 
   inline Converter
   dir_conv() {
-    return {
-      [](const std::string& s) -> nlohmann::json { return s; },
-      [](const nlohmann::json& j) -> std::string {
-        return j.get<std::string>();
-      },
-      "DIR",
-    };
+    return {Kind::Dir, "DIR"};
   }
 
   inline Converter
   path_conv() {
-    return {
-      [](const std::string& s) -> nlohmann::json { return s; },
-      [](const nlohmann::json& j) -> std::string {
-        return j.get<std::string>();
-      },
-      "PATH",
-    };
+    return {Kind::Path, "PATH"};
   }
 
   // -------------------------------------------------------------------------
-  // Detail: string splitting
+  // Compound converters
   // -------------------------------------------------------------------------
 
   namespace detail {
 
-    inline std::vector<std::string>
-    split(const std::string& s, const std::string& sep) {
-      if (s.empty()) return {};
-      std::vector<std::string> parts;
-      std::size_t start = 0;
-      while (true) {
-        auto pos = s.find(sep, start);
-        if (pos == std::string::npos) {
-          parts.push_back(s.substr(start));
-          break;
-        }
-        parts.push_back(s.substr(start, pos - start));
-        start = pos + sep.size();
-      }
-      return parts;
+    inline Converter
+    compound(
+      Kind kind,
+      std::string docv,
+      std::vector<Converter> parts,
+      const std::string& separator,
+      std::size_t max_elements = 0,
+      bool packed = false) {
+      Converter c{kind, std::move(docv)};
+      c.payload = std::make_shared<const Converter::Payload>(Converter::Payload{
+        .parts = std::move(parts),
+        .separator = separator,
+        .max_elements = max_elements,
+        .packed = packed});
+      return c;
     }
 
   } // namespace detail
 
-  // -------------------------------------------------------------------------
-  // Compound converters
-  // -------------------------------------------------------------------------
+  // How many elements a list takes unless its type sets max_elements.
+  inline constexpr std::size_t default_max_elements = 10000;
 
+  // With `packed`, lists of numbers (int, float, size, duration) convert
+  // to one binary value instead of an array; see conv::unpack. Lists of
+  // anything else stay arrays.
   inline Converter
   list_conv(
     Converter element,
     const std::string& separator = ",",
-    std::size_t max_elements = 10000) {
-    return {
-      [element, separator, max_elements](
-        const std::string& s) -> nlohmann::json {
-        if (s.empty()) return nlohmann::json::array();
-        auto parts = detail::split(s, separator);
-        if (parts.size() > max_elements) {
-          throw Error(
-            "list exceeds maximum element count (" +
-            std::to_string(max_elements) + ")");
-        }
-        auto result = nlohmann::json::array();
-        for (const auto& part : parts) {
-          result.push_back(element.parse(part));
-        }
-        return result;
-      },
-      [element, separator](const nlohmann::json& j) -> std::string {
-        std::string result;
-        for (std::size_t i = 0; i < j.size(); ++i) {
-          if (i > 0) result += separator;
-          result += element.format(j[i]);
-        }
-        return result;
-      },
-      element.docv + separator + "...",
-    };
+    std::size_t max_elements = default_max_elements,
+    bool packed = false) {
+    auto docv = element.docv + separator + "...";
+    packed = packed && detail::packed_type(element.kind).has_value();
+    return detail::compound(
+      Kind::List,
+      std::move(docv),
+      {std::move(element)},
+      separator,
+      max_elements,
+      packed);
   }
 
   inline Converter
   pair_conv(
     Converter first, Converter second, const std::string& separator = ",") {
-    return {
-      [first, second, separator](const std::string& s) -> nlohmann::json {
-        auto pos = s.find(separator);
-        if (pos == std::string::npos) {
-          throw Error(
-            "expected pair separated by '" + separator + "', got '" + s + "'");
-        }
-        auto a = s.substr(0, pos);
-        auto b = s.substr(pos + separator.size());
-        auto result = nlohmann::json::array();
-        result.push_back(first.parse(a));
-        result.push_back(second.parse(b));
-        return result;
-      },
-      [first, second, separator](const nlohmann::json& j) -> std::string {
-        return first.format(j[0]) + separator + second.format(j[1]);
-      },
-      first.docv + separator + second.docv,
-    };
+    auto docv = first.docv + separator + second.docv;
+    return detail::compound(
+      Kind::Pair,
+      std::move(docv),
+      {std::move(first), std::move(second)},
+      separator);
   }
 
   inline Converter
@@ -245,38 +943,13 @@ namespace json_commander::conv {
     Converter second,
     Converter third,
     const std::string& separator = ",") {
-    return {
-      [first, second, third, separator](
-        const std::string& s) -> nlohmann::json {
-        auto pos1 = s.find(separator);
-        if (pos1 == std::string::npos) {
-          throw Error(
-            "expected triple separated by '" + separator + "', got '" + s +
-            "'");
-        }
-        auto pos2 = s.find(separator, pos1 + separator.size());
-        if (pos2 == std::string::npos) {
-          throw Error(
-            "expected triple separated by '" + separator + "', got '" + s +
-            "'");
-        }
-        auto a = s.substr(0, pos1);
-        auto b =
-          s.substr(pos1 + separator.size(), pos2 - pos1 - separator.size());
-        auto c = s.substr(pos2 + separator.size());
-        auto result = nlohmann::json::array();
-        result.push_back(first.parse(a));
-        result.push_back(second.parse(b));
-        result.push_back(third.parse(c));
-        return result;
-      },
-      [first, second, third, separator](
-        const nlohmann::json& j) -> std::string {
-        return first.format(j[0]) + separator + second.format(j[1]) +
-               separator + third.format(j[2]);
-      },
-      first.docv + separator + second.docv + separator + third.docv,
-    };
+    auto docv =
+      first.docv + separator + second.docv + separator + third.docv;
+    return detail::compound(
+      Kind::Triple,
+      std::move(docv),
+      {std::move(first), std::move(second), std::move(third)},
+      separator);
   }
 
   // -------------------------------------------------------------------------
@@ -302,6 +975,10 @@ namespace json_commander::conv {
         return dir_conv();
       case model::ScalarType::Path:
         return path_conv();
+      case model::ScalarType::Size:
+        return size_conv();
+      case model::ScalarType::Duration:
+        return duration_conv();
     }
     return string_conv();
   }
@@ -320,7 +997,11 @@ namespace json_commander::conv {
           return make(t);
         } else if constexpr (std::is_same_v<T, model::ListType>) {
           auto sep = t.separator.value_or(",");
-          return list_conv(make(t.element), sep);
+          return list_conv(
+            make(t.element),
+            sep,
+            t.max_elements.value_or(default_max_elements),
+            t.packed.value_or(false));
         } else if constexpr (std::is_same_v<T, model::PairType>) {
           auto sep = t.separator.value_or(",");
           return pair_conv(make(t.first), make(t.second), sep);
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <json_commander/config_cache.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace json_commander::handoff {
+
+  class Error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  // The environment variable holding the number of the inherited descriptor.
+  inline constexpr const char* fd_variable = "JCMD_CONFIG_FD";
+
+  // What one process hands the program it execs: a parsed config, the
+  // name of the CLI it was parsed against and a digest of the arguments it
+  // was parsed from, so neither an unrelated program further down the
+  // chain nor the same one run with other arguments takes it for its own.
+  // The command path lets the receiver tell what the config is for, e.g.
+  // whether that command reads values from stdin.
+  struct Payload {
+    std::string program;
+    nlohmann::json config;
+    std::uint64_t args = 0;
+    std::vector<std::string> command_path = {};
+    bool
+    operator==(const Payload&) const = default;
+  };
+
+  // The digest of `args`, the arguments after argv[0], for Payload::args.
+  inline std::uint64_t
+  digest(const std::vector<std::string>& args) {
+    auto h = config_cache::detail::fnv1a(std::to_string(args.size()));
+    for (const auto& arg : args) {
+      // Length-prefixed, so {"ab", "c"} and {"a", "bc"} differ.
+      h = config_cache::detail::fnv1a(std::to_string(arg.size()) + ':', h);
+      h = config_cache::detail::fnv1a(arg, h);
+    }
+    return h;
+  }
+
+  inline std::uint64_t
+  digest(int argc, const char* const* argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+      args.emplace_back(argv[i]);
+    }
+    return digest(args);
+  }
+
+  // -------------------------------------------------------------------------
+  // Detail: encoding
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // The payload as CBOR: compact, and decoded without a text parser.
+    // Malformed input decodes to an error rather than an exception. Packed
+    // lists travel as tagged byte strings, so tags are kept.
+    inline std::vector<std::uint8_t>
+    encode(const Payload& payload) {
+      return nlohmann::json::to_cbor(
+        {{"program", payload.program},
+         {"config", payload.config},
+         {"args", payload.args},
+         {"command_path", payload.command_path}});
+    }
+
+    inline std::optional<Payload>
+    decode(const std::vector<std::uint8_t>& bytes, std::string& error) {
+      auto j = nlohmann::json::from_cbor(
+        bytes, true, false, nlohmann::json::cbor_tag_handler_t::store);
+      if (
+        !j.is_object() || !j.contains("program") ||
+        !j["program"].is_string() || !j.contains("config") ||
+        !j.contains("args") || !j["args"].is_number_unsigned() ||
+        !j.contains("command_path") || !j["command_path"].is_array()) {
+        error = "malformed config payload";
+        return std::nullopt;
+      }
+      std::vector<std::string> path;
+      for (const auto& name : j["command_path"]) {
+        if (!name.is_string()) {
+          error = "malformed config payload";
+          return std::nullopt;
+        }
+        path.push_back(name.get<std::string>());
+      }
+      return Payload{
+        j["program"].get<std::string>(),
+        std::move(j["config"]),
+        j["args"].get<std::uint64_t>(),
+        std::move(path)};
+    }
+
+#ifndef _WIN32
+    inline std::string
+    last_error() {
+      return std::generic_category().message(errno);
+    }
+
+    inline bool
+    write_all(int fd, const std::vector<std::uint8_t>& bytes) {
+      std::size_t done = 0;
+      while (done < bytes.size()) {
+        auto n = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return false; }
+        done += static_cast<std::size_t>(n);
+      }
+      return true;
+    }
+
+#ifdef __linux__
+    // An anonymous memory file, sealed so neither side can change it once
+    // written. Returns -1 where memfd_create is unavailable.
+    inline int
+    sealed_memfd(const std::vector<std::uint8_t>& bytes) {
+      int fd = ::memfd_create("jcmd-config", MFD_ALLOW_SEALING);
+      if (fd < 0) { return -1; }
+      if (
+        !write_all(fd, bytes) ||
+        ::fcntl(
+          fd,
+          F_ADD_SEALS,
+          F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        auto saved = errno;
+        ::close(fd);
+        errno = saved;
+        throw Error("sealing config: " + last_error());
+      }
+      return fd;
+    }
+#endif
+
+    // Elsewhere: a temporary file, reopened read-only and unlinked, so only
+    // the descriptor refers to it.
+    inline int
+    read_only_temp(const std::vector<std::uint8_t>& bytes) {
+      auto pattern = (std::filesystem::temp_directory_path() /
+                      "jcmd-config-XXXXXX")
+                       .string();
+      int out = ::mkstemp(pattern.data());
+      if (out < 0) { throw Error("creating config file: " + last_error()); }
+      int fd = write_all(out, bytes) ? ::open(pattern.c_str(), O_RDONLY) : -1;
+      auto saved = errno;
+      ::unlink(pattern.c_str());
+      ::close(out);
+      if (fd < 0) {
+        errno = saved;
+        throw Error("writing config file: " + last_error());
+      }
+      return fd;
+    }
+
+    // The whole contents of `fd`, read from the start whatever its offset.
+    inline bool
+    read_all(int fd, std::vector<std::uint8_t>& bytes, std::string& error) {
+      struct stat st{};
+      if (::fstat(fd, &st) != 0) {
+        error = last_error();
+        return false;
+      }
+      bytes.resize(static_cast<std::size_t>(st.st_size));
+      std::size_t done = 0;
+      while (done < bytes.size()) {
+        auto n = ::pread(
+          fd,
+          bytes.data() + done,
+          bytes.size() - done,
+          static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) {
+          error = n < 0 ? last_error() : "unexpected end of file";
+          return false;
+        }
+        done += static_cast<std::size_t>(n);
+      }
+      return true;
+    }
+#endif
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Sending
+  // -------------------------------------------------------------------------
+
+  // Writes `payload` to a read-only descriptor that survives exec: a sealed
+  // memfd on Linux, an unlinked temporary file elsewhere. Throws
+  // handoff::Error on failure; not supported on Windows.
+  inline int
+  share([[maybe_unused]] const Payload& payload) {
+#ifdef _WIN32
+    throw Error("handing off a config is not supported on Windows");
+#else
+    auto bytes = detail::encode(payload);
+#ifdef __linux__
+    if (int fd = detail::sealed_memfd(bytes); fd >= 0) { return fd; }
+#endif
+    return detail::read_only_temp(bytes);
+#endif
+  }
+
+  // Replaces this process with `argv[0]`, looked up on PATH, with `payload`
+  // shared and its descriptor named in JCMD_CONFIG_FD. The payload's args
+  // are set to the digest of `argv`, which the config must have been parsed
+  // from. Returns only by throwing handoff::Error.
+  [[noreturn]] inline void
+  exec(
+    [[maybe_unused]] const Payload& payload,
+    const std::vector<std::string>& argv) {
+    if (argv.empty()) { throw Error("exec: no program given"); }
+#ifdef _WIN32
+    throw Error("exec is not supported on Windows");
+#else
+    auto shared = payload;
+    shared.args = digest({argv.begin() + 1, argv.end()});
+    int fd = share(shared);
+    auto number = std::to_string(fd);
+    std::vector<char*> args;
+    for (const auto& a : argv) {
+      args.push_back(const_cast<char*>(a.c_str()));
+    }
+    args.push_back(nullptr);
+    ::setenv(fd_variable, number.c_str(), 1);
+    ::execvp(args[0], args.data());
+    auto message = detail::last_error();
+    ::unsetenv(fd_variable);
+    ::close(fd);
+    throw Error(argv[0] + ": " + message);
+#endif
+  }
+
+  // -------------------------------------------------------------------------
+  // Receiving
+  // -------------------------------------------------------------------------
+
+  // Takes the config handed to this process for `program` run with `argv`
+  // (argv[0] excluded from the comparison). Returns nullopt with `error`
+  // empty when there is none, or when it is meant for another program or
+  // other arguments. Returns nullopt with `error` set when JCMD_CONFIG_FD
+  // does not name a readable payload; standard streams (0 to 2) never
+  // count as one. Either way JCMD_CONFIG_FD is removed, so this process's
+  // children do not inherit a number that may since have been closed or
+  // reused, and a descriptor that did hold a payload is closed.
+  inline std::optional<Payload>
+  try_receive_payload(
+    [[maybe_unused]] std::string_view program,
+    [[maybe_unused]] int argc,
+    [[maybe_unused]] const char* const* argv,
+    std::string& error) {
+    error.clear();
+#ifdef _WIN32
+    return std::nullopt;
+#else
+    const char* value = std::getenv(fd_variable);
+    if (value == nullptr) { return std::nullopt; }
+    std::string text = value;
+    ::unsetenv(fd_variable);
+    const char* last = text.data() + text.size();
+    int fd = -1;
+    auto [end, ec] = std::from_chars(text.data(), last, fd);
+    if (ec != std::errc() || end != last || fd <= STDERR_FILENO) {
+      error = std::string(fd_variable) + ": not a descriptor: " + text;
+      return std::nullopt;
+    }
+    std::vector<std::uint8_t> bytes;
+    if (!detail::read_all(fd, bytes, error)) {
+      error = std::string(fd_variable) + ": " + error;
+      return std::nullopt;
+    }
+    auto payload = detail::decode(bytes, error);
+    if (!payload.has_value()) {
+      error = std::string(fd_variable) + ": " + error;
+      return std::nullopt;
+    }
+    ::close(fd);
+    if (payload->program != program || payload->args != digest(argc, argv)) {
+      return std::nullopt;
+    }
+    return payload;
+#endif
+  }
+
+  // try_receive_payload, for callers that only need the config.
+  inline std::optional<nlohmann::json>
+  try_receive(
+    std::string_view program,
+    int argc,
+    const char* const* argv,
+    std::string& error) {
+    auto payload = try_receive_payload(program, argc, argv, error);
+    if (!payload.has_value()) { return std::nullopt; }
+    return std::move(payload->config);
+  }
+
+  // Throws handoff::Error where try_receive sets `error`.
+  inline std::optional<nlohmann::json>
+  receive(std::string_view program, int argc, const char* const* argv) {
+    std::string error;
+    auto config = try_receive(program, argc, argv, error);
+    if (!error.empty()) { throw Error(error); }
+    return config;
+  }
+
+} // namespace json_commander::handoff
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <json_commander/cmd.hpp>
+#include <json_commander/command_index.hpp>
+#include <json_commander/completion.hpp>
+#include <json_commander/model.hpp>
+#include <json_commander/parse.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json_commander::incremental {
+
+  using completion::detail::OptionInfo;
+
+  // -------------------------------------------------------------------------
+  // Grammar
+  // -------------------------------------------------------------------------
+
+  // Everything about a schema that stays fixed while a line is typed: the
+  // compiled spec, its command index and the completion data of every
+  // command. Built once and shared by all parsers over the schema.
+  class Grammar {
+  public:
+    explicit Grammar(const model::Root& root)
+        : spec_(cmd::make(root)), tree_(cmd::shared_index(spec_)) {
+      levels_.reserve(tree_->size());
+      for (command_index::Index::Node node = 0; node < tree_->size(); ++node) {
+        const auto* command = tree_->resolve(root, node);
+        levels_.push_back(
+          command ? completion::detail::collect_command(*command)
+                  : completion::detail::collect(root));
+      }
+    }
+
+    const cmd::RootSpec&
+    spec() const noexcept {
+      return spec_;
+    }
+
+    const std::shared_ptr<const command_index::Index>&
+    tree() const noexcept {
+      return tree_;
+    }
+
+    const completion::detail::CompletionData&
+    level(command_index::Index::Node node) const {
+      return levels_[node];
+    }
+
+  private:
+    cmd::RootSpec spec_;
+    std::shared_ptr<const command_index::Index> tree_;
+    std::vector<completion::detail::CompletionData> levels_;
+  };
+
+  // -------------------------------------------------------------------------
+  // Lookahead
+  // -------------------------------------------------------------------------
+
+  // A value the next word fills: an option's argument or a positional.
+  struct Expected {
+    std::string name; // "--output", "-o", or the positional's name
+    std::string docv; // the converter's metavariable, e.g. "INT"
+    std::string description;
+    bool is_file = false;
+    bool is_dir = false;
+    bool is_path = false;
+    std::vector<std::string> choices = {};
+  };
+
+  struct CommandInfo {
+    std::string name;
+    std::string description;
+  };
+
+  // What may follow the tokens fed so far. When `value` is set the next
+  // word is that option's argument and nothing else is listed.
+  struct Next {
+    // The line is decided (--help and the like, or a stopping error);
+    // nothing more is read.
+    bool done = false;
+    std::optional<Expected> value;
+    // Options accepted here, built-ins first. Empty after "--".
+    std::vector<OptionInfo> options;
+    std::vector<CommandInfo> commands;
+    // The positional a plain word would fill, if any is left.
+    std::optional<Expected> positional;
+  };
+
+  // -------------------------------------------------------------------------
+  // Detail: lookahead helpers
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    inline bool
+    option_matches(const OptionInfo& info, std::string_view partial) {
+      if (partial.empty()) { return true; }
+      if (
+        !info.long_name.empty() &&
+        ("--" + info.long_name).starts_with(partial)) {
+        return true;
+      }
+      return !info.short_name.empty() && partial.size() <= 2 &&
+             ("-" + info.short_name).starts_with(partial);
+    }
+
+    inline Expected
+    expected_value(const OptionInfo& info, std::string docv) {
+      return {
+        info.long_name.empty() ? "-" + info.short_name
+                               : "--" + info.long_name,
+        std::move(docv),
+        info.description,
+        info.is_file,
+        info.is_dir,
+        info.is_path,
+        info.choices};
+    }
+
+    inline const OptionInfo*
+    find_option(
+      const std::vector<OptionInfo>& options, const model::ArgNames& names) {
+      for (const auto& info : options) {
+        for (const auto& name : names) {
+          if (name == info.long_name || name == info.short_name) {
+            return &info;
+          }
+        }
+      }
+      return nullptr;
+    }
+
+    // The value of the option named `names`. An option the completion data
+    // leaves out still takes one, only without description or choices.
+    inline Expected
+    option_value(
+      const std::vector<OptionInfo>& options,
+      const model::ArgNames& names,
+      std::string docv) {
+      if (const auto* info = find_option(options, names)) {
+        return expected_value(*info, std::move(docv));
+      }
+      return {
+        names.empty() ? std::string()
+                      : completion::detail::cli_name(names.front()),
+        std::move(docv),
+        {}};
+    }
+
+    // Drops the choices that do not start with `partial`.
+    inline void
+    narrow_choices(Expected& expected, std::string_view partial) {
+      std::erase_if(expected.choices, [&](const std::string& choice) {
+        return !choice.starts_with(partial);
+      });
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Parser
+  // -------------------------------------------------------------------------
+
+  // Parses a command line one token at a time, as parse::parse_all would,
+  // and answers what may come next at any point. A Parser is a value:
+  // copying one snapshots the line so far (the slots filled so far are
+  // copied, the grammar is shared), so an editor can keep one per token and
+  // resume from the last unchanged one after an edit instead of parsing the
+  // whole line again.
+  class Parser {
+  public:
+    explicit Parser(std::shared_ptr<const Grammar> grammar)
+        : grammar_(std::move(grammar)),
+          cursor_(grammar_->spec(), grammar_->tree()) {
+      diag_.collect_all = true;
+    }
+
+    // Consumes one whole token. Returns false once the line is decided.
+    bool
+    feed(std::string_view token) {
+      return cursor_.feed(token, diag_);
+    }
+
+    // Number of tokens fed so far.
+    std::size_t
+    size() const noexcept {
+      return cursor_.position();
+    }
+
+    const std::vector<std::string>&
+    command_path() const noexcept {
+      return cursor_.command_path();
+    }
+
+    // Errors in the tokens fed so far.
+    std::span<const parse::ErrorInfo>
+    errors() const noexcept {
+      return diag_.errors;
+    }
+
+    // What may follow, narrowed to the names and choices starting with
+    // `partial`, the word being typed.
+    Next
+    next(std::string_view partial = {}) const {
+      Next next;
+      if (cursor_.decided()) {
+        next.done = true;
+        return next;
+      }
+      const auto& data = grammar_->level(cursor_.node());
+
+      if (cursor_.pending() == parse::detail::Pending::CompletionShell) {
+        auto builtins = completion::detail::builtin_options(false);
+        next.value =
+          detail::option_value(builtins, {"help-completion"}, "SHELL");
+        detail::narrow_choices(*next.value, partial);
+        return next;
+      }
+      if (cursor_.pending() == parse::detail::Pending::OptionValue) {
+        const auto& opt = cursor_.pending_option();
+        next.value = detail::option_value(
+          data.options, opt.names, opt.converter.docv);
+        detail::narrow_choices(*next.value, partial);
+        return next;
+      }
+
+      if (!cursor_.options_terminated()) {
+        for (auto& info : completion::detail::builtin_options(
+               cursor_.is_root())) {
+          if (detail::option_matches(info, partial)) {
+            next.options.push_back(std::move(info));
+          }
+        }
+        for (const auto& info : data.options) {
+          if (detail::option_matches(info, partial)) {
+            next.options.push_back(info);
+          }
+        }
+        for (std::size_t k = 0; k < data.subcommand_names.size(); ++k) {
+          if (data.subcommand_names[k].starts_with(partial)) {
+            next.commands.push_back(
+              {data.subcommand_names[k], data.subcommand_docs[k]});
+          }
+        }
+      }
+
+      if (auto k = cursor_.next_positional()) {
+        const auto& table = *cursor_.levels().back().table;
+        const auto& pos = std::get<arg::PositionalSpec>(
+          cursor_.args()[table.positionals[*k]]);
+        const auto& info = data.positionals[*k];
+        next.positional = Expected{
+          info.name,
+          pos.converter.docv,
+          info.description,
+          info.is_file,
+          info.is_dir,
+          info.is_path};
+      }
+      return next;
+    }
+
+    // Ends the line as parse::parse_all would: env fallback, defaults and
+    // validation run on a copy, so the parser can still be fed afterwards.
+    parse::ParseResult
+    finish(
+      const parse::EnvLookup& env = parse::default_env_lookup()) const {
+      auto diag = diag_;
+      auto cursor = cursor_;
+      auto result = parse::detail::settle(
+        grammar_->spec(),
+        *grammar_->tree(),
+        std::move(cursor).finish(diag),
+        env,
+        diag);
+      if (!diag.errors.empty()) {
+        return parse::ParseErrors{std::move(diag.errors)};
+      }
+      return result;
+    }
+
+  private:
+    std::shared_ptr<const Grammar> grammar_;
+    parse::detail::Cursor cursor_;
+    parse::detail::Diagnostics diag_;
+  };
+
+} // namespace json_commander::incremental
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <json_commander/arg.hpp>
+#include <json_commander/conv.hpp>
+#include <json_commander/validate.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace json_commander::input {
+
+  class Error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  // Values read ahead of the program before the reader waits for it.
+  inline constexpr std::size_t default_capacity = 1024;
+
+  // -------------------------------------------------------------------------
+  // Detail: bounded queue
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // One converted value, or the error that ended the input.
+    struct Item {
+      nlohmann::json value;
+      std::optional<std::string> error;
+    };
+
+    // Hands items from the reader thread to the program. push waits while
+    // the queue is full and pop while it is empty; after close, push fails
+    // at once and pop drains what is left.
+    class Queue {
+    public:
+      explicit Queue(std::size_t capacity) : capacity_(capacity) {}
+
+      bool
+      push(Item item) {
+        std::unique_lock lock(mutex_);
+        not_full_.wait(
+          lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) { return false; }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+      }
+
+      std::optional<Item>
+      pop() {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) { return std::nullopt; }
+        auto item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return item;
+      }
+
+      void
+      close() {
+        {
+          std::lock_guard lock(mutex_);
+          closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+      }
+
+    private:
+      std::mutex mutex_;
+      std::condition_variable not_full_;
+      std::condition_variable not_empty_;
+      std::deque<Item> items_;
+      std::size_t capacity_;
+      bool closed_ = false;
+    };
+
+    // -----------------------------------------------------------------------
+    // Reader
+    // -----------------------------------------------------------------------
+
+    // Everything the reader thread touches. Shared with the Stream so the
+    // thread may outlive it where a blocked read cannot be interrupted.
+    struct State {
+      State(int fd, char delimiter, arg::PositionalSpec spec, std::size_t cap)
+          : fd(fd), delimiter(delimiter), spec(std::move(spec)), queue(cap) {}
+
+      int fd;
+      char delimiter;
+      arg::PositionalSpec spec;
+      Queue queue;
+      std::size_t count = 0;
+#ifndef _WIN32
+      // Written to when the Stream goes away, to wake a reader in poll().
+      int wake[2] = {-1, -1};
+#endif
+    };
+
+    // Converts and validates one element as the parser would a word.
+    inline Item
+    element(State& state, std::string_view raw) {
+      const auto& spec = state.spec;
+      std::string error;
+      auto value = conv::try_convert(spec.converter, raw, error);
+      if (!value.has_value()) {
+        return {nullptr, "positional " + spec.name + ": " + error};
+      }
+      auto name = spec.dest + "[" + std::to_string(state.count) + "]";
+      if (auto message = validate::try_validate(spec.validator, name, value)) {
+        return {nullptr, std::move(message)};
+      }
+      ++state.count;
+      return {std::move(*value), std::nullopt};
+    }
+
+    // Queues one delimited entry. Returns false when reading should stop:
+    // the entry was rejected or the Stream went away.
+    inline bool
+    emit(State& state, std::string_view raw) {
+      if (state.delimiter == '\n' && raw.ends_with('\r')) {
+        raw.remove_suffix(1);
+      }
+      if (raw.empty()) { return true; }
+      auto item = element(state, raw);
+      bool rejected = item.error.has_value();
+      return state.queue.push(std::move(item)) && !rejected;
+    }
+
+    // Reads up to `size` bytes. Returns the count, 0 at the end of the
+    // input or once the Stream went away, and -1 with errno set on error.
+    inline long
+    read_some(State& state, char* buffer, std::size_t size) {
+#ifdef _WIN32
+      int n;
+      do {
+        n = ::_read(state.fd, buffer, static_cast<unsigned>(size));
+      } while (n < 0 && errno == EINTR);
+      return n;
+#else
+      pollfd fds[2] = {{state.fd, POLLIN, 0}, {state.wake[0], POLLIN, 0}};
+      while (::poll(fds, 2, -1) < 0) {
+        if (errno != EINTR) { return -1; }
+      }
+      if (fds[1].revents != 0) { return 0; }
+      ssize_t n;
+      do {
+        n = ::read(state.fd, buffer, size);
+      } while (n < 0 && errno == EINTR);
+      return static_cast<long>(n);
+#endif
+    }
+
+    // The reader thread: splits the input on the delimiter and queues the
+    // converted values until the input ends, an entry is rejected or the
+    // Stream goes away. Only the unfinished last entry is buffered.
+    inline void
+    read_all(State& state) {
+      std::array<char, 64 * 1024> chunk;
+      std::string partial;
+      for (;;) {
+        auto n = read_some(state, chunk.data(), chunk.size());
+        if (n < 0) {
+          state.queue.push(
+            {nullptr,
+             "positional " + state.spec.name +
+               ": reading stdin: " + std::generic_category().message(errno)});
+          break;
+        }
+        if (n == 0) {
+          emit(state, partial);
+          break;
+        }
+        partial.append(chunk.data(), static_cast<std::size_t>(n));
+        std::string_view rest = partial;
+        bool go_on = true;
+        for (auto end = rest.find(state.delimiter);
+             go_on && end != std::string_view::npos;
+             end = rest.find(state.delimiter)) {
+          go_on = emit(state, rest.substr(0, end));
+          rest.remove_prefix(end + 1);
+        }
+        if (!go_on) { break; }
+        partial.erase(0, partial.size() - rest.size());
+      }
+      state.queue.close();
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Stream
+  // -------------------------------------------------------------------------
+
+  // The values of a repeated positional read from a file descriptor
+  // (normally stdin) on a background thread while the program runs. At
+  // most `capacity` values wait to be taken, so memory stays bounded however
+  // long the input is. Each value is converted and validated like a word on
+  // the command line. A default-constructed Stream has no values.
+  class Stream {
+  public:
+    Stream() = default;
+
+    Stream(
+      int fd,
+      char delimiter,
+      arg::PositionalSpec spec,
+      std::size_t capacity = default_capacity)
+        : state_(std::make_shared<detail::State>(
+            fd, delimiter, std::move(spec), capacity)) {
+#ifndef _WIN32
+      if (::pipe(state_->wake) != 0) {
+        throw Error("pipe: " + std::generic_category().message(errno));
+      }
+#endif
+      reader_ = std::thread([state = state_] { detail::read_all(*state); });
+    }
+
+    Stream(const Stream&) = delete;
+    Stream&
+    operator=(const Stream&) = delete;
+
+    // Stops reading; values not taken yet are dropped.
+    ~Stream() {
+      if (!state_) { return; }
+      state_->queue.close();
+#ifdef _WIN32
+      // A blocked _read cannot be woken; the thread ends with the input.
+      reader_.detach();
+#else
+      char wake = 0;
+      [[maybe_unused]] auto ignored = ::write(state_->wake[1], &wake, 1);
+      reader_.join();
+      ::close(state_->wake[0]);
+      ::close(state_->wake[1]);
+#endif
+    }
+
+    // Waits for the next value. Returns nullopt once the input is used up;
+    // throws input::Error for a value that fails conversion or validation,
+    // after which the stream is over.
+    std::optional<nlohmann::json>
+    next() {
+      if (!state_) { return std::nullopt; }
+      auto item = state_->queue.pop();
+      if (!item.has_value()) { return std::nullopt; }
+      if (item->error.has_value()) {
+        state_->queue.close();
+        throw Error(*item->error);
+      }
+      return std::move(item->value);
+    }
+
+  private:
+    std::shared_ptr<detail::State> state_;
+    std::thread reader_;
+  };
+
+} // namespace json_commander::input
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <json_commander/command_index.hpp>
 #include <json_commander/conv.hpp>
 #include <json_commander/model.hpp>
 
@@ -782,32 +783,18 @@ namespace json_commander::manpage {
   // -------------------------------------------------------------------------
 
   inline const model::Command&
-  find_command(const model::Root& root, const std::vector<std::string>& path) {
-    if (path.empty()) { throw std::runtime_error("find_command: empty path"); }
-
-    const std::vector<model::Command>* commands =
-      root.commands.has_value() ? &*root.commands : nullptr;
-    const model::Command* current = nullptr;
-
-    for (const auto& segment : path) {
-      if (!commands) {
-        throw std::runtime_error("subcommand not found: " + segment);
-      }
-      bool found = false;
-      for (const auto& cmd : *commands) {
-        if (cmd.name == segment) {
-          current = &cmd;
-          commands = cmd.commands.has_value() ? &*cmd.commands : nullptr;
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        throw std::runtime_error("subcommand not found: " + segment);
-      }
-    }
+  find_command(
+    const model::Root& root,
+    const command_index::Index& index,
+    const std::vector<std::string>& path) {
+    return command_index::find_command(root, index, path);
+  }
 
-    return *current;
+  // Builds a throwaway index; callers rendering more than once should build
+  // one with command_index::make and use the overload above.
+  inline const model::Command&
+  find_command(const model::Root& root, const std::vector<std::string>& path) {
+    return find_command(root, command_index::make(root), path);
   }
 
   // -------------------------------------------------------------------------
@@ -886,11 +873,13 @@ namespace json_commander::manpage {
 
   inline std::string
   to_groff(
-    const model::Root& root, const std::vector<std::string>& command_path) {
+    const model::Root& root,
+    const command_index::Index& index,
+    const std::vector<std::string>& command_path) {
     if (command_path.empty()) { return to_groff(root); }
 
     std::string version = root.version.value_or("");
-    const auto& cmd = find_command(root, command_path);
+    const auto& cmd = find_command(root, index, command_path);
 
     std::string full_name = root.name;
     std::string syn_name = root.name;
@@ -908,6 +897,13 @@ namespace json_commander::manpage {
     return groff::render_page(full_name, man_section, version, sections);
   }
 
+  inline std::string
+  to_groff(
+    const model::Root& root, const std::vector<std::string>& command_path) {
+    if (command_path.empty()) { return to_groff(root); }
+    return to_groff(root, command_index::make(root), command_path);
+  }
+
   // -------------------------------------------------------------------------
   // Convenience: assemble + plain-text render
   // -------------------------------------------------------------------------
@@ -932,11 +928,12 @@ namespace json_commander::manpage {
   inline std::string
   to_plain_text(
     const model::Root& root,
+    const command_index::Index& index,
     const std::vector<std::string>& command_path,
     int width = 0) {
     if (command_path.empty()) { return to_plain_text(root, width); }
 
-    const auto& cmd = find_command(root, command_path);
+    const auto& cmd = find_command(root, index, command_path);
 
     std::string full_name = root.name;
     std::string syn_name = root.name;
@@ -950,6 +947,15 @@ namespace json_commander::manpage {
     return plain::render_page(full_name, sections, width);
   }
 
+  inline std::string
+  to_plain_text(
+    const model::Root& root,
+    const std::vector<std::string>& command_path,
+    int width = 0) {
+    if (command_path.empty()) { return to_plain_text(root, width); }
+    return to_plain_text(root, command_index::make(root), command_path, width);
+  }
+
   // -------------------------------------------------------------------------
   // Convenience: assemble + ANSI-text render
   // -------------------------------------------------------------------------
@@ -974,11 +980,12 @@ namespace json_commander::manpage {
   inline std::string
   to_ansi_text(
     const model::Root& root,
+    const command_index::Index& index,
     const std::vector<std::string>& command_path,
     int width = 0) {
     if (command_path.empty()) { return to_ansi_text(root, width); }
 
-    const auto& cmd = find_command(root, command_path);
+    const auto& cmd = find_command(root, index, command_path);
 
     std::string full_name = root.name;
     std::string syn_name = root.name;
@@ -992,4 +999,13 @@ namespace json_commander::manpage {
     return ansi::render_page(full_name, sections, width);
   }
 
+  inline std::string
+  to_ansi_text(
+    const model::Root& root,
+    const std::vector<std::string>& command_path,
+    int width = 0) {
+    if (command_path.empty()) { return to_ansi_text(root, width); }
+    return to_ansi_text(root, command_index::make(root), command_path, width);
+  }
+
 } // namespace json_commander::manpage
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace json_commander::mapped_file {
+
+  // -------------------------------------------------------------------------
+  // Mapping
+  // -------------------------------------------------------------------------
+
+  // A read-only view of a whole file, mapped into memory rather than read.
+  // Views handed out by view() stay valid as long as the Mapping does. Empty
+  // files are not mapped and view as an empty string.
+  class Mapping {
+  public:
+    Mapping() = default;
+
+    Mapping(const Mapping&) = delete;
+    Mapping&
+    operator=(const Mapping&) = delete;
+
+    Mapping(Mapping&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)) {}
+
+    Mapping&
+    operator=(Mapping&& other) noexcept {
+      if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+      }
+      return *this;
+    }
+
+    ~Mapping() { release(); }
+
+    std::string_view
+    view() const noexcept {
+      return {data_, size_};
+    }
+
+    std::size_t
+    size() const noexcept {
+      return size_;
+    }
+
+    friend std::optional<Mapping>
+    try_open(const std::filesystem::path& path, std::string& error);
+
+  private:
+    void
+    release() noexcept {
+      if (data_ == nullptr) { return; }
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+#else
+      munmap(const_cast<char*>(data_), size_);
+#endif
+      data_ = nullptr;
+      size_ = 0;
+    }
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+  };
+
+  // -------------------------------------------------------------------------
+  // Opening
+  // -------------------------------------------------------------------------
+
+  // Maps the regular file `path`, or returns nullopt with `error` set to the
+  // reason.
+  inline std::optional<Mapping>
+  try_open(const std::filesystem::path& path, std::string& error) {
+    Mapping mapping;
+#ifdef _WIN32
+    HANDLE file = CreateFileW(
+      path.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+    auto last_error = [] {
+      return std::system_category().message(static_cast<int>(GetLastError()));
+    };
+    if (file == INVALID_HANDLE_VALUE) {
+      error = last_error();
+      return std::nullopt;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+      error = last_error();
+      CloseHandle(file);
+      return std::nullopt;
+    }
+    if (size.QuadPart > 0) {
+      HANDLE section =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (section != nullptr) {
+        mapping.data_ = static_cast<const char*>(
+          MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(section);
+      }
+      if (mapping.data_ == nullptr) {
+        error = last_error();
+        CloseHandle(file);
+        return std::nullopt;
+      }
+      mapping.size_ = static_cast<std::size_t>(size.QuadPart);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      error = std::generic_category().message(errno);
+      return std::nullopt;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+      error = std::generic_category().message(errno);
+      ::close(fd);
+      return std::nullopt;
+    }
+    // Pipes and devices have no size to map.
+    if (!S_ISREG(st.st_mode)) {
+      error = "not a regular file";
+      ::close(fd);
+      return std::nullopt;
+    }
+    if (st.st_size > 0) {
+      auto size = static_cast<std::size_t>(st.st_size);
+      void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        error = std::generic_category().message(errno);
+        ::close(fd);
+        return std::nullopt;
+      }
+      mapping.data_ = static_cast<const char*>(data);
+      mapping.size_ = size;
+    }
+    // The mapping keeps the file's pages; the descriptor is not needed.
+    ::close(fd);
+#endif
+    return mapping;
+  }
+
+} // namespace json_commander::mapped_file
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <json_commander/arg.hpp>
+#include <json_commander/config_cache.hpp>
+#include <json_commander/config_file.hpp>
+#include <json_commander/mapped_file.hpp>
+#include <json_commander/model.hpp>
+#include <json_commander/model_json.hpp>
+#include <json_commander/validate.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace json_commander::memo {
+
+  // Bumped whenever the key or the layout of an entry changes.
+  inline constexpr int format_version = 1;
+
+  // How many entries store keeps per program before it drops the oldest.
+  inline constexpr std::size_t default_max_entries = 256;
+
+  // What key() needs from the model. Working it out walks and dumps the
+  // whole model, so a program that computes several keys for one root
+  // keeps it.
+  struct Profile {
+    std::uint64_t fingerprint = 0; // config_file::fingerprint of the root
+    std::vector<std::string> env;  // sorted variable names
+  };
+
+  // What a successful invocation produced: the validated config and the
+  // command it selected.
+  struct Entry {
+    nlohmann::json config;
+    std::vector<std::string> command_path;
+    bool
+    operator==(const Entry&) const = default;
+  };
+
+  // -------------------------------------------------------------------------
+  // Detail: walking the model
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    inline const std::vector<model::Argument>&
+    args_of(const std::optional<std::vector<model::Argument>>& args) {
+      static const std::vector<model::Argument> none;
+      return args.has_value() ? *args : none;
+    }
+
+    // The environment variables options and flags at any level fall back
+    // to, sorted so the key does not depend on declaration order.
+    inline void
+    env_vars(
+      const std::optional<std::vector<model::Argument>>& args,
+      const std::optional<std::vector<model::Command>>& commands,
+      std::set<std::string>& vars) {
+      for (const auto& a : args_of(args)) {
+        std::visit(
+          [&](const auto& spec) {
+            using T = std::decay_t<decltype(spec)>;
+            if constexpr (
+              std::is_same_v<T, model::Flag> ||
+              std::is_same_v<T, model::Option>) {
+              if (spec.env.has_value()) {
+                vars.insert(arg::detail::resolve_env(*spec.env).var);
+              }
+            }
+          },
+          a);
+      }
+      if (!commands.has_value()) { return; }
+      for (const auto& command : *commands) {
+        env_vars(command.args, command.commands, vars);
+      }
+    }
+
+    // Calls `visit(args, level)` for the arguments of each command on
+    // `path` and the part of `config` they fill, root first. Returns false
+    // if `path` or `config` does not match the model.
+    template <class Visit>
+    bool
+    for_each_level(
+      const model::Root& root,
+      const std::vector<std::string>& path,
+      const nlohmann::json& config,
+      Visit visit) {
+      const auto* args = &root.args;
+      const auto* commands = &root.commands;
+      const auto* level = &config;
+      for (std::size_t depth = 0;; ++depth) {
+        if (!visit(args_of(*args), *level)) { return false; }
+        if (depth == path.size()) { return true; }
+        if (!commands->has_value()) { return false; }
+        const model::Command* next = nullptr;
+        for (const auto& command : **commands) {
+          if (command.name == path[depth]) { next = &command; }
+        }
+        auto it = level->find(path[depth]);
+        if (next == nullptr || it == level->end()) { return false; }
+        args = &next->args;
+        commands = &next->commands;
+        level = &*it;
+      }
+    }
+
+    inline bool
+    reads_stdin(const model::Root& root, const Entry& entry) {
+      bool found = false;
+      for_each_level(
+        root,
+        entry.command_path,
+        entry.config,
+        [&](const std::vector<model::Argument>& args, const nlohmann::json&) {
+          for (const auto& a : args) {
+            const auto* pos = std::get_if<model::Positional>(&a);
+            if (pos && pos->from_stdin.has_value()) { found = true; }
+          }
+          return true;
+        });
+      return found;
+    }
+
+    // Runs the must_exist checks of the arguments on the entry's command
+    // path again, exactly as the parser did: the files may be gone.
+    inline bool
+    still_exists(const model::Root& root, const Entry& entry) {
+      auto check = [](const auto& a, const nlohmann::json& level) {
+        if (!a.must_exist.value_or(false)) { return true; }
+        auto spec = arg::make(a);
+        std::optional<nlohmann::json> value;
+        if (auto it = level.find(spec.dest); it != level.end()) {
+          value = *it;
+        }
+        return !validate::try_validate(spec.validator, spec.dest, value);
+      };
+      return for_each_level(
+        root,
+        entry.command_path,
+        entry.config,
+        [&](
+          const std::vector<model::Argument>& args,
+          const nlohmann::json& level) {
+          for (const auto& a : args) {
+            if (const auto* opt = std::get_if<model::Option>(&a)) {
+              if (!check(*opt, level)) { return false; }
+            } else if (const auto* pos = std::get_if<model::Positional>(&a)) {
+              if (!check(*pos, level)) { return false; }
+            }
+          }
+          return true;
+        });
+    }
+
+    inline std::optional<std::filesystem::path>
+    entry_path(const model::Root& root, std::string_view key) {
+      auto dir = config_cache::directory();
+      if (!dir.has_value()) { return std::nullopt; }
+      return config_cache::entry_path(*dir / "memo", root.name, key);
+    }
+
+    // The entries `program` has in the directory holding `entry`, named as
+    // config_cache::entry_path names them, with their modification times.
+    inline std::vector<
+      std::pair<std::filesystem::file_time_type, std::filesystem::path>>
+    entries(const std::filesystem::path& entry, std::string_view program) {
+      std::vector<
+        std::pair<std::filesystem::file_time_type, std::filesystem::path>>
+        found;
+      std::string prefix = std::string(program) + "-";
+      // The prefix, 16 hex digits and ".cbor".
+      std::size_t length = prefix.size() + 16 + 5;
+      std::error_code ec;
+      for (const auto& file :
+           std::filesystem::directory_iterator(entry.parent_path(), ec)) {
+        auto name = file.path().filename().string();
+        if (
+          name.size() != length || !name.starts_with(prefix) ||
+          !name.ends_with(".cbor")) {
+          continue;
+        }
+        auto time = file.last_write_time(ec);
+        if (!ec) { found.emplace_back(time, file.path()); }
+      }
+      return found;
+    }
+
+    // Removes the oldest of `program`'s entries until at most `keep` are
+    // left. Entries are rewritten when stored again, so this drops the
+    // invocations least recently parsed.
+    inline void
+    prune(
+      const std::filesystem::path& entry,
+      std::string_view program,
+      std::size_t keep) {
+      auto found = entries(entry, program);
+      if (found.size() <= keep) { return; }
+      auto excess = found.size() - keep;
+      std::nth_element(
+        found.begin(),
+        found.begin() + static_cast<std::ptrdiff_t>(excess - 1),
+        found.end());
+      for (std::size_t i = 0; i < excess; ++i) {
+        std::error_code ec;
+        std::filesystem::remove(found[i].second, ec);
+      }
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Public API
+  // -------------------------------------------------------------------------
+
+  // Whether `root` opts in through parsing.memoize.
+  inline bool
+  enabled(const model::Root& root) {
+    return root.parsing.has_value() && root.parsing->memoize.value_or(false);
+  }
+
+  inline Profile
+  profile(const model::Root& root) {
+    std::set<std::string> names;
+    detail::env_vars(root.args, root.commands, names);
+    return {
+      config_file::fingerprint(root),
+      std::vector<std::string>(names.begin(), names.end())};
+  }
+
+  // Everything the result of parsing `argv` (argv[0] excluded) against
+  // `root` depends on: the schema, the arguments, the values of the
+  // variables the schema binds, and the stamps of the config files found
+  // from `dir`. Returns nullopt when the invocation cannot be remembered:
+  // it names a response file, whose contents are not part of the key, or
+  // a config file cannot be stat'ed. `profile` is profile(root).
+  inline std::optional<std::string>
+  key(
+    const model::Root& root,
+    const Profile& profile,
+    int argc,
+    const char* const* argv,
+    const std::filesystem::path& dir = std::filesystem::current_path()) {
+    auto args = nlohmann::json::array();
+    bool responses = root.parsing.has_value() && root.parsing->response_files;
+    for (int i = 1; i < argc; ++i) {
+      std::string_view token = argv[i];
+      if (responses && token.starts_with('@')) { return std::nullopt; }
+      args.push_back(token);
+    }
+
+    auto env = nlohmann::json::object();
+    for (const auto& name : profile.env) {
+      const char* value = std::getenv(name.c_str());
+      env[name] = value ? nlohmann::json(value) : nlohmann::json(nullptr);
+    }
+
+    std::vector<config_cache::Source> sources;
+    if (root.config.has_value()) {
+      for (auto& path : config_file::paths(*root.config, dir)) {
+        auto stamp = config_cache::stamp(path);
+        if (!stamp.has_value()) { return std::nullopt; }
+        sources.push_back({std::move(path), *stamp});
+      }
+    }
+
+    return nlohmann::json{
+      {"version", format_version},
+      {"schema", profile.fingerprint},
+      {"args", std::move(args)},
+      {"env", std::move(env)},
+      {"sources", config_cache::detail::to_json(sources)}}
+      .dump();
+  }
+
+  // As above, working out the profile of `root` first.
+  inline std::optional<std::string>
+  key(
+    const model::Root& root,
+    int argc,
+    const char* const* argv,
+    const std::filesystem::path& dir = std::filesystem::current_path()) {
+    return key(root, profile(root), argc, argv, dir);
+  }
+
+  // The entry remembered for `key`, provided its must_exist paths still
+  // pass. A missing, damaged or colliding entry is a miss.
+  inline std::optional<Entry>
+  lookup(const model::Root& root, const std::string& key) {
+    auto path = detail::entry_path(root, key);
+    if (!path.has_value()) { return std::nullopt; }
+    std::string error;
+    auto mapping = mapped_file::try_open(*path, error);
+    if (!mapping.has_value()) { return std::nullopt; }
+    auto bytes = mapping->view();
+    // Packed lists in the config are tagged byte strings.
+    auto j = nlohmann::json::from_cbor(
+      bytes.begin(),
+      bytes.end(),
+      true,
+      false,
+      nlohmann::json::cbor_tag_handler_t::store);
+    if (
+      !j.is_object() || !j.contains("key") || j["key"] != key ||
+      !j.contains("config") || !j.contains("command_path") ||
+      !j["command_path"].is_array()) {
+      return std::nullopt;
+    }
+    Entry entry{std::move(j["config"]), {}};
+    for (const auto& name : j["command_path"]) {
+      if (!name.is_string()) { return std::nullopt; }
+      entry.command_path.push_back(name.get<std::string>());
+    }
+    if (!detail::still_exists(root, entry)) { return std::nullopt; }
+    return entry;
+  }
+
+  // Remembers `entry` for `key`. Entries whose command reads a positional
+  // from stdin are not kept, since stdin is not part of the key. Returns
+  // false if nothing was written; the cache is only an optimization. Each
+  // distinct invocation is one file, so when a new one takes the count
+  // past `max_entries` for this program the oldest are removed.
+  inline bool
+  store(
+    const model::Root& root,
+    const std::string& key,
+    const Entry& entry,
+    std::size_t max_entries = default_max_entries) {
+    if (detail::reads_stdin(root, entry)) { return false; }
+    auto path = detail::entry_path(root, key);
+    if (!path.has_value()) { return false; }
+    // Rewriting an entry leaves the count as it was.
+    std::error_code ec;
+    bool added = !std::filesystem::exists(*path, ec);
+    bool written = config_cache::detail::write_atomic(
+      *path,
+      nlohmann::json::to_cbor(
+        {{"key", key},
+         {"config", entry.config},
+         {"command_path", entry.command_path}}));
+    if (written && added) { detail::prune(*path, root.name, max_entries); }
+    return written;
+  }
+
+  // Forgets every invocation of `root` remembered so far.
+  inline void
+  clear(const model::Root& root) {
+    auto path = detail::entry_path(root, "");
+    if (!path.has_value()) { return; }
+    for (const auto& [time, file] : detail::entries(*path, root.name)) {
+      std::error_code ec;
+      std::filesystem::remove(file, ec);
+    }
+  }
+
+} // namespace json_commander::memo
@@ -15,11 +15,26 @@ namespace json_commander::model {
 
   using ArgNames = std::vector<std::string>;
 
-  enum class ScalarType { String, Int, Float, Bool, Enum, File, Dir, Path };
+  enum class ScalarType {
+    String,
+    Int,
+    Float,
+    Bool,
+    Enum,
+    File,
+    Dir,
+    Path,
+    Size,    // bytes, from "4K" or "1.5G"
+    Duration // milliseconds, from "250ms" or "2h"
+  };
 
   struct ListType {
     ScalarType element;
     std::optional<std::string> separator;
+    // At most this many elements (conv::default_max_elements if unset).
+    std::optional<std::size_t> max_elements = std::nullopt;
+    // Deliver a list of numbers as one packed binary value (see conv.hpp).
+    std::optional<bool> packed = std::nullopt;
     bool
     operator==(const ListType&) const = default;
   };
@@ -139,6 +154,8 @@ namespace json_commander::model {
     std::optional<bool> repeated;
     std::optional<bool> must_exist;
     std::optional<std::string> docs;
+    // Also read values from stdin: "newline" or "nul" delimited.
+    std::optional<std::string> from_stdin = std::nullopt;
     bool
     operator==(const Positional&) const = default;
   };
@@ -207,6 +224,9 @@ namespace json_commander::model {
     std::optional<std::string> system;
     std::optional<std::string> user;
     std::optional<std::string> local;
+    // Directory of fragments ("conf.d"), merged in lexical order between
+    // the system and user files.
+    std::optional<std::string> drop_in = std::nullopt;
     bool
     operator==(const ConfigPaths&) const = default;
   };
@@ -214,10 +234,32 @@ namespace json_commander::model {
   struct Config {
     std::string format;
     std::optional<ConfigPaths> paths;
+    // Keep the merged files in a binary cache (see config_cache.hpp).
+    std::optional<bool> cache = std::nullopt;
     bool
     operator==(const Config&) const = default;
   };
 
+  // ---------------------------------------------------------------------------
+  // Parser settings
+  // ---------------------------------------------------------------------------
+
+  struct ResponseFiles {
+    std::optional<std::string> delimiter; // "newline" (default) or "nul"
+    std::optional<int> max_depth;
+    bool
+    operator==(const ResponseFiles&) const = default;
+  };
+
+  struct Parsing {
+    std::optional<bool> abbreviations;
+    std::optional<ResponseFiles> response_files = std::nullopt;
+    // Remember validated configs of whole invocations (see memo.hpp).
+    std::optional<bool> memoize = std::nullopt;
+    bool
+    operator==(const Parsing&) const = default;
+  };
+
   // ---------------------------------------------------------------------------
   // Command types
   // ---------------------------------------------------------------------------
@@ -244,6 +286,7 @@ namespace json_commander::model {
     std::optional<std::vector<ExitInfo>> exits;
     std::optional<std::string> version;
     std::optional<Config> config;
+    std::optional<Parsing> parsing;
     bool
     operator==(const Root&) const = default;
   };
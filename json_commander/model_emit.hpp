@@ -136,6 +136,10 @@ namespace json_commander::model_emit {
             return "ScalarType::Dir";
           case model::ScalarType::Path:
             return "ScalarType::Path";
+          case model::ScalarType::Size:
+            return "ScalarType::Size";
+          case model::ScalarType::Duration:
+            return "ScalarType::Duration";
         }
         return "ScalarType::String";
       }
@@ -151,6 +155,12 @@ namespace json_commander::model_emit {
         if (lt.separator) {
           result += ", .separator = " + quoted(*lt.separator);
         }
+        if (lt.max_elements) {
+          result += ", .max_elements = " + std::to_string(*lt.max_elements);
+        }
+        if (lt.packed) {
+          result += ", .packed = " + emit_opt_bool(lt.packed);
+        }
         result += "}";
         return result;
       }
@@ -406,6 +416,8 @@ namespace json_commander::model_emit {
         result +=
           pad() + ".must_exist = " + emit_opt_bool(p.must_exist) + ",\n";
         result += pad() + ".docs = " + emit_opt_string(p.docs) + ",\n";
+        result +=
+          pad() + ".from_stdin = " + emit_opt_string(p.from_stdin) + ",\n";
         --indent;
         result += pad() + "}";
         return result;
@@ -518,7 +530,8 @@ namespace json_commander::model_emit {
       emit_config_paths(const model::ConfigPaths& cp) {
         return "ConfigPaths{.system = " + emit_opt_string(cp.system) +
                ", .user = " + emit_opt_string(cp.user) +
-               ", .local = " + emit_opt_string(cp.local) + "}";
+               ", .local = " + emit_opt_string(cp.local) +
+               ", .drop_in = " + emit_opt_string(cp.drop_in) + "}";
       }
 
       std::string
@@ -529,7 +542,31 @@ namespace json_commander::model_emit {
         } else {
           result += ", .paths = std::nullopt";
         }
-        result += "}";
+        result += ", .cache = " + emit_opt_bool(c.cache) + "}";
+        return result;
+      }
+
+      // -----------------------------------------------------------------------
+      // Parser settings
+      // -----------------------------------------------------------------------
+
+      std::string
+      emit_response_files(const model::ResponseFiles& rf) {
+        return "ResponseFiles{.delimiter = " + emit_opt_string(rf.delimiter) +
+               ", .max_depth = " + emit_opt_int(rf.max_depth) + "}";
+      }
+
+      std::string
+      emit_parsing(const model::Parsing& p) {
+        std::string result =
+          "Parsing{.abbreviations = " + emit_opt_bool(p.abbreviations);
+        if (p.response_files) {
+          result += ", .response_files = " +
+                    emit_response_files(*p.response_files);
+        } else {
+          result += ", .response_files = std::nullopt";
+        }
+        result += ", .memoize = " + emit_opt_bool(p.memoize) + "}";
         return result;
       }
 
@@ -607,6 +644,12 @@ namespace json_commander::model_emit {
         return "std::nullopt";
       }
 
+      std::string
+      emit_opt_parsing(const std::optional<model::Parsing>& p) {
+        if (p) { return emit_parsing(*p); }
+        return "std::nullopt";
+      }
+
       std::string
       emit_command(const model::Command& cmd) {
         std::string result = "Command{\n";
@@ -638,6 +681,8 @@ namespace json_commander::model_emit {
         result += pad() + ".exits = " + emit_opt_exits(root.exits) + ",\n";
         result += pad() + ".version = " + emit_opt_string(root.version) + ",\n";
         result += pad() + ".config = " + emit_opt_config(root.config) + ",\n";
+        result +=
+          pad() + ".parsing = " + emit_opt_parsing(root.parsing) + ",\n";
         --indent;
         result += pad() + "}";
         return result;
@@ -48,6 +48,8 @@ namespace json_commander::model {
       {ScalarType::File, "file"},
       {ScalarType::Dir, "dir"},
       {ScalarType::Path, "path"},
+      {ScalarType::Size, "size"},
+      {ScalarType::Duration, "duration"},
     };
     for (const auto& [val, name] : table) {
       if (val == s) {
@@ -69,6 +71,8 @@ namespace json_commander::model {
       {"file", ScalarType::File},
       {"dir", ScalarType::Dir},
       {"path", ScalarType::Path},
+      {"size", ScalarType::Size},
+      {"duration", ScalarType::Duration},
     };
     auto str = j.get<std::string>();
     for (const auto& [name, val] : table) {
@@ -89,6 +93,8 @@ namespace json_commander::model {
     nlohmann::json inner;
     inner["element"] = lt.element;
     detail::set_optional(inner, "separator", lt.separator);
+    detail::set_optional(inner, "max_elements", lt.max_elements);
+    detail::set_optional(inner, "packed", lt.packed);
     j = {{"list", inner}};
   }
 
@@ -97,6 +103,8 @@ namespace json_commander::model {
     const auto& inner = j.at("list");
     inner.at("element").get_to(lt.element);
     detail::get_optional(inner, "separator", lt.separator);
+    detail::get_optional(inner, "max_elements", lt.max_elements);
+    detail::get_optional(inner, "packed", lt.packed);
   }
 
   // ---------------------------------------------------------------------------
@@ -389,6 +397,7 @@ namespace json_commander::model {
     detail::set_optional(j, "repeated", p.repeated);
     detail::set_optional(j, "must_exist", p.must_exist);
     detail::set_optional(j, "docs", p.docs);
+    detail::set_optional(j, "from_stdin", p.from_stdin);
   }
 
   inline void
@@ -406,6 +415,7 @@ namespace json_commander::model {
     detail::get_optional(j, "repeated", p.repeated);
     detail::get_optional(j, "must_exist", p.must_exist);
     detail::get_optional(j, "docs", p.docs);
+    detail::get_optional(j, "from_stdin", p.from_stdin);
   }
 
   // ---------------------------------------------------------------------------
@@ -596,6 +606,7 @@ namespace json_commander::model {
     detail::set_optional(j, "system", cp.system);
     detail::set_optional(j, "user", cp.user);
     detail::set_optional(j, "local", cp.local);
+    detail::set_optional(j, "drop_in", cp.drop_in);
   }
 
   inline void
@@ -603,6 +614,7 @@ namespace json_commander::model {
     detail::get_optional(j, "system", cp.system);
     detail::get_optional(j, "user", cp.user);
     detail::get_optional(j, "local", cp.local);
+    detail::get_optional(j, "drop_in", cp.drop_in);
   }
 
   // ---------------------------------------------------------------------------
@@ -614,12 +626,50 @@ namespace json_commander::model {
     j = nlohmann::json::object();
     j["format"] = c.format;
     detail::set_optional(j, "paths", c.paths);
+    detail::set_optional(j, "cache", c.cache);
   }
 
   inline void
   from_json(const nlohmann::json& j, Config& c) {
     j.at("format").get_to(c.format);
     detail::get_optional(j, "paths", c.paths);
+    detail::get_optional(j, "cache", c.cache);
+  }
+
+  // ---------------------------------------------------------------------------
+  // ResponseFiles
+  // ---------------------------------------------------------------------------
+
+  inline void
+  to_json(nlohmann::json& j, const ResponseFiles& rf) {
+    j = nlohmann::json::object();
+    detail::set_optional(j, "delimiter", rf.delimiter);
+    detail::set_optional(j, "max_depth", rf.max_depth);
+  }
+
+  inline void
+  from_json(const nlohmann::json& j, ResponseFiles& rf) {
+    detail::get_optional(j, "delimiter", rf.delimiter);
+    detail::get_optional(j, "max_depth", rf.max_depth);
+  }
+
+  // ---------------------------------------------------------------------------
+  // Parsing
+  // ---------------------------------------------------------------------------
+
+  inline void
+  to_json(nlohmann::json& j, const Parsing& p) {
+    j = nlohmann::json::object();
+    detail::set_optional(j, "abbreviations", p.abbreviations);
+    detail::set_optional(j, "response_files", p.response_files);
+    detail::set_optional(j, "memoize", p.memoize);
+  }
+
+  inline void
+  from_json(const nlohmann::json& j, Parsing& p) {
+    detail::get_optional(j, "abbreviations", p.abbreviations);
+    detail::get_optional(j, "response_files", p.response_files);
+    detail::get_optional(j, "memoize", p.memoize);
   }
 
   // ---------------------------------------------------------------------------
@@ -665,6 +715,7 @@ namespace json_commander::model {
     detail::set_optional(j, "exits", r.exits);
     detail::set_optional(j, "version", r.version);
     detail::set_optional(j, "config", r.config);
+    detail::set_optional(j, "parsing", r.parsing);
   }
 
   inline void
@@ -678,6 +729,7 @@ namespace json_commander::model {
     detail::get_optional(j, "exits", r.exits);
     detail::get_optional(j, "version", r.version);
     detail::get_optional(j, "config", r.config);
+    detail::get_optional(j, "parsing", r.parsing);
   }
 
 } // namespace json_commander::model
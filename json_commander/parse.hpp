@@ -1,19 +1,132 @@
 #pragma once
 
 #include <json_commander/cmd.hpp>
+#include <json_commander/mapped_file.hpp>
+#include <json_commander/suggest.hpp>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <functional>
+#include <memory>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#if defined(__APPLE__)
+#include <crt_externs.h>
+#elif !defined(_WIN32)
+// POSIX leaves declaring the environment to the program.
+extern char** environ;
+#endif
+
 namespace json_commander::parse {
 
+  // -------------------------------------------------------------------------
+  // Structured errors
+  // -------------------------------------------------------------------------
+
+  enum class ErrorKind {
+    UnknownOption,      // option not declared at this level
+    UnknownCommand,     // stray word where a subcommand was expected
+    AmbiguousOption,    // abbreviation of several options
+    AmbiguousCommand,   // abbreviation of several subcommands
+    MissingValue,       // option given as the last token, without a value
+    MisplacedOption,    // value-taking short option not last in its group
+    InvalidValue,       // command-line value rejected by the converter
+    UnexpectedArgument, // positional with no positional left to fill
+    BadResponseFile,    // @file unreadable or nested too deeply
+    InvalidShell,       // --help-completion with an unsupported shell
+    NoVersion,          // --version without a version in the schema
+    InvalidEnv,         // environment fallback rejected by the converter
+    ValidationFailed,   // required or must_exist check failed
+  };
+
+  // Stable snake_case name of `kind`, e.g. "unknown_option".
+  inline std::string_view
+  to_string(ErrorKind kind) {
+    switch (kind) {
+      case ErrorKind::UnknownOption:
+        return "unknown_option";
+      case ErrorKind::UnknownCommand:
+        return "unknown_command";
+      case ErrorKind::AmbiguousOption:
+        return "ambiguous_option";
+      case ErrorKind::AmbiguousCommand:
+        return "ambiguous_command";
+      case ErrorKind::MissingValue:
+        return "missing_value";
+      case ErrorKind::MisplacedOption:
+        return "misplaced_option";
+      case ErrorKind::InvalidValue:
+        return "invalid_value";
+      case ErrorKind::UnexpectedArgument:
+        return "unexpected_argument";
+      case ErrorKind::BadResponseFile:
+        return "bad_response_file";
+      case ErrorKind::InvalidShell:
+        return "invalid_shell";
+      case ErrorKind::NoVersion:
+        return "no_version";
+      case ErrorKind::InvalidEnv:
+        return "invalid_env";
+      case ErrorKind::ValidationFailed:
+        return "validation_failed";
+    }
+    return "unknown";
+  }
+
+  struct ErrorInfo {
+    ErrorKind kind;
+    // Index of the offending token among the parsed arguments (argv[i + 1]
+    // for the argc/argv overloads); nullopt for errors found after the
+    // command line was consumed (environment fallback and validation).
+    std::optional<std::size_t> token;
+    // The option, positional, command or environment variable concerned.
+    std::string arg;
+    // What parse::Error::what() reports, "did you mean" hint included.
+    std::string message;
+    std::vector<std::string> suggestions = {};
+  };
+
+  namespace detail {
+
+    inline std::string
+    with_hint(
+      const std::string& message, const std::vector<std::string>& names) {
+      if (names.empty()) { return message; }
+      std::string result = message + " (did you mean ";
+      for (std::size_t i = 0; i < names.size(); ++i) {
+        if (i > 0) { result += i + 1 == names.size() ? " or " : ", "; }
+        result += names[i];
+      }
+      return result + "?)";
+    }
+
+    inline ErrorInfo
+    make_error(
+      ErrorKind kind,
+      std::optional<std::size_t> token,
+      std::string_view arg,
+      const std::string& message,
+      std::vector<std::string> suggestions = {}) {
+      return {
+        kind,
+        token,
+        std::string(arg),
+        with_hint(message, suggestions),
+        std::move(suggestions)};
+    }
+
+  } // namespace detail
+
   // -------------------------------------------------------------------------
   // Error type
   // -------------------------------------------------------------------------
@@ -22,15 +135,74 @@ namespace json_commander::parse {
   public:
     explicit Error(const std::string& message)
         : std::runtime_error(message) {}
+
+    // What parse() throws for an error try_parse would return.
+    explicit Error(ErrorInfo info)
+        : std::runtime_error(info.message), info_(std::move(info)) {}
+
+    const std::optional<ErrorInfo>&
+    info() const noexcept {
+      return info_;
+    }
+
+    // For unknown names: the closest valid names, also appended to the
+    // message as a "did you mean" hint.
+    const std::vector<std::string>&
+    suggestions() const noexcept {
+      static const std::vector<std::string> none;
+      return info_.has_value() ? info_->suggestions : none;
+    }
+
+  private:
+    std::optional<ErrorInfo> info_;
   };
 
   // -------------------------------------------------------------------------
   // Result types
   // -------------------------------------------------------------------------
 
+  // Where a value in a slot came from.
+  enum class Source { Unset, Cli, Env, File, Default };
+
+  // Accumulated value for one config key of one command level.
+  struct Slot {
+    nlohmann::json value;
+    Source source = Source::Unset;
+    int count = 0; // number of times the key was given on the command line
+    // A command-line value failed to convert. Only seen when collecting all
+    // errors; env fallback, defaults and validation then skip the slot.
+    bool rejected = false;
+    // Command-line values went to a parse::stream event handler instead of
+    // `value`. Validation skips the slot.
+    bool streamed = false;
+  };
+
+  // The slots of one command level, indexed by the level's key handles.
+  // The slots live in the memory resource the parse was given.
+  struct LevelValues {
+    std::shared_ptr<const cmd::LevelTable> table;
+    std::pmr::vector<Slot> slots;
+
+    const Slot&
+    operator[](cmd::KeyHandle key) const {
+      return slots[key];
+    }
+
+    const Slot*
+    find(std::string_view dest) const {
+      auto key = table->key(dest);
+      if (!key.has_value()) { return nullptr; }
+      return &slots[*key];
+    }
+  };
+
   struct ParseOk {
     nlohmann::json config;
     std::vector<std::string> command_path;
+    // levels[0] is the root; levels[i] belongs to command_path[i - 1].
+    // Allocated from the parse's memory resource, unlike the config and
+    // command path, so they must not outlive it.
+    std::pmr::vector<LevelValues> levels = {};
   };
 
   struct HelpRequest {
@@ -47,12 +219,103 @@ namespace json_commander::parse {
     std::string shell;
   };
 
+  // Every error found by parse_all, in command-line order followed by the
+  // environment and validation errors. Never produced by parse/try_parse.
+  struct ParseErrors {
+    std::vector<ErrorInfo> errors;
+  };
+
   using ParseResult = std::variant<
     ParseOk,
     HelpRequest,
     VersionRequest,
     ManpageRequest,
-    CompletionRequest>;
+    CompletionRequest,
+    ParseErrors>;
+
+  // Outcome of try_parse: a ParseResult, or the first error found.
+  class TryResult {
+  public:
+    explicit TryResult(ParseResult result) : outcome_(std::move(result)) {}
+    explicit TryResult(ErrorInfo error) : outcome_(std::move(error)) {}
+
+    bool
+    has_value() const noexcept {
+      return outcome_.index() == 0;
+    }
+
+    explicit
+    operator bool() const noexcept {
+      return has_value();
+    }
+
+    // Throws std::bad_variant_access when there is no value.
+    ParseResult&
+    value() & {
+      return std::get<ParseResult>(outcome_);
+    }
+
+    const ParseResult&
+    value() const& {
+      return std::get<ParseResult>(outcome_);
+    }
+
+    ParseResult&&
+    value() && {
+      return std::get<ParseResult>(std::move(outcome_));
+    }
+
+    // Throws std::bad_variant_access when there is no error.
+    const ErrorInfo&
+    error() const {
+      return std::get<ErrorInfo>(outcome_);
+    }
+
+  private:
+    std::variant<ParseResult, ErrorInfo> outcome_;
+  };
+
+  // -------------------------------------------------------------------------
+  // Events (parse::stream)
+  // -------------------------------------------------------------------------
+
+  // The views point into the spec or the token and are only valid during
+  // the handler call. Values are converted; `token` indexes the arguments
+  // as in ErrorInfo.
+
+  struct OptionEvent {
+    std::string_view dest;
+    std::string_view name; // as given: "--output", "--out", "-o"
+    nlohmann::json value;
+    std::size_t token;
+  };
+
+  // `value` is what the flag sets: true, the repetition count for repeated
+  // flags, or a flag group entry's value.
+  struct FlagEvent {
+    std::string_view dest;
+    std::string_view name;
+    nlohmann::json value;
+    std::size_t token;
+  };
+
+  struct PositionalEvent {
+    std::string_view dest;
+    nlohmann::json value;
+    std::size_t token;
+  };
+
+  struct CommandEvent {
+    std::string_view name;
+    std::size_t token;
+  };
+
+  using Event =
+    std::variant<OptionEvent, FlagEvent, PositionalEvent, CommandEvent>;
+
+  // Returns true to take the value: the parser then only counts it, leaving
+  // it out of the slot. The result is ignored for CommandEvent.
+  using EventHandler = std::function<bool(const Event&)>;
 
   // -------------------------------------------------------------------------
   // Environment lookup
@@ -78,71 +341,105 @@ namespace json_commander::parse {
   }
 
   // -------------------------------------------------------------------------
-  // Detail: name index
+  // Environment snapshot
   // -------------------------------------------------------------------------
 
   namespace detail {
 
-    enum class MatchKind { Flag, Option, FlagGroup };
-
-    struct MatchResult {
-      std::size_t arg_index;
-      MatchKind kind;
-      std::size_t entry_index;
-    };
-
-    class NameIndex {
-      std::unordered_map<std::string, MatchResult> entries_;
-
-    public:
-      void
-      insert(const std::string& cli_name, MatchResult result) {
-        entries_.emplace(cli_name, result);
-      }
-
-      std::optional<MatchResult>
-      lookup(const std::string& cli_name) const {
-        auto it = entries_.find(cli_name);
-        if (it == entries_.end()) { return std::nullopt; }
-        return it->second;
-      }
-    };
-
-    inline std::string
-    cli_name(const std::string& name) {
-      if (name.size() == 1) { return "-" + name; }
-      return "--" + name;
-    }
-
-    inline NameIndex
-    build_index(const std::vector<arg::ArgSpec>& args) {
-      NameIndex index;
-      for (std::size_t i = 0; i < args.size(); ++i) {
+    inline void
+    collect_env_vars(
+      const std::vector<arg::ArgSpec>& args,
+      const std::vector<cmd::CommandSpec>& commands,
+      command_index::detail::NameMap<std::optional<std::string>>& vars) {
+      for (const auto& a : args) {
         std::visit(
           [&](const auto& spec) {
             using T = std::decay_t<decltype(spec)>;
-            if constexpr (std::is_same_v<T, arg::FlagSpec>) {
-              for (const auto& name : spec.names) {
-                index.insert(cli_name(name), {i, MatchKind::Flag, 0});
-              }
-            } else if constexpr (std::is_same_v<T, arg::OptionSpec>) {
-              for (const auto& name : spec.names) {
-                index.insert(cli_name(name), {i, MatchKind::Option, 0});
-              }
-            } else if constexpr (std::is_same_v<T, arg::FlagGroupSpec>) {
-              for (std::size_t e = 0; e < spec.entries.size(); ++e) {
-                for (const auto& name : spec.entries[e].names) {
-                  index.insert(cli_name(name), {i, MatchKind::FlagGroup, e});
-                }
+            if constexpr (
+              std::is_same_v<T, arg::FlagSpec> ||
+              std::is_same_v<T, arg::OptionSpec>) {
+              if (spec.env.has_value()) {
+                vars.emplace(spec.env->var, std::nullopt);
               }
             }
-            // PositionalSpec: not indexed
           },
-          args[i]);
+          a);
+      }
+      for (const auto& command : commands) {
+        collect_env_vars(command.args, command.commands, vars);
       }
-      return index;
     }
 
+    inline char**
+    environment() {
+#if defined(__APPLE__)
+      return *_NSGetEnviron();
+#else
+      return environ;
+#endif
+    }
+
+  } // namespace detail
+
+  // The variables a spec binds (at any command level), copied in a single
+  // pass over the environment and looked up by hash instead of a getenv scan
+  // per variable. A snapshot never changes, so one can serve any number of
+  // parses, concurrent ones included, and later setenv calls do not race
+  // with them.
+  class EnvSnapshot {
+  public:
+    explicit EnvSnapshot(const cmd::RootSpec& root) {
+      detail::collect_env_vars(root.args, root.commands, values_);
+      if (values_.empty()) { return; }
+#ifdef _WIN32
+      // Names are case-insensitive here; getenv knows how to match them.
+      for (auto& [var, value] : values_) {
+        if (const char* val = std::getenv(var.c_str())) { value = val; }
+      }
+#else
+      for (char** entry = detail::environment(); entry && *entry; ++entry) {
+        std::string_view text = *entry;
+        auto eq = text.find('=');
+        if (eq == std::string_view::npos) { continue; }
+        auto it = values_.find(text.substr(0, eq));
+        // Like getenv, the first of repeated entries wins.
+        if (it != values_.end() && !it->second.has_value()) {
+          it->second = std::string(text.substr(eq + 1));
+        }
+      }
+#endif
+    }
+
+    std::optional<std::string>
+    get(std::string_view var) const {
+      auto it = values_.find(var);
+      if (it == values_.end()) { return std::nullopt; }
+      return it->second;
+    }
+
+  private:
+    command_index::detail::NameMap<std::optional<std::string>> values_;
+  };
+
+  // An EnvLookup reading a snapshot taken now; its copies share it.
+  inline EnvLookup
+  env_snapshot(const cmd::RootSpec& root) {
+    auto snapshot = std::make_shared<const EnvSnapshot>(root);
+    return [snapshot](const std::string& var) { return snapshot->get(var); };
+  }
+
+  // -------------------------------------------------------------------------
+  // Detail: name index (built per level by cmd::make_table)
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    using cmd::detail::build_index;
+    using cmd::detail::cli_name;
+    using cmd::detail::MatchKind;
+    using cmd::detail::MatchResult;
+    using cmd::detail::NameIndex;
+
     // -----------------------------------------------------------------------
     // Token classification
     // -----------------------------------------------------------------------
@@ -150,7 +447,7 @@ namespace json_commander::parse {
     enum class TokenKind { LongOption, ShortGroup, DoubleDash, Positional };
 
     inline TokenKind
-    classify_token(const std::string& token) {
+    classify_token(std::string_view token) {
       if (token == "--") { return TokenKind::DoubleDash; }
       if (token.size() >= 3 && token[0] == '-' && token[1] == '-') {
         return TokenKind::LongOption;
@@ -161,17 +458,20 @@ namespace json_commander::parse {
       return TokenKind::Positional;
     }
 
+    // Both parts are views into the token, so they stay valid only as long
+    // as the token does.
     struct SplitResult {
-      std::string name;
-      std::optional<std::string> value;
+      std::string_view name;
+      std::optional<std::string_view> value;
     };
 
     inline SplitResult
-    split_long_option(const std::string& token) {
-      auto stripped = token.substr(2); // remove leading --
-      auto eq = stripped.find('=');
-      if (eq == std::string::npos) { return {stripped, std::nullopt}; }
-      return {stripped.substr(0, eq), stripped.substr(eq + 1)};
+    split_long_option(std::string_view token) {
+      auto eq = token.find('=', 2);
+      if (eq == std::string_view::npos) {
+        return {token.substr(2), std::nullopt};
+      }
+      return {token.substr(2, eq - 2), token.substr(eq + 1)};
     }
 
     // -----------------------------------------------------------------------
@@ -179,321 +479,801 @@ namespace json_commander::parse {
     // -----------------------------------------------------------------------
 
     struct LevelOk {
-      nlohmann::json config;
+      // This level followed by those of the subcommands it descended into.
+      std::pmr::vector<LevelValues> levels;
       std::vector<std::string> command_path;
-      std::size_t next_pos;
     };
 
+    // Parsing stopped at an error; the error is in the Diagnostics.
+    struct Stopped {};
+
     using LevelResult = std::variant<
       LevelOk,
       HelpRequest,
       VersionRequest,
       ManpageRequest,
-      CompletionRequest>;
+      CompletionRequest,
+      Stopped>;
+
+    // Errors found so far. Parsing stops at the first one unless all errors
+    // are being collected, in which case the offending token is skipped.
+    struct Diagnostics {
+      bool collect_all = false;
+      std::vector<ErrorInfo> errors = {};
+
+      // Records `error`; returns whether parsing should go on.
+      bool
+      report(ErrorInfo error) {
+        errors.push_back(std::move(error));
+        return collect_all;
+      }
+    };
 
-    inline LevelResult
-    parse_level(
-      const std::vector<arg::ArgSpec>& args,
-      const std::vector<cmd::CommandSpec>& commands,
-      const std::vector<std::string>& tokens,
-      std::size_t start,
+    inline void
+    append(Slot& slot, nlohmann::json value) {
+      if (!slot.value.is_array()) { slot.value = nlohmann::json::array(); }
+      slot.value.push_back(std::move(value));
+    }
+
+    // Records one command-line value in its slot.
+    inline void
+    put(Slot& slot, nlohmann::json value, bool repeated) {
+      if (repeated) {
+        append(slot, std::move(value));
+      } else {
+        slot.value = std::move(value);
+      }
+      slot.source = Source::Cli;
+      ++slot.count;
+    }
+
+    // What a flag match sets its slot to: true, the repetition count, or the
+    // flag group entry's value.
+    inline nlohmann::json
+    flag_value(
+      const Slot& slot, const arg::ArgSpec& spec, const MatchResult& match) {
+      if (match.kind == MatchKind::Flag) {
+        if (std::get<arg::FlagSpec>(spec).repeated) { return slot.count + 1; }
+        return true;
+      }
+      const auto& group = std::get<arg::FlagGroupSpec>(spec);
+      return group.entries[match.entry_index].value;
+    }
+
+    inline void
+    store_flag(
+      Slot& slot, const arg::ArgSpec& spec, const MatchResult& match) {
+      // A repeated flag counts; a repeated flag group collects its values.
+      const bool collect = match.kind == MatchKind::FlagGroup &&
+                           std::get<arg::FlagGroupSpec>(spec).repeated;
+      put(slot, flag_value(slot, spec, match), collect);
+    }
+
+    // -----------------------------------------------------------------------
+    // Abbreviations (opt-in via the schema's "parsing" settings)
+    // -----------------------------------------------------------------------
+
+    inline bool
+    abbreviations_enabled(const cmd::RootSpec& root) {
+      return root.parsing.has_value() &&
+             root.parsing->abbreviations.value_or(false);
+    }
+
+    inline constexpr std::array<std::string_view, 4> builtin_options = {
+      "--help", "--help-man", "--help-completion", "--version"};
+
+    inline bool
+    builtin_applies(std::string_view builtin, bool is_root) {
+      return is_root || builtin != "--version";
+    }
+
+    inline void
+    append_candidate(std::string& list, std::string_view name) {
+      if (!list.empty()) { list += ", "; }
+      list += name;
+    }
+
+    // Resolves a unique prefix of a declared long option. Built-in options
+    // are only matched exactly, but a prefix of one is still ambiguous. An
+    // ambiguous prefix yields nullopt with `candidates` listing the matches.
+    inline std::optional<MatchResult>
+    expand_option(
+      const NameIndex& index,
+      std::string_view prefix,
       bool is_root,
-      const std::optional<std::string>& version) {
-      auto index = build_index(args);
-      nlohmann::json config = nlohmann::json::object();
-      std::vector<std::string> command_path;
+      std::string& candidates) {
+      auto run = index.long_with_prefix(prefix);
+      if (run.empty()) { return std::nullopt; }
 
-      // Track flag counts for repeated flags
-      std::vector<int> flag_counts(args.size(), 0);
+      for (auto builtin : builtin_options) {
+        if (builtin_applies(builtin, is_root) && builtin.starts_with(prefix)) {
+          append_candidate(candidates, builtin);
+        }
+      }
+      auto match = index.lookup_prefix(prefix);
+      if (match.has_value() && candidates.empty()) { return match; }
 
-      // Track positional argument cursor
-      std::size_t pos_cursor = 0;
-      std::vector<std::size_t> positional_indices;
-      for (std::size_t i = 0; i < args.size(); ++i) {
-        if (std::holds_alternative<arg::PositionalSpec>(args[i])) {
-          positional_indices.push_back(i);
+      for (const auto& entry : run) {
+        append_candidate(candidates, entry.first);
+      }
+      return std::nullopt;
+    }
+
+    inline std::optional<command_index::Index::Node>
+    expand_command(
+      const command_index::Index& tree,
+      command_index::Index::Node node,
+      std::string_view prefix,
+      std::string& candidates) {
+      if (prefix.empty()) { return std::nullopt; }
+      auto run = tree.children_with_prefix(node, prefix);
+      if (run.empty()) { return std::nullopt; }
+      if (run.size() == 1) { return run.front().second; }
+
+      for (const auto& entry : run) {
+        append_candidate(candidates, entry.first);
+      }
+      return std::nullopt;
+    }
+
+    // -----------------------------------------------------------------------
+    // Unknown names ("did you mean" suggestions)
+    // -----------------------------------------------------------------------
+
+    inline ErrorInfo
+    unknown_option(
+      const NameIndex& index,
+      std::string_view name,
+      bool is_root,
+      std::size_t token) {
+      std::vector<std::string_view> candidates;
+      candidates.reserve(index.long_names().size() + builtin_options.size());
+      for (auto builtin : builtin_options) {
+        if (builtin_applies(builtin, is_root)) {
+          candidates.push_back(builtin);
         }
       }
+      for (const auto& entry : index.long_names()) {
+        candidates.push_back(entry.first);
+      }
+      // The leading "--" is shared by every candidate, so it does not count
+      // towards the edit budget.
+      auto bound = suggest::default_bound(name.size() - 2);
+      return make_error(
+        ErrorKind::UnknownOption,
+        token,
+        name,
+        "unknown option: " + std::string(name),
+        suggest::nearest(name, candidates, bound));
+    }
+
+    inline ErrorInfo
+    unknown_command(
+      const command_index::Index& tree,
+      command_index::Index::Node node,
+      std::string_view name,
+      std::size_t token) {
+      std::vector<std::string_view> candidates;
+      candidates.reserve(tree.child_count(node));
+      for (const auto& entry : tree.children(node)) {
+        candidates.push_back(entry.first);
+      }
+      auto bound = suggest::default_bound(name.size());
+      return make_error(
+        ErrorKind::UnknownCommand,
+        token,
+        name,
+        "unknown command: " + std::string(name),
+        suggest::nearest(name, candidates, bound));
+    }
+
+    // -----------------------------------------------------------------------
+    // Token cursor
+    // -----------------------------------------------------------------------
+
+    // What the next token has to be, regardless of its spelling.
+    enum class Pending { None, OptionValue, CompletionShell };
+
+    // Push parser: takes the tokens one at a time and keeps just enough
+    // state to go on. parse_tokens feeds it a whole line; interactive
+    // callers keep one between keystrokes (see incremental.hpp). Copying a
+    // cursor copies the slots filled so far and shares everything else, so
+    // a copy is a snapshot the line can be resumed from.
+    class Cursor {
+    public:
+      // `events`, when given, is offered every command-line value and must
+      // outlive the cursor.
+      // The levels' slots are allocated from `memory`, which must outlive
+      // the cursor and whatever finish() returns. A copy allocates from the
+      // default resource.
+      Cursor(
+        const cmd::RootSpec& root,
+        std::shared_ptr<const command_index::Index> tree,
+        const EventHandler* events = nullptr,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+          : root_(&root), tree_(std::move(tree)), events_(events),
+            abbreviate_(abbreviations_enabled(root)), args_(&root.args),
+            commands_(&root.commands), levels_(memory) {
+        open_level(root.table);
+      }
 
-      bool options_terminated = false;
-      std::size_t i = start;
+      // Consumes the next token. Returns false once the line is decided: a
+      // request (--help and the like) was found or an error stopped the
+      // parse. Later tokens are then ignored.
+      bool
+      feed(std::string_view token, Diagnostics& diag) {
+        return feed_at(token, next_token_, diag);
+      }
 
-      while (i < tokens.size()) {
-        const auto& token = tokens[i];
+      // As feed, but errors name token `i` of the command line; tokens read
+      // from a response file are reported at the "@path" argument.
+      bool
+      feed_at(std::string_view token, std::size_t i, Diagnostics& diag) {
+        if (outcome_.has_value()) { return false; }
+        ++next_token_;
+        if (pending_ != Pending::None) { return take_value(token, i, diag); }
 
-        if (!options_terminated) {
+        if (!options_terminated_) {
           auto kind = classify_token(token);
 
           if (kind == TokenKind::DoubleDash) {
-            options_terminated = true;
-            ++i;
-            continue;
+            options_terminated_ = true;
+            return true;
           }
 
           // Check for --help / -h
           if (token == "--help" || token == "-h") {
-            return HelpRequest{command_path};
+            return decide(HelpRequest{command_path_});
           }
 
           // Check for --help-man
-          if (token == "--help-man") { return ManpageRequest{command_path}; }
+          if (token == "--help-man") {
+            return decide(ManpageRequest{command_path_});
+          }
 
           // Check for --help-completion <shell>
           if (token == "--help-completion") {
-            ++i;
-            if (i >= tokens.size()) {
-              throw Error(
-                "--help-completion requires a shell name (bash, zsh, fish)");
-            }
-            const auto& shell = tokens[i];
-            if (shell != "bash" && shell != "zsh" && shell != "fish") {
-              throw Error(
-                "--help-completion: unknown shell '" + shell +
-                "' (expected bash, zsh, or fish)");
-            }
-            return CompletionRequest{shell};
+            await(Pending::CompletionShell, 0, token, i);
+            return true;
           }
 
           // Check for --version at root
-          if (is_root && token == "--version") {
-            if (!version.has_value()) {
-              throw Error("--version: no version defined");
+          if (is_root() && token == "--version") {
+            if (!root_->version.has_value()) {
+              return report(
+                diag,
+                make_error(
+                  ErrorKind::NoVersion,
+                  i,
+                  token,
+                  "--version: no version defined"));
             }
-            return VersionRequest{};
+            return decide(VersionRequest{});
           }
 
           if (kind == TokenKind::LongOption) {
-            auto [name, eq_value] = split_long_option(token);
-            auto match = index.lookup("--" + name);
-            if (!match.has_value()) {
-              throw Error("unknown option: --" + name);
-            }
+            return long_option(token, i, diag);
+          }
+          if (kind == TokenKind::ShortGroup) {
+            return short_group(token, i, diag);
+          }
 
-            if (match->kind == MatchKind::Flag) {
-              auto& flag = std::get<arg::FlagSpec>(args[match->arg_index]);
-              flag_counts[match->arg_index]++;
-              if (flag.repeated) {
-                config[flag.dest] = flag_counts[match->arg_index];
-              } else {
-                config[flag.dest] = true;
-              }
-              ++i;
-              continue;
+          // Check for subcommand match (only when options not terminated)
+          auto sub = tree_->child(node_, token);
+          if (!sub.has_value() && abbreviate_) {
+            std::string candidates;
+            sub = expand_command(*tree_, node_, token, candidates);
+            if (!candidates.empty()) {
+              return report(
+                diag,
+                make_error(
+                  ErrorKind::AmbiguousCommand,
+                  i,
+                  token,
+                  "ambiguous command: " + std::string(token) + " (could be " +
+                    candidates + ")"));
             }
+          }
+          if (sub.has_value()) {
+            descend(*sub, i);
+            return true;
+          }
+        }
 
-            if (match->kind == MatchKind::Option) {
-              auto& opt = std::get<arg::OptionSpec>(args[match->arg_index]);
-              std::string raw_value;
-              if (eq_value.has_value()) {
-                raw_value = *eq_value;
-              } else {
-                ++i;
-                if (i >= tokens.size()) {
-                  throw Error("option --" + name + " requires a value");
-                }
-                raw_value = tokens[i];
-              }
-              nlohmann::json converted;
-              try {
-                converted = opt.converter.parse(raw_value);
-              } catch (const conv::Error& e) {
-                throw Error("option --" + name + ": " + e.what());
-              }
-              if (opt.repeated) {
-                if (!config.contains(opt.dest)) {
-                  config[opt.dest] = nlohmann::json::array();
-                }
-                config[opt.dest].push_back(converted);
-              } else {
-                config[opt.dest] = converted;
-              }
-              ++i;
-              continue;
-            }
+        return positional(token, i, diag);
+      }
 
-            if (match->kind == MatchKind::FlagGroup) {
-              auto& group =
-                std::get<arg::FlagGroupSpec>(args[match->arg_index]);
-              auto& entry = group.entries[match->entry_index];
-              flag_counts[match->arg_index]++;
-              if (group.repeated) {
-                if (!config.contains(group.dest)) {
-                  config[group.dest] = nlohmann::json::array();
-                }
-                config[group.dest].push_back(entry.value);
-              } else {
-                config[group.dest] = entry.value;
-              }
-              ++i;
-              continue;
-            }
+      // Ends the line. An option still waiting for its value is an error.
+      LevelResult
+      finish(Diagnostics& diag) && {
+        if (outcome_.has_value()) { return std::move(*outcome_); }
+        if (pending_ == Pending::OptionValue) {
+          diag.report(make_error(
+            ErrorKind::MissingValue,
+            pending_token_,
+            pending_name_,
+            "option " + pending_name_ + " requires a value"));
+          return Stopped{};
+        }
+        if (pending_ == Pending::CompletionShell) {
+          diag.report(make_error(
+            ErrorKind::MissingValue,
+            pending_token_,
+            pending_name_,
+            "--help-completion requires a shell name (bash, zsh, fish)"));
+          return Stopped{};
+        }
+        return LevelOk{std::move(levels_), std::move(command_path_)};
+      }
+
+      // Records `error`; returns whether parsing goes on.
+      bool
+      report(Diagnostics& diag, ErrorInfo error) {
+        if (diag.report(std::move(error))) { return true; }
+        return decide(Stopped{});
+      }
+
+      // State of the line so far, for callers looking ahead.
+
+      bool
+      decided() const noexcept {
+        return outcome_.has_value();
+      }
+
+      command_index::Index::Node
+      node() const noexcept {
+        return node_;
+      }
+
+      bool
+      is_root() const noexcept {
+        return node_ == command_index::Index::root;
+      }
+
+      const std::vector<arg::ArgSpec>&
+      args() const noexcept {
+        return *args_;
+      }
+
+      const std::vector<std::string>&
+      command_path() const noexcept {
+        return command_path_;
+      }
+
+      const std::pmr::vector<LevelValues>&
+      levels() const noexcept {
+        return levels_;
+      }
+
+      bool
+      options_terminated() const noexcept {
+        return options_terminated_;
+      }
+
+      Pending
+      pending() const noexcept {
+        return pending_;
+      }
+
+      // The option waiting for its value (Pending::OptionValue only).
+      const arg::OptionSpec&
+      pending_option() const {
+        return std::get<arg::OptionSpec>((*args_)[pending_arg_]);
+      }
+
+      // Position among this level's positionals of the one the next plain
+      // word fills; nullopt when they are all filled.
+      std::optional<std::size_t>
+      next_positional() const {
+        if (pos_cursor_ >= table().positionals.size()) { return std::nullopt; }
+        return pos_cursor_;
+      }
+
+      // Number of tokens fed so far, response file contents included.
+      std::size_t
+      position() const noexcept {
+        return next_token_;
+      }
+
+    private:
+      const cmd::LevelTable&
+      table() const {
+        return *levels_.back().table;
+      }
+
+      Slot&
+      slot_for(std::size_t arg_index) {
+        auto& level = levels_.back();
+        return level.slots[level.table->key_of[arg_index]];
+      }
+
+      void
+      open_level(const std::shared_ptr<const cmd::LevelTable>& level_table) {
+        auto table = cmd::shared_table(*args_, level_table);
+        std::pmr::vector<Slot> slots(
+          table->keys.size(), levels_.get_allocator());
+        levels_.push_back({std::move(table), std::move(slots)});
+      }
+
+      void
+      descend(command_index::Index::Node sub, std::size_t i) {
+        const auto& cmd = (*commands_)[tree_->position(sub)];
+        if (events_ != nullptr) { (*events_)(CommandEvent{cmd.name, i}); }
+        command_path_.push_back(cmd.name);
+        node_ = sub;
+        args_ = &cmd.args;
+        commands_ = &cmd.commands;
+        pos_cursor_ = 0;
+        open_level(cmd.table);
+      }
+
+      bool
+      decide(LevelResult outcome) {
+        outcome_ = std::move(outcome);
+        return false;
+      }
+
+      // Offers a value to the event handler. When the handler takes it, the
+      // slot only counts it.
+      bool
+      offer(Slot& slot, const Event& event) {
+        if (!(*events_)(event)) { return false; }
+        slot.streamed = true;
+        slot.source = Source::Cli;
+        ++slot.count;
+        return true;
+      }
+
+      void
+      flag(const MatchResult& match, std::string_view name, std::size_t i) {
+        auto& slot = slot_for(match.arg_index);
+        const auto& spec = args()[match.arg_index];
+        if (
+          events_ != nullptr &&
+          offer(
+            slot,
+            FlagEvent{
+              cmd::detail::dest_of(spec),
+              name,
+              flag_value(slot, spec, match),
+              i})) {
+          return;
+        }
+        store_flag(slot, spec, match);
+      }
+
+      void
+      await(
+        Pending what,
+        std::size_t arg_index,
+        std::string_view name,
+        std::size_t token) {
+        pending_ = what;
+        pending_arg_ = arg_index;
+        pending_name_ = std::string(name);
+        pending_token_ = token;
+      }
+
+      bool
+      take_value(std::string_view token, std::size_t i, Diagnostics& diag) {
+        auto what = std::exchange(pending_, Pending::None);
+        if (what == Pending::CompletionShell) {
+          if (token != "bash" && token != "zsh" && token != "fish") {
+            return report(
+              diag,
+              make_error(
+                ErrorKind::InvalidShell,
+                i,
+                pending_name_,
+                "--help-completion: unknown shell '" + std::string(token) +
+                  "' (expected bash, zsh, or fish)"));
           }
+          return decide(CompletionRequest{std::string(token)});
+        }
+        return store(pending_arg_, pending_name_, token, i, diag);
+      }
 
-          if (kind == TokenKind::ShortGroup) {
-            // Process each character in the short group
-            for (std::size_t c = 1; c < token.size(); ++c) {
-              std::string short_name = std::string("-") + token[c];
-              auto match = index.lookup(short_name);
-              if (!match.has_value()) {
-                throw Error("unknown option: " + short_name);
-              }
+      bool
+      store(
+        std::size_t arg_index,
+        std::string_view display,
+        std::string_view raw_value,
+        std::size_t i,
+        Diagnostics& diag) {
+        const auto& opt = std::get<arg::OptionSpec>((*args_)[arg_index]);
+        auto& slot = slot_for(arg_index);
+        // The converter reads the token bytes in place: only the value it
+        // produces is allocated.
+        std::string error;
+        auto converted = conv::try_convert(opt.converter, raw_value, error);
+        if (!converted.has_value()) {
+          slot.rejected = true;
+          return report(
+            diag,
+            make_error(
+              ErrorKind::InvalidValue,
+              i,
+              display,
+              "option " + std::string(display) + ": " + error));
+        }
+        if (
+          events_ != nullptr &&
+          offer(slot, OptionEvent{opt.dest, display, *converted, i})) {
+          return true;
+        }
+        put(slot, std::move(*converted), opt.repeated);
+        return true;
+      }
 
-              if (match->kind == MatchKind::Flag) {
-                auto& flag = std::get<arg::FlagSpec>(args[match->arg_index]);
-                flag_counts[match->arg_index]++;
-                if (flag.repeated) {
-                  config[flag.dest] = flag_counts[match->arg_index];
-                } else {
-                  config[flag.dest] = true;
-                }
-                continue;
-              }
+      bool
+      long_option(std::string_view token, std::size_t i, Diagnostics& diag) {
+        const auto& index = table().names;
+        auto [name, eq_value] = split_long_option(token);
+        // "--name" without any "=value" suffix, still a view into token
+        auto long_name = token.substr(0, name.size() + 2);
+        auto match = index.lookup(long_name);
+        if (!match.has_value() && abbreviate_) {
+          std::string candidates;
+          match = expand_option(index, long_name, is_root(), candidates);
+          if (!candidates.empty()) {
+            return report(
+              diag,
+              make_error(
+                ErrorKind::AmbiguousOption,
+                i,
+                long_name,
+                "ambiguous option: " + std::string(long_name) +
+                  " (could be " + candidates + ")"));
+          }
+        }
+        if (!match.has_value()) {
+          return report(diag, unknown_option(index, long_name, is_root(), i));
+        }
 
-              if (match->kind == MatchKind::Option) {
-                auto& opt = std::get<arg::OptionSpec>(args[match->arg_index]);
-                // If not the last character in the group, error
-                if (c != token.size() - 1) {
-                  throw Error(
-                    "option " + short_name +
-                    " requires a value and must be last in a short group");
-                }
-                ++i;
-                if (i >= tokens.size()) {
-                  throw Error("option " + short_name + " requires a value");
-                }
-                std::string raw_value = tokens[i];
-                nlohmann::json converted;
-                try {
-                  converted = opt.converter.parse(raw_value);
-                } catch (const conv::Error& e) {
-                  throw Error("option " + short_name + ": " + e.what());
-                }
-                if (opt.repeated) {
-                  if (!config.contains(opt.dest)) {
-                    config[opt.dest] = nlohmann::json::array();
-                  }
-                  config[opt.dest].push_back(converted);
-                } else {
-                  config[opt.dest] = converted;
-                }
-                continue;
-              }
+        if (match->kind != MatchKind::Option) {
+          flag(*match, long_name, i);
+          return true;
+        }
+        if (eq_value.has_value()) {
+          return store(match->arg_index, long_name, *eq_value, i, diag);
+        }
+        await(Pending::OptionValue, match->arg_index, long_name, i);
+        return true;
+      }
 
-              if (match->kind == MatchKind::FlagGroup) {
-                auto& group =
-                  std::get<arg::FlagGroupSpec>(args[match->arg_index]);
-                auto& entry = group.entries[match->entry_index];
-                flag_counts[match->arg_index]++;
-                if (group.repeated) {
-                  if (!config.contains(group.dest)) {
-                    config[group.dest] = nlohmann::json::array();
-                  }
-                  config[group.dest].push_back(entry.value);
-                } else {
-                  config[group.dest] = entry.value;
-                }
-                continue;
-              }
+      bool
+      short_group(std::string_view token, std::size_t i, Diagnostics& diag) {
+        const auto& index = table().names;
+        // Process each character in the short group
+        for (std::size_t c = 1; c < token.size(); ++c) {
+          std::string short_name{'-', token[c]};
+          auto match = index.lookup_short(token[c]);
+          if (!match.has_value()) {
+            if (!report(
+                  diag,
+                  make_error(
+                    ErrorKind::UnknownOption,
+                    i,
+                    short_name,
+                    "unknown option: " + short_name))) {
+              return false;
             }
-            ++i;
             continue;
           }
-        }
 
-        // Positional or subcommand
-        // Check for subcommand match (only when options not terminated)
-        if (!options_terminated) {
-          bool found_command = false;
-          for (const auto& cmd : commands) {
-            if (cmd.name == tokens[i]) {
-              command_path.push_back(cmd.name);
-              auto sub_result = parse_level(
-                cmd.args, cmd.commands, tokens, i + 1, false, std::nullopt);
-
-              // Propagate help/version from sub-level
-              if (auto* help = std::get_if<HelpRequest>(&sub_result)) {
-                // Prepend our accumulated command_path
-                std::vector<std::string> full_path = command_path;
-                for (auto& p : help->command_path) {
-                  full_path.push_back(std::move(p));
-                }
-                return HelpRequest{std::move(full_path)};
-              }
-              if (auto* manpage = std::get_if<ManpageRequest>(&sub_result)) {
-                std::vector<std::string> full_path = command_path;
-                for (auto& p : manpage->command_path) {
-                  full_path.push_back(std::move(p));
-                }
-                return ManpageRequest{std::move(full_path)};
-              }
-              if (std::holds_alternative<VersionRequest>(sub_result)) {
-                return VersionRequest{};
-              }
-              if (auto* comp = std::get_if<CompletionRequest>(&sub_result)) {
-                return *comp;
-              }
-
-              auto& sub_ok = std::get<LevelOk>(sub_result);
-              config["command"] = cmd.name;
-              config[cmd.name] = std::move(sub_ok.config);
-              for (auto& p : sub_ok.command_path) {
-                command_path.push_back(std::move(p));
-              }
-              i = sub_ok.next_pos;
-              found_command = true;
-              break;
+          if (match->kind != MatchKind::Option) {
+            flag(*match, short_name, i);
+            continue;
+          }
+          // If not the last character in the group, error
+          if (c != token.size() - 1) {
+            if (!report(
+                  diag,
+                  make_error(
+                    ErrorKind::MisplacedOption,
+                    i,
+                    short_name,
+                    "option " + short_name +
+                      " requires a value and must be last in a short "
+                      "group"))) {
+              return false;
             }
+            continue;
           }
-          if (found_command) { continue; }
+          await(Pending::OptionValue, match->arg_index, short_name, i);
         }
+        return true;
+      }
 
-        // Treat as positional
-        if (pos_cursor >= positional_indices.size()) {
-          throw Error("unexpected positional argument: " + tokens[i]);
+      bool
+      positional(std::string_view token, std::size_t i, Diagnostics& diag) {
+        const auto& positional_indices = table().positionals;
+        if (pos_cursor_ >= positional_indices.size()) {
+          // With subcommands to choose from, a stray word is most likely a
+          // mistyped command name.
+          auto error =
+            !options_terminated_ && tree_->child_count(node_) > 0
+              ? unknown_command(*tree_, node_, token, i)
+              : make_error(
+                  ErrorKind::UnexpectedArgument,
+                  i,
+                  token,
+                  "unexpected positional argument: " + std::string(token));
+          return report(diag, std::move(error));
         }
-        auto pos_idx = positional_indices[pos_cursor];
-        auto& pos = std::get<arg::PositionalSpec>(args[pos_idx]);
-        nlohmann::json converted;
-        try {
-          converted = pos.converter.parse(tokens[i]);
-        } catch (const conv::Error& e) {
-          throw Error("positional " + pos.name + ": " + e.what());
-        }
-        if (pos.repeated) {
-          if (!config.contains(pos.dest)) {
-            config[pos.dest] = nlohmann::json::array();
+        auto pos_idx = positional_indices[pos_cursor_];
+        const auto& pos = std::get<arg::PositionalSpec>(args()[pos_idx]);
+        auto& slot = slot_for(pos_idx);
+        std::string error;
+        auto converted = conv::try_convert(pos.converter, token, error);
+        if (!converted.has_value()) {
+          if (!report(
+                diag,
+                make_error(
+                  ErrorKind::InvalidValue,
+                  i,
+                  pos.name,
+                  "positional " + pos.name + ": " + error))) {
+            return false;
           }
-          config[pos.dest].push_back(converted);
-        } else {
-          config[pos.dest] = converted;
-          ++pos_cursor;
+          // Later tokens still fill the positionals after this one.
+          slot.rejected = true;
+          if (!pos.repeated) { ++pos_cursor_; }
+          return true;
+        }
+        if (!pos.repeated) { ++pos_cursor_; }
+        if (
+          events_ != nullptr &&
+          offer(slot, PositionalEvent{pos.dest, *converted, i})) {
+          return true;
+        }
+        put(slot, std::move(*converted), pos.repeated);
+        return true;
+      }
+
+      const cmd::RootSpec* root_;
+      std::shared_ptr<const command_index::Index> tree_;
+      const EventHandler* events_;
+      bool abbreviate_;
+
+      // The command level being parsed.
+      command_index::Index::Node node_ = command_index::Index::root;
+      const std::vector<arg::ArgSpec>* args_;
+      const std::vector<cmd::CommandSpec>* commands_;
+      std::size_t pos_cursor_ = 0;
+      bool options_terminated_ = false;
+
+      // Every level entered so far; the last one is being parsed.
+      std::pmr::vector<LevelValues> levels_;
+      std::vector<std::string> command_path_;
+
+      std::size_t next_token_ = 0;
+      Pending pending_ = Pending::None;
+      std::size_t pending_arg_ = 0;
+      std::string pending_name_;
+      std::size_t pending_token_ = 0;
+
+      std::optional<LevelResult> outcome_;
+    };
+
+    // -----------------------------------------------------------------------
+    // Response files (opt-in via the schema's "parsing" settings)
+    // -----------------------------------------------------------------------
+
+    inline constexpr int default_response_depth = 8;
+
+    inline bool
+    feed_expanded(
+      Cursor& cursor,
+      std::string_view token,
+      std::size_t origin,
+      const model::ResponseFiles* responses,
+      int depth,
+      Diagnostics& diag);
+
+    // Feeds the arguments listed in the response file `path`. The tokens
+    // are views into the mapping, which only has to outlive the feeding:
+    // the cursor copies whatever it keeps.
+    inline bool
+    feed_response_file(
+      Cursor& cursor,
+      std::string_view path,
+      std::size_t origin,
+      const model::ResponseFiles& responses,
+      int depth,
+      Diagnostics& diag) {
+      const std::string display = "@" + std::string(path);
+      if (depth > responses.max_depth.value_or(default_response_depth)) {
+        return cursor.report(
+          diag,
+          make_error(
+            ErrorKind::BadResponseFile,
+            origin,
+            display,
+            "response file " + std::string(path) + ": nested too deeply"));
+      }
+      std::string error;
+      auto mapping = mapped_file::try_open(std::string(path), error);
+      if (!mapping.has_value()) {
+        return cursor.report(
+          diag,
+          make_error(
+            ErrorKind::BadResponseFile,
+            origin,
+            display,
+            "response file " + std::string(path) + ": " + error));
+      }
+
+      const char delimiter = responses.delimiter == "nul" ? '\0' : '\n';
+      std::string_view rest = mapping->view();
+      while (!rest.empty()) {
+        auto end = std::min(rest.find(delimiter), rest.size());
+        auto token = rest.substr(0, end);
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+        if (delimiter == '\n' && token.ends_with('\r')) {
+          token.remove_suffix(1);
+        }
+        if (token.empty()) { continue; }
+        if (!feed_expanded(
+              cursor, token, origin, &responses, depth + 1, diag)) {
+          return false;
         }
-        ++i;
       }
+      return true;
+    }
 
-      return LevelOk{config, command_path, i};
+    // Feeds `token`, first replacing an "@path" argument by the contents of
+    // the file when response files are enabled. `depth` counts the response
+    // files `token` came through.
+    inline bool
+    feed_expanded(
+      Cursor& cursor,
+      std::string_view token,
+      std::size_t origin,
+      const model::ResponseFiles* responses,
+      int depth,
+      Diagnostics& diag) {
+      if (
+        responses != nullptr && token.size() > 1 && token[0] == '@' &&
+        !cursor.options_terminated()) {
+        return feed_response_file(
+          cursor, token.substr(1), origin, *responses, depth, diag);
+      }
+      return cursor.feed_at(token, origin, diag);
+    }
+
+    inline const model::ResponseFiles*
+    response_files(const cmd::RootSpec& root) {
+      if (!root.parsing.has_value() || !root.parsing->response_files) {
+        return nullptr;
+      }
+      return &*root.parsing->response_files;
     }
 
     // -----------------------------------------------------------------------
     // Post-processing: env fallback
     // -----------------------------------------------------------------------
 
-    inline void
+    // Returns false when an error stops the parse.
+    inline bool
     apply_env(
-      nlohmann::json& config,
+      LevelValues& level,
       const std::vector<arg::ArgSpec>& args,
-      const EnvLookup& env) {
-      for (const auto& a : args) {
-        std::visit(
-          [&](const auto& spec) {
+      const EnvLookup& env,
+      Diagnostics& diag) {
+      const auto& table = *level.table;
+      for (auto idx : table.env_bound) {
+        auto& slot = level.slots[table.key_of[idx]];
+        auto error = std::visit(
+          [&](const auto& spec) -> std::optional<ErrorInfo> {
             using T = std::decay_t<decltype(spec)>;
             if constexpr (std::is_same_v<T, arg::FlagSpec>) {
-              if (config.contains(spec.dest) && config[spec.dest] != false) {
-                return; // already set by CLI
+              if (slot.source != Source::Unset && slot.value != false) {
+                return std::nullopt; // already set by CLI
               }
-              if (!spec.env.has_value()) { return; }
+              if (!spec.env.has_value()) { return std::nullopt; }
               auto val = env(spec.env->var);
-              if (!val.has_value()) { return; }
+              if (!val.has_value()) { return std::nullopt; }
               auto lower = *val;
               std::transform(
                 lower.begin(),
@@ -501,30 +1281,83 @@ namespace json_commander::parse {
                 lower.begin(),
                 [](unsigned char ch) { return std::tolower(ch); });
               if (lower == "true" || lower == "1") {
-                config[spec.dest] = true;
+                slot.value = true;
               } else if (lower == "false" || lower == "0") {
-                config[spec.dest] = false;
+                slot.value = false;
               } else {
-                throw Error(
+                return make_error(
+                  ErrorKind::InvalidEnv,
+                  std::nullopt,
+                  spec.env->var,
                   "env " + spec.env->var + ": expected boolean value, got '" +
-                  *val + "'");
+                    *val + "'");
               }
+              slot.source = Source::Env;
             } else if constexpr (std::is_same_v<T, arg::OptionSpec>) {
-              if (config.contains(spec.dest)) {
-                return; // already set by CLI
+              if (slot.source != Source::Unset || slot.rejected) {
+                return std::nullopt; // already set by CLI
               }
-              if (!spec.env.has_value()) { return; }
+              if (!spec.env.has_value()) { return std::nullopt; }
               auto val = env(spec.env->var);
-              if (!val.has_value()) { return; }
-              try {
-                config[spec.dest] = spec.converter.parse(*val);
-              } catch (const conv::Error& e) {
-                throw Error("env " + spec.env->var + ": " + e.what());
+              if (!val.has_value()) { return std::nullopt; }
+              std::string error;
+              auto converted = conv::try_convert(spec.converter, *val, error);
+              if (!converted.has_value()) {
+                slot.rejected = true;
+                return make_error(
+                  ErrorKind::InvalidEnv,
+                  std::nullopt,
+                  spec.env->var,
+                  "env " + spec.env->var + ": " + error);
               }
+              slot.value = std::move(*converted);
+              slot.source = Source::Env;
             }
             // FlagGroupSpec and PositionalSpec have no env
+            return std::nullopt;
           },
-          a);
+          args[idx]);
+        if (error.has_value() && !diag.report(std::move(*error))) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Post-processing: config files
+    // -----------------------------------------------------------------------
+
+    // Fills what the command line and the environment left unset from
+    // `values`, this level's object of the merged config files (see
+    // config_file.hpp). File values are already typed and checked against
+    // the config file schema, so they are taken as they are, except that
+    // lists the argument packs are packed.
+    inline void
+    apply_files(
+      LevelValues& level,
+      const std::vector<arg::ArgSpec>& args,
+      const nlohmann::json& values) {
+      const auto& table = *level.table;
+      for (std::size_t i = 0; i < args.size(); ++i) {
+        auto& slot = level.slots[table.key_of[i]];
+        if (slot.source != Source::Unset || slot.rejected) { continue; }
+        auto it = values.find(cmd::detail::dest_of(args[i]));
+        if (it == values.end()) { continue; }
+        slot.value = std::visit(
+          [&](const auto& spec) -> nlohmann::json {
+            using T = std::decay_t<decltype(spec)>;
+            if constexpr (
+              std::is_same_v<T, arg::OptionSpec> ||
+              std::is_same_v<T, arg::PositionalSpec>) {
+              return arg::detail::typed_value(
+                spec.converter, spec.repeated, *it);
+            } else {
+              return *it;
+            }
+          },
+          args[i]);
+        slot.source = Source::File;
       }
     }
 
@@ -533,31 +1366,28 @@ namespace json_commander::parse {
     // -----------------------------------------------------------------------
 
     inline void
-    apply_defaults(
-      nlohmann::json& config, const std::vector<arg::ArgSpec>& args) {
-      for (const auto& a : args) {
+    apply_defaults(LevelValues& level, const std::vector<arg::ArgSpec>& args) {
+      const auto& table = *level.table;
+      for (std::size_t i = 0; i < args.size(); ++i) {
+        auto& slot = level.slots[table.key_of[i]];
+        if (slot.source != Source::Unset || slot.rejected) { continue; }
         std::visit(
           [&](const auto& spec) {
             using T = std::decay_t<decltype(spec)>;
             if constexpr (std::is_same_v<T, arg::FlagSpec>) {
-              if (!config.contains(spec.dest)) { config[spec.dest] = false; }
-            } else if constexpr (std::is_same_v<T, arg::OptionSpec>) {
-              if (
-                !config.contains(spec.dest) && spec.default_value.has_value()) {
-                config[spec.dest] = *spec.default_value;
-              }
-            } else if constexpr (std::is_same_v<T, arg::PositionalSpec>) {
-              if (
-                !config.contains(spec.dest) && spec.default_value.has_value()) {
-                config[spec.dest] = *spec.default_value;
-              }
+              slot.value = false;
+              slot.source = Source::Default;
             } else if constexpr (std::is_same_v<T, arg::FlagGroupSpec>) {
-              if (!config.contains(spec.dest)) {
-                config[spec.dest] = spec.default_value;
+              slot.value = spec.default_value;
+              slot.source = Source::Default;
+            } else {
+              if (spec.default_value.has_value()) {
+                slot.value = *spec.default_value;
+                slot.source = Source::Default;
               }
             }
           },
-          a);
+          args[i]);
       }
     }
 
@@ -565,100 +1395,390 @@ namespace json_commander::parse {
     // Post-processing: validation
     // -----------------------------------------------------------------------
 
-    inline void
+    // Returns false when an error stops the parse. Slots whose value was
+    // rejected already have an error and are not validated again; streamed
+    // values are the event handler's to check.
+    inline bool
     run_validators(
-      const nlohmann::json& config, const std::vector<arg::ArgSpec>& args) {
-      for (const auto& a : args) {
-        std::visit(
-          [&](const auto& spec) {
+      const LevelValues& level,
+      const std::vector<arg::ArgSpec>& args,
+      Diagnostics& diag) {
+      const auto& table = *level.table;
+      for (std::size_t i = 0; i < args.size(); ++i) {
+        auto error = std::visit(
+          [&](const auto& spec) -> std::optional<ErrorInfo> {
             using T = std::decay_t<decltype(spec)>;
-            if constexpr (std::is_same_v<T, arg::OptionSpec>) {
+            if constexpr (
+              std::is_same_v<T, arg::OptionSpec> ||
+              std::is_same_v<T, arg::PositionalSpec>) {
+              const auto& slot = level.slots[table.key_of[i]];
+              if (slot.rejected || slot.streamed) { return std::nullopt; }
               std::optional<nlohmann::json> val;
-              if (config.contains(spec.dest)) { val = config[spec.dest]; }
-              try {
-                spec.validator.check(spec.dest, val);
-              } catch (const validate::Error& e) {
-                throw Error(std::string(e.what()));
-              }
-            } else if constexpr (std::is_same_v<T, arg::PositionalSpec>) {
-              std::optional<nlohmann::json> val;
-              if (config.contains(spec.dest)) { val = config[spec.dest]; }
-              try {
-                spec.validator.check(spec.dest, val);
-              } catch (const validate::Error& e) {
-                throw Error(std::string(e.what()));
+              if (slot.source != Source::Unset) { val = slot.value; }
+              auto message =
+                validate::try_validate(spec.validator, spec.dest, val);
+              if (message.has_value()) {
+                return make_error(
+                  ErrorKind::ValidationFailed,
+                  std::nullopt,
+                  spec.dest,
+                  *message);
               }
             }
+            return std::nullopt;
           },
-          a);
+          args[i]);
+        if (error.has_value() && !diag.report(std::move(*error))) {
+          return false;
+        }
       }
+      return true;
     }
 
     // -----------------------------------------------------------------------
-    // Recursive post-processing across command levels
+    // Post-processing across command levels
     // -----------------------------------------------------------------------
 
-    inline void
+    inline bool
     post_process(
-      nlohmann::json& config,
-      const std::vector<arg::ArgSpec>& args,
-      const std::vector<cmd::CommandSpec>& commands,
+      std::pmr::vector<LevelValues>& levels,
+      const cmd::RootSpec& root,
+      const command_index::Index& tree,
       const std::vector<std::string>& command_path,
-      std::size_t path_index,
-      const EnvLookup& env) {
-      apply_env(config, args, env);
-      apply_defaults(config, args);
-      run_validators(config, args);
-
-      if (path_index < command_path.size()) {
-        const auto& cmd_name = command_path[path_index];
-        for (const auto& cmd : commands) {
-          if (cmd.name == cmd_name) {
-            post_process(
-              config[cmd_name],
-              cmd.args,
-              cmd.commands,
-              command_path,
-              path_index + 1,
-              env);
-            break;
-          }
+      const EnvLookup& env,
+      const nlohmann::json* files,
+      Diagnostics& diag) {
+      auto node = command_index::Index::root;
+      for (std::size_t depth = 0; depth < levels.size(); ++depth) {
+        const auto* cmd = tree.resolve(root, node);
+        const auto& args = cmd ? cmd->args : root.args;
+        if (!apply_env(levels[depth], args, env, diag)) { return false; }
+        if (files != nullptr) { apply_files(levels[depth], args, *files); }
+        apply_defaults(levels[depth], args);
+        if (!run_validators(levels[depth], args, diag)) { return false; }
+
+        if (depth >= command_path.size()) { break; }
+        node = *tree.child(node, command_path[depth]);
+        // A subcommand's file values are nested under its name.
+        if (files != nullptr) {
+          auto it = files->find(command_path[depth]);
+          files = it != files->end() && it->is_object() ? &*it : nullptr;
+        }
+      }
+      return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Materialization
+    // -----------------------------------------------------------------------
+
+    // Builds the nested config object from the accumulated slots. This is
+    // the only place the parser touches nlohmann::json objects by key.
+    inline nlohmann::json
+    materialize(
+      const std::pmr::vector<LevelValues>& levels,
+      const std::vector<std::string>& command_path) {
+      nlohmann::json config;
+      for (std::size_t depth = levels.size(); depth-- > 0;) {
+        const auto& level = levels[depth];
+        nlohmann::json object = nlohmann::json::object();
+        for (std::size_t k = 0; k < level.slots.size(); ++k) {
+          const auto& slot = level.slots[k];
+          if (slot.source == Source::Unset) { continue; }
+          if (slot.streamed && slot.value.is_null()) { continue; }
+          object[level.table->keys[k]] = slot.value;
         }
+        if (depth < command_path.size()) {
+          object["command"] = command_path[depth];
+          object[command_path[depth]] = std::move(config);
+        }
+        config = std::move(object);
       }
+      return config;
     }
 
   } // namespace detail
 
   // -------------------------------------------------------------------------
-  // Top-level parse function
+  // Top-level parse functions
   // -------------------------------------------------------------------------
 
-  inline ParseResult
-  parse(
-    const cmd::RootSpec& root,
-    const std::vector<std::string>& args,
-    EnvLookup env = default_env_lookup()) {
-    auto level_result = detail::parse_level(
-      root.args, root.commands, args, 0, true, root.version);
+  namespace detail {
+
+    // Turns a finished line into the ParseResult: requests pass through,
+    // parsed levels get env fallback, config file values, defaults and
+    // validation. `files` is the merged config files' object, if any.
+    inline ParseResult
+    settle(
+      const cmd::RootSpec& root,
+      const command_index::Index& tree,
+      LevelResult level_result,
+      const EnvLookup& env,
+      Diagnostics& diag,
+      const nlohmann::json* files = nullptr) {
+      if (auto* help = std::get_if<HelpRequest>(&level_result)) {
+        return std::move(*help);
+      }
+      if (auto* manpage = std::get_if<ManpageRequest>(&level_result)) {
+        return std::move(*manpage);
+      }
+      if (std::holds_alternative<VersionRequest>(level_result)) {
+        return VersionRequest{};
+      }
+      if (auto* comp = std::get_if<CompletionRequest>(&level_result)) {
+        return std::move(*comp);
+      }
+      if (std::holds_alternative<Stopped>(level_result)) {
+        return ParseErrors{};
+      }
+
+      auto& ok = std::get<LevelOk>(level_result);
+      if (!post_process(
+            ok.levels, root, tree, ok.command_path, env, files, diag)) {
+        return ParseErrors{};
+      }
+
+      auto config = materialize(ok.levels, ok.command_path);
+      return ParseOk{
+        std::move(config), std::move(ok.command_path), std::move(ok.levels)};
+    }
+
+    // Runs the parser, leaving any errors in `diag`. Requests (--help and
+    // the like) are returned even when earlier tokens had errors; callers
+    // check `diag` first.
+    inline ParseResult
+    parse_tokens(
+      const cmd::RootSpec& root,
+      std::span<const std::string_view> tokens,
+      const EnvLookup& env,
+      Diagnostics& diag,
+      const EventHandler* events = nullptr,
+      const nlohmann::json* files = nullptr,
+      std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+      auto tree = cmd::shared_index(root);
+      Cursor cursor(root, tree, events, memory);
+      const auto* responses = response_files(root);
+      for (std::size_t i = 0; i < tokens.size(); ++i) {
+        if (!feed_expanded(cursor, tokens[i], i, responses, 0, diag)) {
+          break;
+        }
+      }
+      return settle(
+        root, *tree, std::move(cursor).finish(diag), env, diag, files);
+    }
 
-    if (auto* help = std::get_if<HelpRequest>(&level_result)) {
-      return std::move(*help);
+    inline TryResult
+    first_error(
+      const cmd::RootSpec& root,
+      std::span<const std::string_view> tokens,
+      const EnvLookup& env,
+      const EventHandler* events = nullptr,
+      const nlohmann::json* files = nullptr,
+      std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+      Diagnostics diag;
+      auto result =
+        parse_tokens(root, tokens, env, diag, events, files, memory);
+      if (!diag.errors.empty()) {
+        return TryResult{std::move(diag.errors.front())};
+      }
+      return TryResult{std::move(result)};
     }
-    if (auto* manpage = std::get_if<ManpageRequest>(&level_result)) {
-      return std::move(*manpage);
+
+    inline ParseResult
+    all_errors(
+      const cmd::RootSpec& root,
+      std::span<const std::string_view> tokens,
+      const EnvLookup& env,
+      const nlohmann::json* files = nullptr,
+      std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+      Diagnostics diag;
+      diag.collect_all = true;
+      auto result =
+        parse_tokens(root, tokens, env, diag, nullptr, files, memory);
+      if (!diag.errors.empty()) { return ParseErrors{std::move(diag.errors)}; }
+      return result;
     }
-    if (std::holds_alternative<VersionRequest>(level_result)) {
-      return VersionRequest{};
+
+    inline std::pmr::vector<std::string_view>
+    argv_tokens(
+      int argc, const char* const* argv, std::pmr::memory_resource* memory) {
+      std::pmr::vector<std::string_view> tokens(memory);
+      if (argv != nullptr && argc > 1) {
+        tokens.reserve(static_cast<std::size_t>(argc - 1));
+        for (int i = 1; i < argc; ++i) {
+          tokens.emplace_back(argv[i]);
+        }
+      }
+      return tokens;
     }
-    if (auto* comp = std::get_if<CompletionRequest>(&level_result)) {
-      return *comp;
+
+    inline ParseResult
+    value_or_throw(TryResult result) {
+      if (!result) { throw Error(result.error()); }
+      return std::move(result).value();
     }
 
-    auto& ok = std::get<detail::LevelOk>(level_result);
-    detail::post_process(
-      ok.config, root.args, root.commands, ok.command_path, 0, env);
+  } // namespace detail
+
+  // Reports user errors as an ErrorInfo instead of throwing parse::Error.
+  // Built-in converters and validators are checked without exceptions too;
+  // custom ones that throw conv::Error or validate::Error still work, at
+  // the cost of the throw. `files`, when given, is the merged config files
+  // (config_file::load): it fills in what the command line and environment
+  // leave unset, ahead of defaults. The parser's own allocations (the token
+  // list and every level's slots, ParseOk::levels included) come from
+  // `memory`; with a std::pmr::monotonic_buffer_resource per parse they
+  // are pointer bumps, released at once when the resource goes. The
+  // config and command path are ordinary heap values and outlive it.
+  inline TryResult
+  try_parse(
+    const cmd::RootSpec& root,
+    const std::vector<std::string>& args,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    std::pmr::vector<std::string_view> tokens(
+      args.begin(), args.end(), memory);
+    return detail::first_error(root, tokens, env, nullptr, files, memory);
+  }
+
+  inline TryResult
+  try_parse(
+    const cmd::RootSpec& root,
+    int argc,
+    const char* const* argv,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::first_error(
+      root,
+      detail::argv_tokens(argc, argv, memory),
+      env,
+      nullptr,
+      files,
+      memory);
+  }
+
+  // Keeps going after user errors and returns all of them as ParseErrors:
+  // offending tokens are skipped, and values that failed to convert are
+  // neither defaulted nor validated. Otherwise behaves like parse.
+  inline ParseResult
+  parse_all(
+    const cmd::RootSpec& root,
+    const std::vector<std::string>& args,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    std::pmr::vector<std::string_view> tokens(
+      args.begin(), args.end(), memory);
+    return detail::all_errors(root, tokens, env, files, memory);
+  }
+
+  inline ParseResult
+  parse_all(
+    const cmd::RootSpec& root,
+    int argc,
+    const char* const* argv,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::all_errors(
+      root, detail::argv_tokens(argc, argv, memory), env, files, memory);
+  }
+
+  inline ParseResult
+  parse(
+    const cmd::RootSpec& root,
+    const std::vector<std::string>& args,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::value_or_throw(
+      try_parse(root, args, std::move(env), files, memory));
+  }
+
+  // Parses `main`-style arguments in place; argv[0] (the program name) is
+  // skipped. Tokens are viewed, not copied, so argv must outlive the call.
+  inline ParseResult
+  parse(
+    const cmd::RootSpec& root,
+    int argc,
+    const char* const* argv,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::value_or_throw(
+      try_parse(root, argc, argv, std::move(env), files, memory));
+  }
+
+  // -------------------------------------------------------------------------
+  // Event-driven parsing
+  // -------------------------------------------------------------------------
+
+  // Parses like try_parse, handing every command-line value to `on_event`
+  // as soon as it is converted. Values the handler takes are never stored,
+  // so a repeated positional with many values costs no memory beyond one
+  // element at a time; their keys are left out of the config and they are
+  // not validated. Everything the handler leaves, along with env fallback
+  // and defaults, ends up in ParseOk as usual. Events are delivered before
+  // errors are known: with first-error semantics, a later error still fails
+  // the parse after earlier events.
+  inline TryResult
+  try_stream(
+    const cmd::RootSpec& root,
+    const std::vector<std::string>& args,
+    const EventHandler& on_event,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    std::pmr::vector<std::string_view> tokens(
+      args.begin(), args.end(), memory);
+    return detail::first_error(
+      root, tokens, env, &on_event, files, memory);
+  }
 
-    return ParseOk{std::move(ok.config), std::move(ok.command_path)};
+  inline TryResult
+  try_stream(
+    const cmd::RootSpec& root,
+    int argc,
+    const char* const* argv,
+    const EventHandler& on_event,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::first_error(
+      root,
+      detail::argv_tokens(argc, argv, memory),
+      env,
+      &on_event,
+      files,
+      memory);
+  }
+
+  // Throws parse::Error where try_stream returns an error.
+  inline ParseResult
+  stream(
+    const cmd::RootSpec& root,
+    const std::vector<std::string>& args,
+    const EventHandler& on_event,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::value_or_throw(
+      try_stream(root, args, on_event, std::move(env), files, memory));
+  }
+
+  inline ParseResult
+  stream(
+    const cmd::RootSpec& root,
+    int argc,
+    const char* const* argv,
+    const EventHandler& on_event,
+    EnvLookup env = default_env_lookup(),
+    const nlohmann::json* files = nullptr,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    return detail::value_or_throw(
+      try_stream(root, argc, argv, on_event, std::move(env), files, memory));
   }
 
 } // namespace json_commander::parse
@@ -2,8 +2,12 @@
 
 #include <json_commander/cmd.hpp>
 #include <json_commander/completion.hpp>
+#include <json_commander/config_file.hpp>
 #include <json_commander/config_schema.hpp>
+#include <json_commander/handoff.hpp>
+#include <json_commander/input.hpp>
 #include <json_commander/manpage.hpp>
+#include <json_commander/memo.hpp>
 #include <json_commander/parse.hpp>
 #include <json_commander/schema_loader.hpp>
 
@@ -12,19 +16,24 @@
 #include <filesystem>
 #include <functional>
 #include <iostream>
+#include <optional>
+#include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #ifdef _WIN32
 #include <io.h>
 #include <windows.h>
 #define JCMD_ISATTY(fd) _isatty(fd)
+#define JCMD_STDIN_FD _fileno(stdin)
 #define JCMD_STDOUT_FD _fileno(stdout)
 #define JCMD_STDERR_FD _fileno(stderr)
 #else
 #include <sys/ioctl.h>
 #include <unistd.h>
 #define JCMD_ISATTY(fd) isatty(fd)
+#define JCMD_STDIN_FD STDIN_FILENO
 #define JCMD_STDOUT_FD STDOUT_FILENO
 #define JCMD_STDERR_FD STDERR_FILENO
 #endif
@@ -50,152 +59,339 @@ namespace json_commander {
 
   using MainFn = std::function<int(const nlohmann::json& config)>;
 
+  // Also receives the values of a "from_stdin" positional, read from stdin
+  // while it runs. The stream is empty when the command has no such
+  // positional, its values were given on the command line, stdin is a
+  // terminal, or the config was inherited (see inherited_config).
+  using StreamMainFn =
+    std::function<int(const nlohmann::json& config, input::Stream& values)>;
+
   // -------------------------------------------------------------------------
-  // Core overload: model::Root → run
+  // Inherited config
   // -------------------------------------------------------------------------
 
-  inline int
-  run(const model::Root& root, int argc, char* argv[], MainFn main_fn) {
-    std::string name =
-      (argc > 0 && argv && argv[0] && argv[0][0] != '\0') ? argv[0] : "error";
+  // In a program started by `json-commander exec` or handoff::exec, returns
+  // the config the parent already parsed and validated for `program` (the
+  // schema's name) from this same `argv`, so the schema does not have to be
+  // loaded. Returns nullopt otherwise; throws handoff::Error when the
+  // handed-off config cannot be read.
+  inline std::optional<nlohmann::json>
+  inherited_config(
+    std::string_view program, int argc, const char* const* argv) {
+    return handoff::receive(program, argc, argv);
+  }
 
-    auto spec = cmd::make(root);
+  // -------------------------------------------------------------------------
+  // Detail: stdin positionals
+  // -------------------------------------------------------------------------
 
-    std::vector<std::string> args;
-    for (int i = 1; i < argc; ++i) {
-      args.emplace_back(argv[i]);
-    }
+  namespace detail {
 
-    parse::ParseResult result;
-    try {
-      result = parse::parse(spec, args);
-    } catch (const parse::Error& e) {
-      std::cerr << name << ": " << e.what() << "\n";
-      if (JCMD_ISATTY(JCMD_STDERR_FD)) {
-        int width = terminal_width(JCMD_STDERR_FD);
-        std::cerr << manpage::to_ansi_text(root, {}, width);
-      } else {
-        std::cerr << manpage::to_plain_text(root, {});
+    // The positional of the invoked command (or one of its parents) that
+    // reads from stdin, if any.
+    inline const arg::PositionalSpec*
+    stdin_positional(
+      const cmd::RootSpec& spec, const std::vector<std::string>& path) {
+      const arg::PositionalSpec* found = nullptr;
+      auto scan = [&](const std::vector<arg::ArgSpec>& args) {
+        for (const auto& a : args) {
+          const auto* pos = std::get_if<arg::PositionalSpec>(&a);
+          if (pos && pos->stdin_delimiter.has_value()) { found = pos; }
+        }
+      };
+      scan(spec.args);
+      const auto& index = *spec.index;
+      auto node = command_index::Index::root;
+      for (const auto& name : path) {
+        auto next = index.child(node, name);
+        if (!next.has_value()) { break; }
+        node = *next;
+        scan(index.resolve(spec, node)->args);
       }
-      return 1;
+      return found;
     }
 
-    return std::visit(
-      [&](const auto& r) -> int {
-        using T = std::decay_t<decltype(r)>;
-
-        if constexpr (std::is_same_v<T, parse::ParseOk>) {
-          // Check for missing subcommand: walk into the nested config
-          // to find the deepest level that should have a "command" but doesn't.
-          {
-            const nlohmann::json* cfg = &r.config;
-            const model::Root* cur_root = &root;
-            std::vector<std::string> help_path = r.command_path;
-            bool has_commands =
-              cur_root->commands.has_value() && !cur_root->commands->empty();
-
-            // Walk through selected commands to find the leaf
-            const std::vector<model::Command>* cmds =
-              has_commands ? &*cur_root->commands : nullptr;
-            for (const auto& seg : r.command_path) {
-              if (!cmds) break;
-              for (const auto& cmd : *cmds) {
-                if (cmd.name == seg) {
-                  cfg = &(*cfg)[seg];
-                  cmds = (cmd.commands.has_value() && !cmd.commands->empty())
-                           ? &*cmd.commands
-                           : nullptr;
-                  has_commands = cmds != nullptr;
-                  break;
-                }
-              }
-            }
+    inline int
+    run_root(
+      const model::Root& root,
+      int argc,
+      char* argv[],
+      const StreamMainFn& main_fn,
+      bool read_stdin) {
+      std::string name =
+        (argc > 0 && argv && argv[0] && argv[0][0] != '\0') ? argv[0]
+                                                            : "error";
+
+      std::string handoff_error;
+      auto inherited =
+        handoff::try_receive_payload(root.name, argc, argv, handoff_error);
+      // A handed-off config comes with no stream of stdin values, so a
+      // command that reads them parses its own arguments instead.
+      if (
+        inherited.has_value() &&
+        !(read_stdin &&
+          memo::detail::reads_stdin(
+            root, {inherited->config, inherited->command_path}))) {
+        input::Stream none;
+        return main_fn(inherited->config, none);
+      }
+      // A stale or foreign JCMD_CONFIG_FD is no reason not to parse argv.
+      if (!handoff_error.empty()) {
+        std::cerr << name << ": warning: ignoring " << handoff_error << "\n";
+      }
+
+      // An invocation seen before needs no parsing at all.
+      std::optional<std::string> memo_key;
+      std::optional<memo::Profile> profile;
+      if (memo::enabled(root)) {
+        profile = memo::profile(root);
+        memo_key = memo::key(root, *profile, argc, argv);
+        if (memo_key.has_value()) {
+          if (auto entry = memo::lookup(root, *memo_key)) {
+            input::Stream none;
+            return main_fn(entry->config, none);
+          }
+        }
+      }
+
+      auto spec = cmd::make(root);
+      // Built from spec, but positions match root, so it serves both.
+      const auto& index = *spec.index;
+
+      // Positionals given on the command line are not read from stdin.
+      std::set<std::string, std::less<>> given;
+      parse::EventHandler note = [&](const parse::Event& event) {
+        if (const auto* pos = std::get_if<parse::PositionalEvent>(&event)) {
+          given.emplace(pos->dest);
+        }
+        return false;
+      };
+      // Declared config files are read and checked once, before parsing.
+      // A bad one only matters once there is a config to run with: --help,
+      // --version and completion still work.
+      nlohmann::json files;
+      std::string files_error;
+      if (root.config.has_value()) {
+        // The memo key already hashed the model the config cache is
+        // keyed on.
+        auto loaded =
+          profile.has_value()
+            ? config_file::try_load(root, profile->fingerprint, files_error)
+            : config_file::try_load(root, files_error);
+        if (loaded.has_value()) { files = std::move(*loaded); }
+      }
+      const auto* layer =
+        root.config.has_value() && files_error.empty() ? &files : nullptr;
+
+      auto env = parse::env_snapshot(spec);
+      auto result =
+        read_stdin ? parse::try_stream(spec, argc, argv, note, env, layer)
+                   : parse::try_parse(spec, argc, argv, env, layer);
+      if (!result && !files_error.empty()) {
+        // Likely a consequence: a required value the file would have set.
+        std::cerr << name << ": " << files_error << "\n";
+        return 1;
+      }
+      if (!result) {
+        const auto& error = result.error();
+        std::cerr << name << ": " << error.message << "\n";
+        // A typo with a suggested fix only needs the hint, not the full page.
+        if (!error.suggestions.empty()) {
+          std::cerr << "Try '" << name << " --help' for more information.\n";
+          return 1;
+        }
+        if (JCMD_ISATTY(JCMD_STDERR_FD)) {
+          int width = terminal_width(JCMD_STDERR_FD);
+          std::cerr << manpage::to_ansi_text(root, {}, width);
+        } else {
+          std::cerr << manpage::to_plain_text(root, {});
+        }
+        return 1;
+      }
+
+      return std::visit(
+        [&](const auto& r) -> int {
+          using T = std::decay_t<decltype(r)>;
 
-            if (has_commands && !cfg->contains("command")) {
+          if constexpr (std::is_same_v<T, parse::ParseOk>) {
+            if (!files_error.empty()) {
+              std::cerr << name << ": " << files_error << "\n";
+              return 1;
+            }
+            // The parser stops at the deepest command it was given, so the
+            // command is missing when that level still has subcommands.
+            auto leaf = index.find(r.command_path);
+            if (leaf.has_value() && index.child_count(*leaf) > 0) {
               std::cerr << name << ": missing subcommand\n";
               if (JCMD_ISATTY(JCMD_STDERR_FD)) {
                 int width = terminal_width(JCMD_STDERR_FD);
-                std::cerr << manpage::to_ansi_text(root, r.command_path, width);
+                std::cerr << manpage::to_ansi_text(
+                  root, index, r.command_path, width);
               } else {
-                std::cerr << manpage::to_plain_text(root, r.command_path);
+                std::cerr << manpage::to_plain_text(
+                  root, index, r.command_path);
               }
               return 1;
             }
-          }
 
-          try {
-            auto schema = config_schema::to_config_schema(root, r.command_path);
-            nlohmann::json_schema::json_validator validator;
-            validator.set_root_schema(schema);
-            validator.validate(r.config);
-          } catch (const std::exception& e) {
-            std::cerr << name
-                      << ": internal error: config failed schema validation: "
-                      << e.what() << "\n";
+            try {
+              auto schema =
+                config_schema::to_config_schema(root, index, r.command_path);
+              nlohmann::json_schema::json_validator validator;
+              validator.set_root_schema(schema);
+              // Packed lists are checked as the arrays they stand for.
+              validator.validate(conv::unpack_all(r.config));
+            } catch (const std::exception& e) {
+              std::cerr << name
+                        << ": internal error: config failed schema validation: "
+                        << e.what() << "\n";
+              return 1;
+            }
+            if (memo_key.has_value()) {
+              memo::store(root, *memo_key, {r.config, r.command_path});
+            }
+            input::Stream none;
+            std::optional<input::Stream> values;
+            const auto* pos =
+              read_stdin ? stdin_positional(spec, r.command_path) : nullptr;
+            if (
+              pos && !given.contains(pos->dest) &&
+              !JCMD_ISATTY(JCMD_STDIN_FD)) {
+              values.emplace(JCMD_STDIN_FD, *pos->stdin_delimiter, *pos);
+            }
+            try {
+              return main_fn(r.config, values ? *values : none);
+            } catch (const input::Error& e) {
+              std::cerr << name << ": " << e.what() << "\n";
+              return 1;
+            }
+          } else if constexpr (std::is_same_v<T, parse::HelpRequest>) {
+            if (JCMD_ISATTY(JCMD_STDOUT_FD)) {
+              int width = terminal_width(JCMD_STDOUT_FD);
+              std::cout << manpage::to_ansi_text(
+                root, index, r.command_path, width);
+            } else {
+              std::cout << manpage::to_plain_text(root, index, r.command_path);
+            }
+            return 0;
+          } else if constexpr (std::is_same_v<T, parse::VersionRequest>) {
+            std::cout << name << " version";
+            if (root.version) { std::cout << " " << *root.version; }
+            std::cout << "\n";
+            return 0;
+          } else if constexpr (std::is_same_v<T, parse::ManpageRequest>) {
+            std::cout << manpage::to_groff(root, index, r.command_path);
+            return 0;
+          } else if constexpr (std::is_same_v<T, parse::CompletionRequest>) {
+            if (r.shell == "bash") {
+              std::cout << completion::to_bash(root);
+            } else if (r.shell == "zsh") {
+              std::cout << completion::to_zsh(root);
+            } else if (r.shell == "fish") {
+              std::cout << completion::to_fish(root);
+            }
+            return 0;
+          } else if constexpr (std::is_same_v<T, parse::ParseErrors>) {
+            for (const auto& error : r.errors) {
+              std::cerr << name << ": " << error.message << "\n";
+            }
             return 1;
           }
-          return main_fn(r.config);
-        } else if constexpr (std::is_same_v<T, parse::HelpRequest>) {
-          if (JCMD_ISATTY(JCMD_STDOUT_FD)) {
-            int width = terminal_width(JCMD_STDOUT_FD);
-            std::cout << manpage::to_ansi_text(root, r.command_path, width);
-          } else {
-            std::cout << manpage::to_plain_text(root, r.command_path);
-          }
-          return 0;
-        } else if constexpr (std::is_same_v<T, parse::VersionRequest>) {
-          std::cout << name << " version";
-          if (root.version) { std::cout << " " << *root.version; }
-          std::cout << "\n";
-          return 0;
-        } else if constexpr (std::is_same_v<T, parse::ManpageRequest>) {
-          std::cout << manpage::to_groff(root, r.command_path);
-          return 0;
-        } else if constexpr (std::is_same_v<T, parse::CompletionRequest>) {
-          if (r.shell == "bash") {
-            std::cout << completion::to_bash(root);
-          } else if (r.shell == "zsh") {
-            std::cout << completion::to_zsh(root);
-          } else if (r.shell == "fish") {
-            std::cout << completion::to_fish(root);
-          }
-          return 0;
-        }
+        },
+        result.value());
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Core overloads: model::Root → run
+  // -------------------------------------------------------------------------
+
+  inline int
+  run(const model::Root& root, int argc, char* argv[], MainFn main_fn) {
+    return detail::run_root(
+      root,
+      argc,
+      argv,
+      [&](const nlohmann::json& config, input::Stream&) {
+        return main_fn(config);
       },
-      result);
+      false);
+  }
+
+  inline int
+  run(const model::Root& root, int argc, char* argv[], StreamMainFn main_fn) {
+    return detail::run_root(root, argc, argv, main_fn, true);
   }
 
   // -------------------------------------------------------------------------
-  // JSON string overload: parse JSON → load schema → delegate to Root overload
+  // Detail: schema loading
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // Runs `load`, reporting a schema it rejects before rethrowing.
+    template <typename Load>
+    model::Root
+    load_root(int argc, char* argv[], Load load) {
+      std::string name =
+        (argc > 0 && argv && argv[0] && argv[0][0] != '\0') ? argv[0]
+                                                            : "error";
+      try {
+        schema::Loader loader;
+        return load(loader);
+      } catch (const nlohmann::json::exception& e) {
+        std::cerr << name
+                  << ": invalid CLI definition. Use json-commander validate to "
+                     "check your schema.\n";
+        throw;
+      } catch (const schema::Error& e) {
+        std::cerr << name
+                  << ": invalid CLI definition. Use json-commander validate to "
+                     "check your schema.\n";
+        throw;
+      }
+    }
+
+    inline model::Root
+    load_json(const std::string& cli_json, int argc, char* argv[]) {
+      return load_root(argc, argv, [&](schema::Loader& loader) {
+        return loader.load(nlohmann::json::parse(cli_json));
+      });
+    }
+
+    inline model::Root
+    load_file(
+      const std::filesystem::path& schema_path, int argc, char* argv[]) {
+      return load_root(argc, argv, [&](schema::Loader& loader) {
+        return loader.load(schema_path.string());
+      });
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // JSON string overloads: parse JSON → load schema → delegate to Root
   // -------------------------------------------------------------------------
 
   inline int
   run(const std::string& cli_json, int argc, char* argv[], MainFn main_fn) {
-    std::string name =
-      (argc > 0 && argv && argv[0] && argv[0][0] != '\0') ? argv[0] : "error";
-
-    model::Root root;
-    try {
-      schema::Loader loader;
-      auto j = nlohmann::json::parse(cli_json);
-      root = loader.load(j);
-    } catch (const nlohmann::json::exception& e) {
-      std::cerr << name
-                << ": invalid CLI definition. Use json-commander validate to "
-                   "check your schema.\n";
-      throw;
-    } catch (const schema::Error& e) {
-      std::cerr << name
-                << ": invalid CLI definition. Use json-commander validate to "
-                   "check your schema.\n";
-      throw;
-    }
+    auto root = detail::load_json(cli_json, argc, argv);
+    return run(root, argc, argv, std::move(main_fn));
+  }
 
+  inline int
+  run(
+    const std::string& cli_json,
+    int argc,
+    char* argv[],
+    StreamMainFn main_fn) {
+    auto root = detail::load_json(cli_json, argc, argv);
     return run(root, argc, argv, std::move(main_fn));
   }
 
   // -------------------------------------------------------------------------
-  // File overload: load schema from path → delegate to Root overload
+  // File overloads: load schema from path → delegate to Root
   // -------------------------------------------------------------------------
 
   inline int
@@ -204,25 +400,17 @@ namespace json_commander {
     int argc,
     char* argv[],
     MainFn main_fn) {
-    std::string name =
-      (argc > 0 && argv && argv[0] && argv[0][0] != '\0') ? argv[0] : "error";
-
-    model::Root root;
-    try {
-      schema::Loader loader;
-      root = loader.load(schema_path.string());
-    } catch (const nlohmann::json::exception& e) {
-      std::cerr << name
-                << ": invalid CLI definition. Use json-commander validate to "
-                   "check your schema.\n";
-      throw;
-    } catch (const schema::Error& e) {
-      std::cerr << name
-                << ": invalid CLI definition. Use json-commander validate to "
-                   "check your schema.\n";
-      throw;
-    }
+    auto root = detail::load_file(schema_path, argc, argv);
+    return run(root, argc, argv, std::move(main_fn));
+  }
 
+  inline int
+  run_file(
+    const std::filesystem::path& schema_path,
+    int argc,
+    char* argv[],
+    StreamMainFn main_fn) {
+    auto root = detail::load_file(schema_path, argc, argv);
     return run(root, argc, argv, std::move(main_fn));
   }
 
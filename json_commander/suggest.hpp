@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json_commander::suggest {
+
+  // -------------------------------------------------------------------------
+  // Detail: plain dynamic-programming distance (long queries only)
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    inline std::size_t
+    levenshtein(std::string_view a, std::string_view b) {
+      std::vector<std::size_t> row(b.size() + 1);
+      for (std::size_t j = 0; j <= b.size(); ++j) {
+        row[j] = j;
+      }
+      for (std::size_t i = 1; i <= a.size(); ++i) {
+        std::size_t diag = row[0];
+        row[0] = i;
+        for (std::size_t j = 1; j <= b.size(); ++j) {
+          std::size_t up = row[j];
+          std::size_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+          row[j] = std::min({row[j] + 1, row[j - 1] + 1, diag + cost});
+          diag = up;
+        }
+      }
+      return row[b.size()];
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Matcher
+  // -------------------------------------------------------------------------
+
+  // Levenshtein distance from one query to many candidates. Queries of up to
+  // 64 characters use Myers' bit-parallel algorithm (in Hyyrö's formulation)
+  // with the query's match masks computed once, so each candidate costs one
+  // pass of a few word operations per character.
+  class Matcher {
+  public:
+    explicit Matcher(std::string_view query) : query_(query) {
+      if (query_.size() > 64) { return; }
+      for (std::size_t i = 0; i < query_.size(); ++i) {
+        peq_[static_cast<unsigned char>(query_[i])] |= std::uint64_t{1} << i;
+      }
+    }
+
+    // The distance to `candidate`, or nullopt if it exceeds `bound`.
+    std::optional<std::size_t>
+    distance(std::string_view candidate, std::size_t bound) const {
+      const std::size_t m = query_.size();
+      const std::size_t n = candidate.size();
+      if ((m > n ? m - n : n - m) > bound) { return std::nullopt; }
+      if (m == 0) { return n; }
+
+      std::size_t score = m;
+      if (m > 64) {
+        score = detail::levenshtein(query_, candidate);
+        if (score > bound) { return std::nullopt; }
+        return score;
+      }
+
+      const std::uint64_t last = std::uint64_t{1} << (m - 1);
+      std::uint64_t pv = ~std::uint64_t{0};
+      std::uint64_t mv = 0;
+      for (std::size_t j = 0; j < n; ++j) {
+        const auto c = static_cast<unsigned char>(candidate[j]);
+        const std::uint64_t eq = peq_[c];
+        const std::uint64_t xv = eq | mv;
+        const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t ph = mv | ~(xh | pv);
+        std::uint64_t mh = pv & xh;
+        if (ph & last) {
+          ++score;
+        } else if (mh & last) {
+          --score;
+        }
+        // Row 0 grows by one per column: shift a 1 into the horizontal
+        // positive deltas.
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        // Each remaining column lowers the score by at most one.
+        if (score > bound + (n - j - 1)) { return std::nullopt; }
+      }
+      if (score > bound) { return std::nullopt; }
+      return score;
+    }
+
+  private:
+    std::string_view query_;
+    std::array<std::uint64_t, 256> peq_{};
+  };
+
+  // -------------------------------------------------------------------------
+  // Nearest names
+  // -------------------------------------------------------------------------
+
+  // Edit budget for a name of `length` characters: a third of it, at least
+  // one and at most three.
+  inline std::size_t
+  default_bound(std::size_t length) {
+    return std::clamp<std::size_t>(length / 3, 1, 3);
+  }
+
+  // Up to `limit` candidates within `bound` edits of `query`, closest first
+  // (ties in lexical order). `candidates` is any range of string-like names.
+  template <class Range>
+  std::vector<std::string>
+  nearest(
+    std::string_view query,
+    const Range& candidates,
+    std::size_t bound,
+    std::size_t limit = 3) {
+    Matcher matcher(query);
+    std::vector<std::pair<std::size_t, std::string_view>> hits;
+    for (const auto& candidate : candidates) {
+      std::string_view name(candidate);
+      if (name == query) { continue; }
+      if (auto d = matcher.distance(name, bound)) {
+        hits.emplace_back(*d, name);
+      }
+    }
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+    std::vector<std::string> result;
+    for (std::size_t i = 0; i < hits.size() && i < limit; ++i) {
+      result.emplace_back(hits[i].second);
+    }
+    return result;
+  }
+
+} // namespace json_commander::suggest
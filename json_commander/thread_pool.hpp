@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace json_commander::thread_pool {
+
+  // -------------------------------------------------------------------------
+  // Detail: stealable index ranges
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // The task indices one worker still has to run. The owner takes them
+    // from the front; an idle worker steals the back half.
+    class Range {
+    public:
+      void
+      assign(std::size_t begin, std::size_t end) {
+        std::lock_guard lock(mutex_);
+        begin_ = begin;
+        end_ = end;
+      }
+
+      bool
+      take(std::size_t& index) {
+        std::lock_guard lock(mutex_);
+        if (begin_ == end_) { return false; }
+        index = begin_++;
+        return true;
+      }
+
+      bool
+      steal(std::size_t& begin, std::size_t& end) {
+        std::lock_guard lock(mutex_);
+        if (begin_ == end_) { return false; }
+        std::size_t mid = begin_ + (end_ - begin_) / 2;
+        begin = mid;
+        end = end_;
+        end_ = mid;
+        return true;
+      }
+
+    private:
+      std::mutex mutex_;
+      std::size_t begin_ = 0;
+      std::size_t end_ = 0;
+    };
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Pool
+  // -------------------------------------------------------------------------
+
+  // Fixed set of worker threads running index-parallel loops. Each loop's
+  // indices are split evenly between the workers and the calling thread;
+  // whoever runs out steals half of another worker's remaining indices, so
+  // uneven task costs still keep every thread busy.
+  class Pool {
+  public:
+    // `threads` counts the calling thread; 0 picks the hardware concurrency.
+    explicit Pool(std::size_t threads = 0) {
+      if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+      for (std::size_t i = 0; i < threads; ++i) {
+        ranges_.push_back(std::make_unique<detail::Range>());
+      }
+      for (std::size_t i = 1; i < threads; ++i) {
+        workers_.emplace_back([this, i] { worker_loop(i); });
+      }
+    }
+
+    Pool(const Pool&) = delete;
+    Pool&
+    operator=(const Pool&) = delete;
+
+    ~Pool() {
+      {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+      }
+      wake_.notify_all();
+      for (auto& worker : workers_) {
+        worker.join();
+      }
+    }
+
+    // Number of threads running a loop, the calling thread included.
+    std::size_t
+    size() const noexcept {
+      return ranges_.size();
+    }
+
+    // Calls fn(i) for every i in [0, count) and returns once all calls are
+    // done. The first exception thrown by fn stops the remaining calls and
+    // is rethrown here. Loops from several threads run one at a time; fn
+    // must not start a loop on the same pool.
+    template <class Fn>
+    void
+    parallel_for(std::size_t count, Fn&& fn) {
+      if (count == 0) { return; }
+      std::lock_guard call(call_mutex_);
+
+      const std::size_t parts = ranges_.size();
+      for (std::size_t i = 0; i < parts; ++i) {
+        ranges_[i]->assign(count * i / parts, count * (i + 1) / parts);
+      }
+      {
+        std::lock_guard lock(mutex_);
+        task_ = [&fn](std::size_t index) { fn(index); };
+        error_ = nullptr;
+        failed_.store(false, std::memory_order_relaxed);
+        busy_ = workers_.size();
+        ++generation_;
+      }
+      wake_.notify_all();
+
+      run_share(0);
+
+      std::unique_lock lock(mutex_);
+      done_.wait(lock, [this] { return busy_ == 0; });
+      task_ = nullptr;
+      if (error_) { std::rethrow_exception(std::exchange(error_, nullptr)); }
+    }
+
+  private:
+    void
+    worker_loop(std::size_t id) {
+      std::size_t seen = 0;
+      while (true) {
+        {
+          std::unique_lock lock(mutex_);
+          wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+          if (stopping_) { return; }
+          seen = generation_;
+        }
+        run_share(id);
+        {
+          std::lock_guard lock(mutex_);
+          --busy_;
+        }
+        done_.notify_one();
+      }
+    }
+
+    // Runs this thread's indices, then steals until no work is left.
+    void
+    run_share(std::size_t id) {
+      auto& own = *ranges_[id];
+      while (!failed_.load(std::memory_order_relaxed)) {
+        std::size_t index = 0;
+        if (own.take(index)) {
+          run_one(index);
+          continue;
+        }
+        if (!steal_into(id)) { return; }
+      }
+    }
+
+    bool
+    steal_into(std::size_t id) {
+      const std::size_t parts = ranges_.size();
+      for (std::size_t k = 1; k < parts; ++k) {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        if (ranges_[(id + k) % parts]->steal(begin, end)) {
+          ranges_[id]->assign(begin, end);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void
+    run_one(std::size_t index) {
+      try {
+        task_(index);
+      } catch (...) {
+        std::lock_guard lock(mutex_);
+        if (!error_) { error_ = std::current_exception(); }
+        failed_.store(true, std::memory_order_relaxed);
+      }
+    }
+
+    std::vector<std::unique_ptr<detail::Range>> ranges_; // [0] is the caller
+    std::vector<std::thread> workers_;
+
+    std::mutex call_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::size_t generation_ = 0;
+    std::size_t busy_ = 0;
+    bool stopping_ = false;
+
+    std::function<void(std::size_t)> task_;
+    std::exception_ptr error_;
+    std::atomic<bool> failed_{false};
+  };
+
+} // namespace json_commander::thread_pool
@@ -5,6 +5,7 @@
 
 #include <filesystem>
 #include <functional>
+#include <initializer_list>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -18,25 +19,66 @@ namespace json_commander::validate {
         : std::runtime_error(message) {}
   };
 
+  // Non-throwing form of Validator::check: the message check would have
+  // thrown, or nullopt when the value passes.
+  using TryCheck = std::function<std::optional<std::string>(
+    const std::string& name, const std::optional<nlohmann::json>& value)>;
+
   struct Validator {
     std::function<void(
       const std::string& name, const std::optional<nlohmann::json>& value)>
       check;
     std::string description;
+    // Set by the built-in validators; custom validators may provide only
+    // check.
+    TryCheck try_check = {};
   };
 
+  // Validates without throwing validate::Error. Validators without a
+  // try_check fall back to check, with the exception caught here.
+  inline std::optional<std::string>
+  try_validate(
+    const Validator& v,
+    const std::string& name,
+    const std::optional<nlohmann::json>& value) {
+    if (v.try_check) { return v.try_check(name, value); }
+    try {
+      v.check(name, value);
+    } catch (const Error& e) {
+      return std::string(e.what());
+    }
+    return std::nullopt;
+  }
+
+  namespace detail {
+
+    // Builds a validator around its non-throwing form; check throws the
+    // reported message as validate::Error.
+    inline Validator
+    from_try_check(TryCheck try_check, std::string description) {
+      auto check = [try_check](
+                     const std::string& name,
+                     const std::optional<nlohmann::json>& value) {
+        if (auto error = try_check(name, value)) { throw Error(*error); }
+      };
+      return {std::move(check), std::move(description), std::move(try_check)};
+    }
+
+  } // namespace detail
+
   // -------------------------------------------------------------------------
   // Constraint validators
   // -------------------------------------------------------------------------
 
   inline Validator
   required() {
-    return {
-      [](const std::string& name, const std::optional<nlohmann::json>& value) {
-        if (!value.has_value()) { throw Error(name + " is required"); }
+    return detail::from_try_check(
+      [](const std::string& name, const std::optional<nlohmann::json>& value)
+        -> std::optional<std::string> {
+        if (!value.has_value()) { return name + " is required"; }
+        return std::nullopt;
       },
-      "required",
-    };
+      "required");
   }
 
   // Note on TOCTOU: These validators check filesystem state at parse time.
@@ -46,62 +88,67 @@ namespace json_commander::validate {
 
   namespace detail {
 
-    inline void
+    inline std::optional<std::string>
     reject_symlink(const std::string& name, const std::filesystem::path& p) {
       std::error_code ec;
       auto status = std::filesystem::symlink_status(p, ec);
       if (!ec && status.type() == std::filesystem::file_type::symlink) {
-        throw Error(name + ": " + p.string() + " is a symbolic link");
+        return name + ": " + p.string() + " is a symbolic link";
       }
+      return std::nullopt;
+    }
+
+    // Validator that checks the path in the value with `accept`, reporting
+    // `problem` (e.g. "is not a directory") when it fails.
+    template <class Accept>
+    Validator
+    path_check(Accept accept, std::string problem, std::string description) {
+      return from_try_check(
+        [accept, problem](
+          const std::string& name, const std::optional<nlohmann::json>& value)
+          -> std::optional<std::string> {
+          if (!value.has_value()) { return std::nullopt; }
+          auto path = value->get<std::string>();
+          if (auto error = reject_symlink(name, path)) { return error; }
+          std::error_code ec;
+          if (!accept(std::filesystem::symlink_status(path, ec))) {
+            return name + ": " + path + " " + problem;
+          }
+          return std::nullopt;
+        },
+        std::move(description));
     }
 
   } // namespace detail
 
   inline Validator
   must_exist_file() {
-    return {
-      [](const std::string& name, const std::optional<nlohmann::json>& value) {
-        if (!value.has_value()) { return; }
-        auto path = value->get<std::string>();
-        detail::reject_symlink(name, path);
-        if (!std::filesystem::is_regular_file(
-              std::filesystem::symlink_status(path))) {
-          throw Error(name + ": " + path + " is not a regular file");
-        }
+    return detail::path_check(
+      [](const std::filesystem::file_status& st) {
+        return std::filesystem::is_regular_file(st);
       },
-      "must_exist(file)",
-    };
+      "is not a regular file",
+      "must_exist(file)");
   }
 
   inline Validator
   must_exist_dir() {
-    return {
-      [](const std::string& name, const std::optional<nlohmann::json>& value) {
-        if (!value.has_value()) { return; }
-        auto path = value->get<std::string>();
-        detail::reject_symlink(name, path);
-        if (!std::filesystem::is_directory(
-              std::filesystem::symlink_status(path))) {
-          throw Error(name + ": " + path + " is not a directory");
-        }
+    return detail::path_check(
+      [](const std::filesystem::file_status& st) {
+        return std::filesystem::is_directory(st);
       },
-      "must_exist(dir)",
-    };
+      "is not a directory",
+      "must_exist(dir)");
   }
 
   inline Validator
   must_exist_path() {
-    return {
-      [](const std::string& name, const std::optional<nlohmann::json>& value) {
-        if (!value.has_value()) { return; }
-        auto path = value->get<std::string>();
-        detail::reject_symlink(name, path);
-        if (!std::filesystem::exists(std::filesystem::symlink_status(path))) {
-          throw Error(name + ": " + path + " does not exist");
-        }
+    return detail::path_check(
+      [](const std::filesystem::file_status& st) {
+        return std::filesystem::exists(st);
       },
-      "must_exist(path)",
-    };
+      "does not exist",
+      "must_exist(path)");
   }
 
   // -------------------------------------------------------------------------
@@ -111,25 +158,26 @@ namespace json_commander::validate {
   inline Validator
   all_of(std::vector<Validator> validators) {
     if (validators.empty()) {
-      return {
-        [](const std::string&, const std::optional<nlohmann::json>&) {},
-        "none",
-      };
+      return detail::from_try_check(
+        [](const std::string&, const std::optional<nlohmann::json>&)
+          -> std::optional<std::string> { return std::nullopt; },
+        "none");
     }
     std::string desc;
     for (std::size_t i = 0; i < validators.size(); ++i) {
       if (i > 0) { desc += " + "; }
       desc += validators[i].description;
     }
-    return {
+    return detail::from_try_check(
       [validators = std::move(validators)](
-        const std::string& name, const std::optional<nlohmann::json>& value) {
+        const std::string& name, const std::optional<nlohmann::json>& value)
+        -> std::optional<std::string> {
         for (const auto& v : validators) {
-          v.check(name, value);
+          if (auto error = try_validate(v, name, value)) { return error; }
         }
+        return std::nullopt;
       },
-      std::move(desc),
-    };
+      std::move(desc));
   }
 
   // -------------------------------------------------------------------------
@@ -163,47 +211,68 @@ namespace json_commander::validate {
       auto scalar_v = must_exist_for_scalar(lt.element);
       if (!scalar_v.has_value()) { return std::nullopt; }
       auto inner = std::move(*scalar_v);
-      return Validator{
+      auto description = inner.description;
+      return from_try_check(
         [inner](
-          const std::string& name, const std::optional<nlohmann::json>& value) {
-          if (!value.has_value()) { return; }
+          const std::string& name, const std::optional<nlohmann::json>& value)
+          -> std::optional<std::string> {
+          if (!value.has_value()) { return std::nullopt; }
           for (std::size_t i = 0; i < value->size(); ++i) {
             auto elem = std::optional<nlohmann::json>((*value)[i]);
-            inner.check(name + "[" + std::to_string(i) + "]", elem);
+            auto error =
+              try_validate(inner, name + "[" + std::to_string(i) + "]", elem);
+            if (error.has_value()) { return error; }
           }
+          return std::nullopt;
         },
-        inner.description,
-      };
+        std::move(description));
     }
 
-    inline void
+    inline std::optional<std::string>
     check_element_at(
       const std::string& name,
       const nlohmann::json& arr,
       std::size_t index,
       model::ScalarType type) {
       auto v = must_exist_for_scalar(type);
-      if (!v.has_value()) { return; }
+      if (!v.has_value()) { return std::nullopt; }
       if (!arr.is_array() || index >= arr.size()) {
-        throw validate::Error(
-          name + ": expected array with at least " + std::to_string(index + 1) +
-          " elements");
+        return name + ": expected array with at least " +
+               std::to_string(index + 1) + " elements";
       }
       auto elem = std::optional<nlohmann::json>(arr[index]);
-      v->check(name + "[" + std::to_string(index) + "]", elem);
+      return try_validate(*v, name + "[" + std::to_string(index) + "]", elem);
     }
 
-    inline void
+    inline std::optional<std::string>
     check_array_size(
       const std::string& name,
       const nlohmann::json& arr,
       std::size_t expected) {
       if (!arr.is_array() || arr.size() != expected) {
-        throw validate::Error(
-          name + ": expected array of " + std::to_string(expected) +
-          " elements, got " +
-          (arr.is_array() ? std::to_string(arr.size()) : "non-array"));
+        return name + ": expected array of " + std::to_string(expected) +
+               " elements, got " +
+               (arr.is_array() ? std::to_string(arr.size()) : "non-array");
       }
+      return std::nullopt;
+    }
+
+    // Checks each element of a fixed-size tuple value against its type.
+    inline std::optional<std::string>
+    check_tuple(
+      const std::string& name,
+      const nlohmann::json& value,
+      std::initializer_list<model::ScalarType> types) {
+      if (auto error = check_array_size(name, value, types.size())) {
+        return error;
+      }
+      std::size_t index = 0;
+      for (auto type : types) {
+        if (auto error = check_element_at(name, value, index++, type)) {
+          return error;
+        }
+      }
+      return std::nullopt;
     }
 
     inline std::optional<Validator>
@@ -211,16 +280,14 @@ namespace json_commander::validate {
       bool has_fs =
         is_filesystem_type(pt.first) || is_filesystem_type(pt.second);
       if (!has_fs) { return std::nullopt; }
-      return Validator{
+      return from_try_check(
         [pt](
-          const std::string& name, const std::optional<nlohmann::json>& value) {
-          if (!value.has_value()) { return; }
-          check_array_size(name, *value, 2);
-          check_element_at(name, *value, 0, pt.first);
-          check_element_at(name, *value, 1, pt.second);
+          const std::string& name, const std::optional<nlohmann::json>& value)
+          -> std::optional<std::string> {
+          if (!value.has_value()) { return std::nullopt; }
+          return check_tuple(name, *value, {pt.first, pt.second});
         },
-        "must_exist(pair)",
-      };
+        "must_exist(pair)");
     }
 
     inline std::optional<Validator>
@@ -229,17 +296,14 @@ namespace json_commander::validate {
                     is_filesystem_type(tt.second) ||
                     is_filesystem_type(tt.third);
       if (!has_fs) { return std::nullopt; }
-      return Validator{
+      return from_try_check(
         [tt](
-          const std::string& name, const std::optional<nlohmann::json>& value) {
-          if (!value.has_value()) { return; }
-          check_array_size(name, *value, 3);
-          check_element_at(name, *value, 0, tt.first);
-          check_element_at(name, *value, 1, tt.second);
-          check_element_at(name, *value, 2, tt.third);
+          const std::string& name, const std::optional<nlohmann::json>& value)
+          -> std::optional<std::string> {
+          if (!value.has_value()) { return std::nullopt; }
+          return check_tuple(name, *value, {tt.first, tt.second, tt.third});
         },
-        "must_exist(triple)",
-      };
+        "must_exist(triple)");
     }
 
     inline std::optional<Validator>
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <json_commander/config_cache.hpp>
+#include <json_commander/config_file.hpp>
+#include <json_commander/config_schema.hpp>
+#include <json_commander/model.hpp>
+
+#include <nlohmann/json-schema.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace json_commander::watch {
+
+  // A published config and what changed to produce it, as an RFC 6902 JSON
+  // Patch from the previous config ("replace" /serve/port, "add" /level).
+  struct Update {
+    std::shared_ptr<const nlohmann::json> config;
+    nlohmann::json diff;
+  };
+
+  using ChangeFn = std::function<void(const Update& update)>;
+  using ErrorFn = std::function<void(const std::string& message)>;
+
+  // How often files are checked where there is no inotify.
+  inline constexpr std::chrono::milliseconds default_interval{1000};
+
+  // -------------------------------------------------------------------------
+  // Detail: layers
+  // -------------------------------------------------------------------------
+
+  namespace detail {
+
+    // One config file as last read.
+    struct Layer {
+      std::filesystem::path path;
+      config_cache::Stamp stamp;
+      nlohmann::json values;
+    };
+
+    // The directories whose entries decide what the layers are: those of
+    // the declared files (edits usually replace a file by renaming over
+    // it) and the drop-in directory.
+    inline std::set<std::filesystem::path>
+    watched_dirs(
+      const model::Config& config,
+      const std::vector<Layer>& layers,
+      const std::filesystem::path& dir) {
+      std::set<std::filesystem::path> dirs = {dir};
+      for (const auto& layer : layers) {
+        dirs.insert(layer.path.parent_path());
+      }
+      if (!config.paths.has_value()) { return dirs; }
+      const auto& p = *config.paths;
+      for (const auto& path : {p.system, p.user}) {
+        if (path.has_value()) {
+          dirs.insert(config_file::detail::expand_user(*path).parent_path());
+        }
+      }
+      if (p.drop_in.has_value()) {
+        dirs.insert(config_file::detail::expand_user(*p.drop_in));
+      }
+      return dirs;
+    }
+
+  } // namespace detail
+
+  // -------------------------------------------------------------------------
+  // Watcher
+  // -------------------------------------------------------------------------
+
+  // Keeps the config files `root` declares loaded while they change. The
+  // files are loaded as by config_file::load when the Watcher is built;
+  // after that, a background thread notices changes (inotify on Linux,
+  // polling every `interval` elsewhere; a drop-in or config directory that
+  // does not exist yet is picked up once it is created), rereads only the
+  // files whose stamp changed, merges the layers again and publishes the
+  // result. Files are read into memory, not mapped, so one truncated while
+  // it is read is just invalid. The callbacks run on that thread, never
+  // the caller's, and without any of the Watcher's locks held, so they may
+  // call current() and refresh(): `on_change` once for every config
+  // published, whoever published it, `on_error` when a changed file the
+  // thread read cannot be read or does not match the schema, in which
+  // case the last good config stays. current() hands out the published
+  // config; a reader keeps the one it got for as long as it needs, and
+  // never sees a half-made one.
+  class Watcher {
+  public:
+    Watcher(
+      model::Root root,
+      ChangeFn on_change,
+      ErrorFn on_error = nullptr,
+      std::filesystem::path dir = std::filesystem::current_path(),
+      std::chrono::milliseconds interval = default_interval)
+        : root_(std::move(root)),
+          dir_(std::move(dir)),
+          on_change_(std::move(on_change)),
+          on_error_(std::move(on_error)),
+          interval_(interval) {
+      if (!root_.config.has_value()) {
+        throw config_file::Error("no config files declared");
+      }
+      validator_.set_root_schema(config_schema::to_config_file_schema(root_));
+      std::string error;
+      if (!refresh(error)) { throw config_file::Error(error); }
+#ifdef __linux__
+      inotify_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (inotify_ < 0 || ::pipe2(wake_, O_NONBLOCK | O_CLOEXEC) != 0) {
+        auto message = std::generic_category().message(errno);
+        if (inotify_ >= 0) { ::close(inotify_); }
+        throw config_file::Error("watching config files: " + message);
+      }
+      add_watches();
+#endif
+      thread_ = std::thread([this] { loop(); });
+    }
+
+    Watcher(const Watcher&) = delete;
+    Watcher&
+    operator=(const Watcher&) = delete;
+
+    // Stops watching; a callback already running is waited for, ones not
+    // yet started are dropped.
+    ~Watcher() {
+      {
+        std::lock_guard lock(signal_mutex_);
+        stopping_ = true;
+      }
+      wake();
+      thread_.join();
+#ifdef __linux__
+      ::close(inotify_);
+      ::close(wake_[0]);
+      ::close(wake_[1]);
+#endif
+    }
+
+    // The config published last.
+    std::shared_ptr<const nlohmann::json>
+    current() const {
+      std::lock_guard lock(publish_mutex_);
+      return current_;
+    }
+
+    // Checks the files now instead of waiting for the next event, as the
+    // watcher thread does. Returns false, with `error` set and nothing
+    // published, when a changed file is rejected. A config it publishes
+    // is current() on return; `on_change` hears of it on the watcher
+    // thread shortly after.
+    bool
+    refresh(std::string& error) {
+      std::lock_guard lock(refresh_mutex_);
+      auto files = config_file::paths(*root_.config, dir_);
+      if (!files.empty() && root_.config->format != "json") {
+        error = files.front().string() + ": " + root_.config->format +
+                " config files are not supported";
+        return false;
+      }
+
+      std::vector<detail::Layer> layers;
+      bool changed = !current_;
+      for (std::size_t i = 0; i < files.size(); ++i) {
+        // Gone since it was listed; the next event sorts it out.
+        auto stamp = config_cache::stamp(files[i]);
+        if (!stamp.has_value()) { continue; }
+        const auto* old = find(files[i]);
+        if (old != nullptr && old->stamp == *stamp) {
+          layers.push_back(*old);
+          continue;
+        }
+        // Copied rather than mapped: an editor may truncate it meanwhile.
+        auto values = config_file::detail::read_copy(files[i], error);
+        if (!values.has_value()) { return false; }
+        try {
+          validator_.validate(*values);
+        } catch (const std::exception& e) {
+          error = files[i].string() + ": " + e.what();
+          return false;
+        }
+        layers.push_back({files[i], *stamp, std::move(*values)});
+        changed = true;
+      }
+      // Files added, removed or reordered change the merge too.
+      auto same_path = [](const auto& a, const auto& b) {
+        return a.path == b.path;
+      };
+      changed = changed || layers.size() != layers_.size() ||
+                !std::equal(
+                  layers.begin(), layers.end(), layers_.begin(), same_path);
+      if (!changed) { return true; }
+
+      auto merged = nlohmann::json::object();
+      for (const auto& layer : layers) {
+        config_file::detail::merge(merged, layer.values);
+      }
+      layers_ = std::move(layers);
+      auto previous = current();
+      if (previous && *previous == merged) { return true; }
+
+      Update update;
+      update.diff = nlohmann::json::diff(
+        previous ? *previous : nlohmann::json::object(), merged);
+      update.config = std::make_shared<const nlohmann::json>(std::move(merged));
+      {
+        std::lock_guard publish(publish_mutex_);
+        current_ = update.config;
+        if (previous && on_change_) { queued_.push_back(std::move(update)); }
+      }
+      if (previous && on_change_) { wake(); }
+      return true;
+    }
+
+  private:
+    const detail::Layer*
+    find(const std::filesystem::path& path) const {
+      for (const auto& layer : layers_) {
+        if (layer.path == path) { return &layer; }
+      }
+      return nullptr;
+    }
+
+    void
+    reload() {
+      std::string error;
+      if (!refresh(error) && on_error_) { on_error_(error); }
+    }
+
+    // Tells the watcher thread to look at stopping_ and queued_.
+    void
+    wake() {
+#ifdef __linux__
+      char byte = 0;
+      [[maybe_unused]] auto ignored = ::write(wake_[1], &byte, 1);
+#else
+      {
+        std::lock_guard lock(signal_mutex_);
+        woken_ = true;
+      }
+      signal_.notify_all();
+#endif
+    }
+
+    bool
+    stopping() {
+      std::lock_guard lock(signal_mutex_);
+      return stopping_;
+    }
+
+    // Runs on_change for the configs published since the last call, in
+    // order, on the watcher thread and with no lock held.
+    void
+    dispatch() {
+      std::vector<Update> updates;
+      {
+        std::lock_guard publish(publish_mutex_);
+        updates.swap(queued_);
+      }
+      for (const auto& update : updates) {
+        on_change_(update);
+      }
+    }
+
+#ifdef __linux__
+    // Watches every directory that matters, including ones a reload has
+    // brought in. A directory that does not exist yet (a drop-in directory
+    // nobody has made, the parent of a user config) is stood in for by its
+    // nearest existing ancestor, whose events bring the real one in once
+    // it is created; watches nothing needs any more are dropped. Returns
+    // true when a directory is watched that was not before, since files
+    // may have appeared in it before the watch did.
+    bool
+    add_watches() {
+      constexpr std::uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO |
+                                     IN_MOVED_FROM | IN_CREATE | IN_DELETE |
+                                     IN_ATTRIB;
+      std::lock_guard lock(refresh_mutex_);
+      std::set<std::filesystem::path> wanted;
+      for (auto dir : detail::watched_dirs(*root_.config, layers_, dir_)) {
+        std::error_code ec;
+        while (!std::filesystem::is_directory(dir, ec) &&
+               dir.has_relative_path()) {
+          dir = dir.parent_path();
+        }
+        wanted.insert(std::move(dir));
+      }
+      for (auto it = watches_.begin(); it != watches_.end();) {
+        if (wanted.contains(it->first)) {
+          ++it;
+          continue;
+        }
+        ::inotify_rm_watch(inotify_, it->second);
+        it = watches_.erase(it);
+      }
+      bool added = false;
+      for (const auto& dir : wanted) {
+        if (watches_.contains(dir)) { continue; }
+        int wd = ::inotify_add_watch(inotify_, dir.c_str(), mask);
+        if (wd < 0) { continue; }
+        watches_.emplace(dir, wd);
+        added = true;
+      }
+      return added;
+    }
+
+    // Waits for inotify events, then for things to go quiet for a moment,
+    // since one save is often several events. Updates refresh() published
+    // meanwhile are passed on as soon as it wakes the thread.
+    void
+    loop() {
+      char buffer[4096];
+      for (;;) {
+        pollfd fds[2] = {{inotify_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+        int timeout = -1;
+        bool pending = false;
+        for (;;) {
+          int n = ::poll(fds, 2, timeout);
+          if (n < 0 && errno == EINTR) { continue; }
+          if (n < 0) { return; }
+          if (n == 0) { break; }
+          if (fds[1].revents != 0) {
+            while (::read(wake_[0], buffer, sizeof buffer) > 0) {}
+            if (stopping()) { return; }
+            dispatch();
+          }
+          if (fds[0].revents != 0) {
+            while (::read(inotify_, buffer, sizeof buffer) > 0) {}
+            pending = true;
+            timeout = 20;
+          }
+        }
+        if (pending) {
+          reload();
+          if (add_watches()) { reload(); }
+          dispatch();
+        }
+      }
+    }
+#else
+    void
+    loop() {
+      std::unique_lock lock(signal_mutex_);
+      for (;;) {
+        bool woken = signal_.wait_for(
+          lock, interval_, [&] { return stopping_ || woken_; });
+        if (stopping_) { return; }
+        woken_ = false;
+        lock.unlock();
+        if (!woken) { reload(); }
+        dispatch();
+        lock.lock();
+      }
+    }
+#endif
+
+    model::Root root_;
+    std::filesystem::path dir_;
+    ChangeFn on_change_;
+    ErrorFn on_error_;
+    [[maybe_unused]] std::chrono::milliseconds interval_;
+    nlohmann::json_schema::json_validator validator_;
+
+    std::mutex refresh_mutex_;
+    std::vector<detail::Layer> layers_;
+    mutable std::mutex publish_mutex_;
+    std::shared_ptr<const nlohmann::json> current_;
+    std::vector<Update> queued_; // published, on_change not yet run
+
+    std::mutex signal_mutex_;
+    bool stopping_ = false;
+#ifdef __linux__
+    int inotify_ = -1;
+    int wake_[2] = {-1, -1};
+    std::map<std::filesystem::path, int> watches_; // directory, descriptor
+#else
+    std::condition_variable signal_;
+    bool woken_ = false;
+#endif
+    std::thread thread_;
+  };
+
+} // namespace json_commander::watch
@@ -2,7 +2,64 @@
 
 #include <json_commander/run.hpp>
 
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // A packed list of the config, and where it is.
+  struct Found {
+    std::string pointer;
+    const nlohmann::json::binary_t* bytes;
+  };
+
+  std::string
+  escape(const std::string& key) {
+    std::string escaped;
+    for (char c : key) {
+      if (c == '~') {
+        escaped += "~0";
+      } else if (c == '/') {
+        escaped += "~1";
+      } else {
+        escaped += c;
+      }
+    }
+    return escaped;
+  }
+
+  // `j` with each packed list replaced by null. The lists are not copied:
+  // `found` points at them where they are.
+  nlohmann::json
+  strip_packed(
+    const nlohmann::json& j,
+    const std::string& pointer,
+    std::vector<Found>& found) {
+    if (j.is_binary() && j.get_binary().has_subtype()) {
+      found.push_back({pointer, &j.get_binary()});
+      return nullptr;
+    }
+    if (j.is_object()) {
+      auto out = nlohmann::json::object();
+      for (const auto& [key, value] : j.items()) {
+        out[key] = strip_packed(value, pointer + "/" + escape(key), found);
+      }
+      return out;
+    }
+    if (j.is_array()) {
+      auto out = nlohmann::json::array();
+      for (std::size_t i = 0; i < j.size(); ++i) {
+        out.push_back(
+          strip_packed(j[i], pointer + "/" + std::to_string(i), found));
+      }
+      return out;
+    }
+    return j;
+  }
+
+} // namespace
 
 int
 jcmd_run(const char* cli_json, int argc, char* argv[], jcmd_main_fn main_fn) {
@@ -12,7 +69,7 @@ jcmd_run(const char* cli_json, int argc, char* argv[], jcmd_main_fn main_fn) {
       argc,
       argv,
       [main_fn](const nlohmann::json& config) {
-        auto config_str = config.dump();
+        auto config_str = json_commander::conv::unpack_all(config).dump();
         return main_fn(config_str.c_str());
       });
   } catch (const std::exception& e) {
@@ -20,3 +77,31 @@ jcmd_run(const char* cli_json, int argc, char* argv[], jcmd_main_fn main_fn) {
     return 1;
   }
 }
+
+int
+jcmd_run_arrays(
+  const char* cli_json, int argc, char* argv[], jcmd_main_arrays_fn main_fn) {
+  try {
+    return json_commander::run(
+      std::string(cli_json),
+      argc,
+      argv,
+      [main_fn](const nlohmann::json& config) {
+        std::vector<Found> found;
+        auto config_str = strip_packed(config, "", found).dump();
+        std::vector<jcmd_array> arrays;
+        arrays.reserve(found.size());
+        for (const auto& f : found) {
+          arrays.push_back(
+            {f.pointer.c_str(),
+             static_cast<jcmd_array_type>(f.bytes->subtype()),
+             f.bytes->data(),
+             f.bytes->size() / sizeof(std::uint64_t)});
+        }
+        return main_fn(config_str.c_str(), arrays.data(), arrays.size());
+      });
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+}
@@ -1,6 +1,8 @@
 #ifndef JSON_COMMANDER_H
 #define JSON_COMMANDER_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -27,9 +29,42 @@ extern "C" {
 
 typedef int (*jcmd_main_fn)(const char* config_json);
 
+/* Packed lists (list types with "packed": true) reach jcmd_run's main_fn
+ * as plain JSON arrays. */
 JCMD_API int
 jcmd_run(const char* cli_json, int argc, char* argv[], jcmd_main_fn main_fn);
 
+/* --------------------------------------------------------------------------
+ * Packed lists
+ * -------------------------------------------------------------------------- */
+
+/* The element type of a packed list. */
+typedef enum jcmd_array_type {
+  JCMD_INT64 = 1,   /* int64_t: int and duration lists */
+  JCMD_UINT64 = 2,  /* uint64_t: size lists */
+  JCMD_FLOAT64 = 3  /* double: float lists */
+} jcmd_array_type;
+
+/* One packed list of the config. `pointer` is the JSON Pointer of its
+ * place in config_json, where it appears as null; `data` holds `count`
+ * elements of `type`, contiguous and suitably aligned. Both stay valid
+ * until main_fn returns. */
+typedef struct jcmd_array {
+  const char* pointer;
+  jcmd_array_type type;
+  const void* data;
+  size_t count;
+} jcmd_array;
+
+typedef int (*jcmd_main_arrays_fn)(
+  const char* config_json, const jcmd_array* arrays, size_t array_count);
+
+/* Like jcmd_run, but hands packed lists to main_fn as arrays of native
+ * numbers rather than as JSON text. */
+JCMD_API int
+jcmd_run_arrays(
+  const char* cli_json, int argc, char* argv[], jcmd_main_arrays_fn main_fn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,4 +1,5 @@
 #include <json_commander.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -71,8 +72,21 @@ static const char* SCHEMA_WITH_OPTION =
   "\"args\":[{\"kind\":\"option\",\"names\":[\"output\",\"o\"],"
   "\"doc\":[\"Output file\"],\"type\":\"string\",\"default\":\"out.txt\"}]}";
 
+static const char* SCHEMA_WITH_PACKED =
+  "{\"name\":\"app\",\"doc\":[\"A test app\"],"
+  "\"args\":[{\"kind\":\"option\",\"names\":[\"ids\"],"
+  "\"doc\":[\"Ids\"],\"type\":{\"list\":{\"element\":\"int\","
+  "\"packed\":true}}},"
+  "{\"kind\":\"option\",\"names\":[\"weights\"],"
+  "\"doc\":[\"Weights\"],\"type\":{\"list\":{\"element\":\"float\","
+  "\"separator\":\";\",\"packed\":true}},\"default\":[0.5]}]}";
+
 static char last_config[4096];
 static int callback_called;
+static int64_t last_ids[8];
+static double last_weights[8];
+static size_t last_id_count;
+static size_t last_weight_count;
 
 static void
 reset_state(void) {
@@ -88,6 +102,25 @@ capture_callback(const char* config_json) {
   return 0;
 }
 
+static int
+arrays_callback(
+  const char* config_json, const jcmd_array* arrays, size_t array_count) {
+  size_t i;
+  capture_callback(config_json);
+  last_id_count = last_weight_count = 0;
+  for (i = 0; i < array_count; ++i) {
+    const jcmd_array* a = &arrays[i];
+    if (strcmp(a->pointer, "/ids") == 0 && a->type == JCMD_INT64) {
+      last_id_count = a->count;
+      memcpy(last_ids, a->data, a->count * sizeof(int64_t));
+    } else if (strcmp(a->pointer, "/weights") == 0 && a->type == JCMD_FLOAT64) {
+      last_weight_count = a->count;
+      memcpy(last_weights, a->data, a->count * sizeof(double));
+    }
+  }
+  return 0;
+}
+
 static int
 return42_callback(const char* config_json) {
   (void)config_json;
@@ -173,6 +206,38 @@ TEST(test_bad_json_schema) {
   ASSERT_EQ_INT(callback_called, 0);
 }
 
+TEST(test_packed_as_json) {
+  reset_state();
+  char* argv[] = {"app", "--ids", "3,-1,7"};
+  int rc = jcmd_run(SCHEMA_WITH_PACKED, 3, argv, capture_callback);
+  ASSERT_EQ_INT(rc, 0);
+  ASSERT_STR_CONTAINS(last_config, "\"ids\":[3,-1,7]");
+  ASSERT_STR_CONTAINS(last_config, "\"weights\":[0.5]");
+}
+
+TEST(test_packed_arrays) {
+  reset_state();
+  char* argv[] = {"app", "--ids", "3,-1,7", "--weights", "1.5;2"};
+  int rc = jcmd_run_arrays(SCHEMA_WITH_PACKED, 5, argv, arrays_callback);
+  ASSERT_EQ_INT(rc, 0);
+  ASSERT_EQ_INT(callback_called, 1);
+  ASSERT_STR_CONTAINS(last_config, "\"ids\":null");
+  ASSERT_EQ_INT((int)last_id_count, 3);
+  ASSERT(last_ids[0] == 3 && last_ids[1] == -1 && last_ids[2] == 7);
+  ASSERT_EQ_INT((int)last_weight_count, 2);
+  ASSERT(last_weights[0] == 1.5 && last_weights[1] == 2.0);
+}
+
+TEST(test_packed_default) {
+  reset_state();
+  char* argv[] = {"app"};
+  int rc = jcmd_run_arrays(SCHEMA_WITH_PACKED, 1, argv, arrays_callback);
+  ASSERT_EQ_INT(rc, 0);
+  ASSERT_EQ_INT((int)last_id_count, 0);
+  ASSERT_EQ_INT((int)last_weight_count, 1);
+  ASSERT(last_weights[0] == 0.5);
+}
+
 /* --------------------------------------------------------------------------
  * main
  * -------------------------------------------------------------------------- */
@@ -192,6 +257,11 @@ main(void) {
   RUN(test_invalid_schema);
   RUN(test_bad_json_schema);
 
+  printf("\n[jcmd_run_arrays]\n");
+  RUN(test_packed_as_json);
+  RUN(test_packed_arrays);
+  RUN(test_packed_default);
+
   printf("\n%d/%d tests passed\n", tests_passed, tests_run);
   return (tests_passed == tests_run) ? 0 : 1;
 }
@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/batch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace json_commander;
+
+namespace {
+
+  cmd::RootSpec
+  make_spec() {
+    model::Option count{};
+    count.names = {"count", "c"};
+    count.doc = {"doc"};
+    count.type = model::ScalarType::Int;
+    model::Root root{};
+    root.name = "tool";
+    root.doc = {"doc"};
+    root.args = std::vector<model::Argument>{count};
+    return cmd::make(root);
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Batch parsing
+// ===========================================================================
+
+TEST_CASE("batch::try_parse: results in input order", "[batch]") {
+  auto spec = make_spec();
+  std::vector<std::vector<std::string>> inputs;
+  for (int i = 0; i < 500; ++i) {
+    if (i % 10 == 0) {
+      inputs.push_back({"--count", "x"});
+    } else {
+      inputs.push_back({"-c", std::to_string(i)});
+    }
+  }
+  thread_pool::Pool pool(4);
+  auto results = batch::try_parse(spec, inputs, pool, parse::no_env());
+  REQUIRE(results.size() == inputs.size());
+  for (int i = 0; i < 500; ++i) {
+    if (i % 10 == 0) {
+      REQUIRE(results[i].error().kind == parse::ErrorKind::InvalidValue);
+    } else {
+      auto& ok = std::get<parse::ParseOk>(results[i].value());
+      REQUIRE(ok.config["count"] == i);
+    }
+  }
+}
+
+TEST_CASE("batch::parse_all: collects errors per input", "[batch]") {
+  auto spec = make_spec();
+  std::vector<std::vector<std::string>> inputs = {
+    {"--count", "1"},
+    {"--bogus", "--count", "x"},
+    {"--help"},
+  };
+  thread_pool::Pool pool(2);
+  auto results = batch::parse_all(spec, inputs, pool, parse::no_env());
+  REQUIRE(std::holds_alternative<parse::ParseOk>(results[0]));
+  REQUIRE(std::get<parse::ParseErrors>(results[1]).errors.size() == 2);
+  REQUIRE(std::holds_alternative<parse::HelpRequest>(results[2]));
+}
+
+TEST_CASE("batch::try_parse: empty input", "[batch]") {
+  auto spec = make_spec();
+  thread_pool::Pool pool(2);
+  std::vector<std::vector<std::string>> inputs;
+  REQUIRE(batch::try_parse(spec, inputs, pool).empty());
+}
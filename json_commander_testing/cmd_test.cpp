@@ -400,3 +400,96 @@ TEST_CASE("make(Command) excludes man envs exits by construction", "[cmd]") {
   REQUIRE(spec.args.empty());
   REQUIRE(spec.commands.empty());
 }
+
+// ---------------------------------------------------------------------------
+// Phase 9: Precompiled level tables
+// ---------------------------------------------------------------------------
+
+TEST_CASE("make(Root) attaches a level table to every level", "[cmd]") {
+  auto sub = make_command("build");
+  sub.args = std::vector<model::Argument>{make_flag({"force", "f"})};
+  auto root = make_root("tool");
+  root.args = std::vector<model::Argument>{make_flag({"verbose"})};
+  root.commands = std::vector<model::Command>{sub};
+
+  auto spec = cmd::make(root);
+  REQUIRE(spec.table != nullptr);
+  REQUIRE(spec.table->arg_count == 1);
+  REQUIRE(spec.commands[0].table != nullptr);
+  REQUIRE(spec.commands[0].table->names.lookup("-f").has_value());
+}
+
+TEST_CASE("Level table indexes names, positionals and env bindings", "[cmd]") {
+  auto flag = make_flag({"verbose", "v"});
+  flag.env = model::EnvBinding{"VERBOSE"};
+  auto opt = make_option({"output", "o"}, model::ScalarType::String);
+  auto c = make_command("sub");
+  c.args = std::vector<model::Argument>{
+    make_positional("src", model::ScalarType::String),
+    flag,
+    opt,
+    make_positional("dst", model::ScalarType::String),
+  };
+
+  auto spec = cmd::make(c);
+  const auto& table = *spec.table;
+  REQUIRE(table.positionals == std::vector<std::size_t>{0, 3});
+  REQUIRE(table.env_bound == std::vector<std::size_t>{1});
+  auto match = table.names.lookup("--output");
+  REQUIRE(match.has_value());
+  REQUIRE(match->arg_index == 2);
+  REQUIRE(match->kind == cmd::detail::MatchKind::Option);
+  REQUIRE(table.names.lookup("-v")->arg_index == 1);
+}
+
+TEST_CASE("Copies of a spec share the same level table", "[cmd]") {
+  auto c = make_command("sub");
+  c.args = std::vector<model::Argument>{make_flag({"all", "a"})};
+  auto spec = cmd::make(c);
+  auto copy = spec;
+  REQUIRE(copy.table == spec.table);
+}
+
+TEST_CASE("table_for builds a table for specs without one", "[cmd]") {
+  auto c = make_command("sub");
+  c.args = std::vector<model::Argument>{make_flag({"early"})};
+  auto spec = cmd::make(c);
+  auto before = spec.table;
+  spec.args[0] = arg::make(make_flag({"late"}));
+  spec.args.push_back(arg::make(make_flag({"later"})));
+  spec.table = nullptr;
+
+  std::optional<cmd::LevelTable> scratch;
+  const auto& table = cmd::table_for(spec.args, spec.table, scratch);
+  REQUIRE(scratch.has_value());
+  REQUIRE(table.names.lookup("--late").has_value());
+  REQUIRE(table.names.lookup("--later").has_value());
+  REQUIRE_FALSE(table.names.lookup("--early").has_value());
+  auto shared = cmd::shared_table(spec.args, spec.table);
+  REQUIRE(shared != before);
+  REQUIRE(shared->names.lookup("--late").has_value());
+}
+
+TEST_CASE("table_for keeps the table of unchanged args", "[cmd]") {
+  auto c = make_command("sub");
+  c.args = std::vector<model::Argument>{make_flag({"all", "a"})};
+  auto spec = cmd::make(c);
+  auto copy = spec;
+
+  std::optional<cmd::LevelTable> scratch;
+  REQUIRE(&cmd::table_for(copy.args, copy.table, scratch) == spec.table.get());
+  REQUIRE_FALSE(scratch.has_value());
+}
+
+TEST_CASE("make rejects sibling commands with one name", "[cmd]") {
+  auto root = make_root("tool");
+  root.commands =
+    std::vector<model::Command>{make_command("dup"), make_command("dup")};
+  REQUIRE_THROWS_WITH(cmd::make(root), "duplicate command name: dup");
+
+  // The same name at different levels is fine.
+  auto outer = make_command("dup");
+  outer.commands = std::vector<model::Command>{make_command("dup")};
+  root.commands = std::vector<model::Command>{outer};
+  REQUIRE_NOTHROW(cmd::make(root));
+}
@@ -0,0 +1,216 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/cmd.hpp>
+#include <json_commander/command_index.hpp>
+
+#include <stdexcept>
+
+using namespace json_commander;
+
+namespace {
+
+  model::Command
+  make_command(std::string name, std::vector<model::Command> children = {}) {
+    model::Command c{};
+    c.name = std::move(name);
+    c.doc = {"doc"};
+    if (!children.empty()) { c.commands = std::move(children); }
+    return c;
+  }
+
+  // tool
+  //   remote
+  //     add
+  //     remove
+  //   status
+  model::Root
+  make_tree() {
+    model::Root r{};
+    r.name = "tool";
+    r.doc = {"doc"};
+    r.commands = std::vector<model::Command>{
+      make_command("remote", {make_command("add"), make_command("remove")}),
+      make_command("status"),
+    };
+    return r;
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Building and lookup
+// ===========================================================================
+
+TEST_CASE("make: one node per command plus the root", "[command_index]") {
+  auto index = command_index::make(make_tree());
+  REQUIRE(index.size() == 5);
+  REQUIRE(index.child_count(command_index::Index::root) == 2);
+}
+
+TEST_CASE("make: root without commands has no children", "[command_index]") {
+  model::Root r{};
+  r.name = "tool";
+  auto index = command_index::make(r);
+  REQUIRE(index.size() == 1);
+  REQUIRE_FALSE(index.child(command_index::Index::root, "x").has_value());
+}
+
+TEST_CASE("child: resolves one level at a time", "[command_index]") {
+  auto index = command_index::make(make_tree());
+  auto remote = index.child(command_index::Index::root, "remote");
+  REQUIRE(remote.has_value());
+  REQUIRE(index.position(*remote) == 0);
+  auto remove = index.child(*remote, "remove");
+  REQUIRE(remove.has_value());
+  REQUIRE(index.position(*remove) == 1);
+  REQUIRE_FALSE(index.child(*remote, "status").has_value());
+}
+
+TEST_CASE("find: resolves a full path", "[command_index]") {
+  auto index = command_index::make(make_tree());
+  REQUIRE(index.find({}) == command_index::Index::root);
+  REQUIRE(index.find({"remote", "add"}).has_value());
+  REQUIRE_FALSE(index.find({"remote", "nope"}).has_value());
+  REQUIRE_FALSE(index.find({"status", "add"}).has_value());
+}
+
+TEST_CASE("resolve: returns the command in the tree", "[command_index]") {
+  auto root = make_tree();
+  auto index = command_index::make(root);
+  auto node = index.find({"remote", "remove"});
+  REQUIRE(index.resolve(root, *node)->name == "remove");
+  REQUIRE(index.resolve(root, command_index::Index::root) == nullptr);
+}
+
+TEST_CASE("duplicate names: first definition wins", "[command_index]") {
+  model::Root r{};
+  r.name = "tool";
+  auto first = make_command("dup");
+  first.doc = {"first"};
+  auto second = make_command("dup");
+  second.doc = {"second"};
+  r.commands = std::vector<model::Command>{first, second};
+  auto index = command_index::make(r);
+  auto node = index.child(command_index::Index::root, "dup");
+  REQUIRE(index.resolve(r, *node)->doc == model::DocString{"first"});
+}
+
+// ===========================================================================
+// Phase 2: find_command
+// ===========================================================================
+
+TEST_CASE("find_command: returns nested command", "[command_index]") {
+  auto root = make_tree();
+  auto index = command_index::make(root);
+  const auto& cmd =
+    command_index::find_command(root, index, {"remote", "add"});
+  REQUIRE(cmd.name == "add");
+}
+
+TEST_CASE("find_command: throws on unknown segment", "[command_index]") {
+  auto root = make_tree();
+  auto index = command_index::make(root);
+  REQUIRE_THROWS_WITH(
+    command_index::find_command(root, index, {"remote", "nope"}),
+    "subcommand not found: nope");
+}
+
+TEST_CASE("find_command: throws on empty path", "[command_index]") {
+  auto root = make_tree();
+  auto index = command_index::make(root);
+  REQUIRE_THROWS_AS(
+    command_index::find_command(root, index, {}), std::runtime_error);
+}
+
+// ===========================================================================
+// Phase 3: Sharing with compiled specs
+// ===========================================================================
+
+TEST_CASE("cmd::make attaches an index", "[command_index]") {
+  auto spec = cmd::make(make_tree());
+  REQUIRE(spec.index != nullptr);
+  REQUIRE(spec.index->size() == 5);
+}
+
+TEST_CASE("spec index resolves the model tree too", "[command_index]") {
+  auto root = make_tree();
+  auto spec = cmd::make(root);
+  auto node = spec.index->find({"remote", "remove"});
+  REQUIRE(node.has_value());
+  REQUIRE(spec.index->resolve(spec, *node)->name == "remove");
+  REQUIRE(spec.index->resolve(root, *node)->name == "remove");
+}
+
+TEST_CASE("shared_index builds one for hand-built specs", "[command_index]") {
+  cmd::RootSpec spec{};
+  spec.name = "tool";
+  cmd::CommandSpec sub{};
+  sub.name = "build";
+  spec.commands = {sub};
+  auto index = cmd::shared_index(spec);
+  REQUIRE(index->child(command_index::Index::root, "build").has_value());
+}
+
+TEST_CASE("shared_index reuses an unchanged tree's index", "[command_index]") {
+  auto spec = cmd::make(make_tree());
+  auto copy = spec;
+  REQUIRE(cmd::shared_index(copy) == spec.index);
+}
+
+TEST_CASE("shared_index rebuilds a reset index", "[command_index]") {
+  auto spec = cmd::make(make_tree());
+  auto before = spec.index;
+  auto remote = before->find({"remote"});
+  auto& commands = spec.commands[before->position(*remote)].commands;
+  commands.erase(commands.begin());
+  spec.index = nullptr;
+
+  auto index = cmd::shared_index(spec);
+  REQUIRE(index != before);
+  REQUIRE(index->size() == before->size() - 1);
+  for (const auto& command : commands) {
+    auto node = index->find({"remote", command.name});
+    REQUIRE(node.has_value());
+    REQUIRE(index->resolve(spec, *node)->name == command.name);
+  }
+}
+
+// ===========================================================================
+// Phase 4: Prefix lookup
+// ===========================================================================
+
+TEST_CASE("child_by_prefix: unique prefix resolves", "[command_index]") {
+  auto index = command_index::make(make_tree());
+  auto node = index.child_by_prefix(command_index::Index::root, "rem");
+  REQUIRE(node == index.find({"remote"}));
+}
+
+TEST_CASE("child_by_prefix: ambiguous prefix fails", "[command_index]") {
+  model::Root r{};
+  r.name = "tool";
+  r.commands = std::vector<model::Command>{
+    make_command("commit"), make_command("config"), make_command("clone")};
+  auto index = command_index::make(r);
+  const auto root = command_index::Index::root;
+  REQUIRE_FALSE(index.child_by_prefix(root, "co").has_value());
+  REQUIRE(index.child_by_prefix(root, "cl").has_value());
+
+  auto run = index.children_with_prefix(root, "co");
+  REQUIRE(run.size() == 2);
+  REQUIRE(run[0].first == "commit");
+  REQUIRE(run[1].first == "config");
+}
+
+TEST_CASE("PrefixTable: runs are sorted and contiguous", "[command_index]") {
+  command_index::detail::PrefixTable<int> table;
+  for (const auto* name : {"verify", "add", "verbose", "version", "ve"}) {
+    table.insert(name, static_cast<int>(std::string_view(name).size()));
+  }
+  table.sort();
+  auto run = table.with_prefix("ver");
+  REQUIRE(run.size() == 3);
+  REQUIRE(run[0].first == "verbose");
+  REQUIRE(run[2].first == "version");
+  REQUIRE(table.unique("ad") == 3);
+  REQUIRE_FALSE(table.unique("ver").has_value());
+  REQUIRE_FALSE(table.unique("x").has_value());
+}
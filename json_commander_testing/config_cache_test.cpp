@@ -0,0 +1,158 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/config_cache.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace json_commander;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+  struct TempDir {
+    fs::path path;
+    explicit TempDir(const std::string& name)
+        : path(fs::temp_directory_path() / name) {
+      fs::remove_all(path);
+      fs::create_directories(path);
+    }
+    ~TempDir() { fs::remove_all(path); }
+  };
+
+  fs::path
+  write(const fs::path& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+    return path;
+  }
+
+  std::vector<config_cache::Source>
+  sources_of(const std::vector<fs::path>& files) {
+    std::vector<config_cache::Source> sources;
+    for (const auto& f : files) {
+      sources.push_back({f, *config_cache::stamp(f)});
+    }
+    return sources;
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Stamps and entry names
+// ===========================================================================
+
+TEST_CASE("config_cache: stamp follows the file", "[config_cache]") {
+  TempDir dir("jcmd_cache_stamp");
+  auto file = write(dir.path / "a.json", "{}");
+  auto before = config_cache::stamp(file);
+  REQUIRE(before.has_value());
+  REQUIRE(before->size == 2);
+  REQUIRE(config_cache::stamp(file) == before);
+
+  write(file, R"({"a": 1})");
+  REQUIRE(config_cache::stamp(file)->size == 8);
+  REQUIRE_FALSE(config_cache::stamp(dir.path / "missing").has_value());
+}
+
+TEST_CASE("config_cache: entry names are stable", "[config_cache]") {
+  auto a = config_cache::entry_path("/c", "tool", "scope");
+  REQUIRE(a == config_cache::entry_path("/c", "tool", "scope"));
+  REQUIRE(a.parent_path() == fs::path("/c"));
+  REQUIRE(a.filename().string().starts_with("tool-"));
+  REQUIRE(a.extension() == ".cbor");
+  REQUIRE(a != config_cache::entry_path("/c", "tool", "other"));
+  REQUIRE(a != config_cache::entry_path("/c", "tool2", "scope"));
+  REQUIRE(config_cache::detail::fnv1a("") == 14695981039346656037ull);
+  REQUIRE(config_cache::detail::hex(0xabc) == "0000000000000abc");
+}
+
+TEST_CASE("config_cache: directory honors XDG_CACHE_HOME", "[config_cache]") {
+  const char* saved = std::getenv("XDG_CACHE_HOME");
+  std::string previous = saved ? saved : "";
+  ::setenv("XDG_CACHE_HOME", "/var/cache/someone", 1);
+  REQUIRE(
+    config_cache::directory() ==
+    fs::path("/var/cache/someone/json-commander"));
+  if (saved) {
+    ::setenv("XDG_CACHE_HOME", previous.c_str(), 1);
+  } else {
+    ::unsetenv("XDG_CACHE_HOME");
+  }
+}
+
+// ===========================================================================
+// Phase 2: Lookup and store
+// ===========================================================================
+
+TEST_CASE("config_cache: stored entries are found again", "[config_cache]") {
+  TempDir dir("jcmd_cache_store");
+  auto a = write(dir.path / "a.json", "{}");
+  auto b = write(dir.path / "b.json", "{}");
+  auto sources = sources_of({a, b});
+  auto entry = dir.path / "cache" / "tool-x.cbor";
+  json config = {{"level", "high"}, {"serve", {{"port", 80}}}};
+
+  REQUIRE_FALSE(config_cache::lookup(entry, sources, 7).has_value());
+  REQUIRE(config_cache::store(entry, sources, 7, config));
+  REQUIRE(config_cache::lookup(entry, sources, 7) == config);
+  // Nothing but the entry is left behind.
+  auto files = std::distance(
+    fs::directory_iterator(dir.path / "cache"), fs::directory_iterator());
+  REQUIRE(files == 1);
+}
+
+TEST_CASE("config_cache: any change is a miss", "[config_cache]") {
+  TempDir dir("jcmd_cache_miss");
+  auto a = write(dir.path / "a.json", "{}");
+  auto b = write(dir.path / "b.json", "{}");
+  auto sources = sources_of({a, b});
+  auto entry = dir.path / "tool-x.cbor";
+  REQUIRE(config_cache::store(entry, sources, 7, json{{"k", 1}}));
+
+  REQUIRE_FALSE(config_cache::lookup(entry, sources, 8).has_value());
+  REQUIRE_FALSE(config_cache::lookup(entry, sources_of({a}), 7).has_value());
+  REQUIRE_FALSE(
+    config_cache::lookup(entry, sources_of({b, a}), 7).has_value());
+  write(b, R"({"k": 2})");
+  REQUIRE_FALSE(
+    config_cache::lookup(entry, sources_of({a, b}), 7).has_value());
+
+  write(entry, "not cbor");
+  REQUIRE_FALSE(config_cache::lookup(entry, sources, 7).has_value());
+}
+
+TEST_CASE("config_cache: concurrent writers do not collide", "[config_cache]") {
+  TempDir dir("jcmd_cache_threads");
+  auto entry = dir.path / "tool-x.cbor";
+  std::atomic<int> failed{0};
+  std::vector<std::thread> threads;
+  for (std::uint8_t t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      // Each writer's file has its own size and contents.
+      std::vector<std::uint8_t> bytes((t + 1) * 8192, t);
+      for (int i = 0; i < 20; ++i) {
+        if (!config_cache::detail::write_atomic(entry, bytes)) { ++failed; }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(failed == 0);
+  std::ifstream in(entry, std::ios::binary);
+  std::vector<char> read(std::istreambuf_iterator<char>(in), {});
+  REQUIRE_FALSE(read.empty());
+  REQUIRE(read.size() == (static_cast<std::size_t>(read[0]) + 1) * 8192);
+  REQUIRE(std::all_of(read.begin(), read.end(), [&](char c) {
+    return c == read[0];
+  }));
+  auto files = std::distance(
+    fs::directory_iterator(dir.path), fs::directory_iterator());
+  REQUIRE(files == 1);
+}
@@ -0,0 +1,320 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/config_file.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace json_commander;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+  struct TempDir {
+    fs::path path;
+    explicit TempDir(const std::string& name)
+        : path(fs::temp_directory_path() / name) {
+      fs::remove_all(path);
+      fs::create_directories(path);
+    }
+    ~TempDir() { fs::remove_all(path); }
+
+    fs::path
+    write(const std::string& name, const std::string& text) const {
+      auto file = path / name;
+      fs::create_directories(file.parent_path());
+      std::ofstream(file) << text;
+      return file;
+    }
+  };
+
+  model::Root
+  make_root(const TempDir& dir) {
+    model::Option level{};
+    level.names = {"level"};
+    level.doc = {"doc"};
+    level.type = model::ScalarType::String;
+
+    model::Option port{};
+    port.names = {"port"};
+    port.doc = {"doc"};
+    port.type = model::ScalarType::Int;
+
+    model::Command serve{};
+    serve.name = "serve";
+    serve.doc = {"doc"};
+    serve.args = std::vector<model::Argument>{port};
+
+    model::ConfigPaths paths{};
+    paths.system = (dir.path / "etc" / "tool.json").string();
+    paths.user = (dir.path / "home" / "tool.json").string();
+    paths.local = ".tool.json";
+
+    model::Root root{};
+    root.name = "tool";
+    root.doc = {"doc"};
+    root.args = std::vector<model::Argument>{level};
+    root.commands = std::vector<model::Command>{serve};
+    root.config = model::Config{"json", paths};
+    return root;
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Locating files
+// ===========================================================================
+
+TEST_CASE("config_file: only existing files are listed", "[config_file]") {
+  TempDir dir("jcmd_config_paths");
+  auto root = make_root(dir);
+  REQUIRE(config_file::paths(*root.config, dir.path).empty());
+
+  auto user = dir.write("home/tool.json", "{}");
+  auto system = dir.write("etc/tool.json", "{}");
+  REQUIRE(
+    config_file::paths(*root.config, dir.path) ==
+    std::vector<fs::path>{system, user});
+}
+
+TEST_CASE("config_file: local file is searched upward", "[config_file]") {
+  TempDir dir("jcmd_config_local");
+  auto root = make_root(dir);
+  auto outer = dir.write("project/.tool.json", "{}");
+  fs::create_directories(dir.path / "project" / "src" / "deep");
+
+  auto found = config_file::paths(*root.config, dir.path / "project" / "src");
+  REQUIRE(found == std::vector<fs::path>{outer});
+
+  auto inner = dir.write("project/src/.tool.json", "{}");
+  found = config_file::paths(
+    *root.config, dir.path / "project" / "src" / "deep");
+  REQUIRE(found == std::vector<fs::path>{inner});
+}
+
+TEST_CASE("config_file: leading tilde is the home directory", "[config_file]") {
+  const char* saved = std::getenv("HOME");
+  std::string previous = saved ? saved : "";
+  ::setenv("HOME", "/home/someone", 1);
+  REQUIRE(config_file::detail::expand_user("~") == "/home/someone");
+  REQUIRE(
+    config_file::detail::expand_user("~/.config/tool.json") ==
+    fs::path("/home/someone/.config/tool.json"));
+  REQUIRE(config_file::detail::expand_user("a/~/b") == "a/~/b");
+  if (saved) {
+    ::setenv("HOME", previous.c_str(), 1);
+  } else {
+    ::unsetenv("HOME");
+  }
+}
+
+// ===========================================================================
+// Phase 2: Loading and merging
+// ===========================================================================
+
+TEST_CASE("config_file: local over user over system", "[config_file]") {
+  TempDir dir("jcmd_config_merge");
+  auto root = make_root(dir);
+  dir.write(
+    "etc/tool.json", R"({"level": "system", "serve": {"port": 1}})");
+  dir.write("home/tool.json", R"({"level": "user"})");
+  dir.write("work/.tool.json", R"({"serve": {"port": 3}})");
+
+  auto merged = config_file::load(root, dir.path / "work");
+  REQUIRE(merged == json{{"level", "user"}, {"serve", {{"port", 3}}}});
+}
+
+TEST_CASE("config_file: nothing declared or found", "[config_file]") {
+  TempDir dir("jcmd_config_none");
+  auto root = make_root(dir);
+  REQUIRE(config_file::load(root, dir.path) == json::object());
+  root.config.reset();
+  REQUIRE(config_file::load(root, dir.path) == json::object());
+  dir.write("etc/tool.json", "");
+  root = make_root(dir);
+  REQUIRE(config_file::load(root, dir.path) == json::object());
+}
+
+TEST_CASE("config_file: unreadable files are errors", "[config_file]") {
+  TempDir dir("jcmd_config_bad");
+  auto root = make_root(dir);
+  auto system = dir.write("etc/tool.json", "{\"level\": ");
+  std::string error;
+  REQUIRE_FALSE(config_file::try_load(root, error, dir.path).has_value());
+  REQUIRE(error == system.string() + ": invalid JSON");
+
+  dir.write("etc/tool.json", "[1, 2]");
+  REQUIRE_FALSE(config_file::try_load(root, error, dir.path).has_value());
+  REQUIRE(error == system.string() + ": expected an object");
+
+  dir.write("etc/tool.json", "{}");
+  root.config->format = "yaml";
+  REQUIRE_THROWS_AS(config_file::load(root, dir.path), config_file::Error);
+}
+
+TEST_CASE("config_file: copied reads match mapped ones", "[config_file]") {
+  TempDir dir("jcmd_config_copy");
+  std::string error;
+  for (const auto* text : {R"({"level": "x"})", "", "[]", "{"}) {
+    auto file = dir.write("tool.json", text);
+    std::string mapped_error;
+    auto mapped = config_file::detail::read(file, mapped_error);
+    REQUIRE(config_file::detail::read_copy(file, error) == mapped);
+    REQUIRE(error == mapped_error);
+  }
+  auto missing = dir.path / "missing.json";
+  REQUIRE_FALSE(config_file::detail::read_copy(missing, error).has_value());
+  REQUIRE(error == missing.string() + ": No such file or directory");
+}
+
+TEST_CASE("config_file: values must match the schema", "[config_file]") {
+  TempDir dir("jcmd_config_schema");
+  auto root = make_root(dir);
+  auto user = dir.write("home/tool.json", R"({"serve": {"port": "x"}})");
+  std::string error;
+  REQUIRE_FALSE(config_file::try_load(root, error, dir.path).has_value());
+  REQUIRE(error.starts_with(user.string() + ": "));
+}
+
+// ===========================================================================
+// Phase 3: Drop-in directories
+// ===========================================================================
+
+TEST_CASE(
+  "config_file: fragments are listed in lexical order", "[config_file]") {
+  TempDir dir("jcmd_config_dropin_order");
+  auto root = make_root(dir);
+  root.config->paths->drop_in = (dir.path / "conf.d").string();
+  auto system = dir.write("etc/tool.json", "{}");
+  auto b = dir.write("conf.d/20-b.json", "{}");
+  auto a = dir.write("conf.d/10-a.json", "{}");
+  auto c = dir.write("conf.d/3-c.json", "{}");
+  dir.write("conf.d/.hidden.json", "{");
+  dir.write("conf.d/notes.txt", "{");
+  fs::create_directories(dir.path / "conf.d" / "sub.json");
+  auto user = dir.write("home/tool.json", "{}");
+
+  REQUIRE(
+    config_file::paths(*root.config, dir.path) ==
+    std::vector<fs::path>{system, a, b, c, user});
+}
+
+TEST_CASE(
+  "config_file: fragments merge like a sequential load", "[config_file]") {
+  TempDir dir("jcmd_config_dropin_merge");
+  auto root = make_root(dir);
+  root.config->paths->drop_in = (dir.path / "conf.d").string();
+  dir.write("etc/tool.json", R"({"level": "system", "serve": {"port": 1}})");
+  json expected = {{"level", "system"}, {"serve", {{"port", 1}}}};
+  for (int i = 0; i < 200; ++i) {
+    auto name = std::to_string(1000 + i);
+    json fragment = {{"serve", {{"port", i}}}};
+    if (i % 7 == 0) { fragment["level"] = name; }
+    dir.write("conf.d/" + name + ".json", fragment.dump());
+    config_file::detail::merge(expected, fragment);
+  }
+  dir.write("home/tool.json", R"({"serve": {"port": 5000}})");
+  config_file::detail::merge(expected, json{{"serve", {{"port", 5000}}}});
+
+  REQUIRE(config_file::load(root, dir.path) == expected);
+  REQUIRE(config_file::load(root, dir.path)["level"] == "1196");
+}
+
+TEST_CASE(
+  "config_file: first bad fragment in order is reported", "[config_file]") {
+  TempDir dir("jcmd_config_dropin_bad");
+  auto root = make_root(dir);
+  root.config->paths->drop_in = (dir.path / "conf.d").string();
+  for (int i = 0; i < 50; ++i) {
+    dir.write("conf.d/" + std::to_string(100 + i) + ".json", "{}");
+  }
+  auto first = dir.write("conf.d/120.json", "{");
+  dir.write("conf.d/140.json", "[]");
+  std::string error;
+  REQUIRE_FALSE(config_file::try_load(root, error, dir.path).has_value());
+  REQUIRE(error == first.string() + ": invalid JSON");
+}
+
+TEST_CASE("config_file: few or small files are read in turn", "[config_file]") {
+  TempDir dir("jcmd_config_read_serial");
+  std::vector<fs::path> files;
+  for (int i = 0; i < 50; ++i) {
+    files.push_back(dir.write(std::to_string(i) + ".json", "{}"));
+  }
+  REQUIRE_FALSE(config_file::detail::worth_parallel(files));
+  files.resize(config_file::detail::parallel_files - 1);
+  REQUIRE_FALSE(config_file::detail::worth_parallel(files));
+}
+
+TEST_CASE(
+  "config_file: large files read in parallel keep their order",
+  "[config_file]") {
+  TempDir dir("jcmd_config_read_parallel");
+  std::vector<fs::path> files;
+  auto padding = std::string(config_file::detail::parallel_bytes / 4, ' ');
+  for (int i = 0; i < 8; ++i) {
+    auto text = "{\"n\": " + std::to_string(i) + padding + "}";
+    files.push_back(dir.write(std::to_string(i) + ".json", text));
+  }
+  REQUIRE(config_file::detail::worth_parallel(files));
+  auto parsed = config_file::detail::read_all(files);
+  REQUIRE(parsed.size() == files.size());
+  for (std::size_t i = 0; i < parsed.size(); ++i) {
+    REQUIRE(parsed[i].value.has_value());
+    REQUIRE((*parsed[i].value)["n"] == i);
+  }
+}
+
+// ===========================================================================
+// Phase 4: Cache
+// ===========================================================================
+
+TEST_CASE("config_file: cached result is reused", "[config_file]") {
+  TempDir dir("jcmd_config_cache");
+  const char* saved = std::getenv("XDG_CACHE_HOME");
+  std::string previous = saved ? saved : "";
+  ::setenv("XDG_CACHE_HOME", (dir.path / "cache").c_str(), 1);
+
+  auto root = make_root(dir);
+  root.config->cache = true;
+  auto system = dir.write("etc/tool.json", R"({"level": "system"})");
+  REQUIRE(config_file::load(root, dir.path) == json{{"level", "system"}});
+
+  // Replace the entry's config: an unchanged source means it is used as is.
+  auto entries = std::vector<fs::path>(
+    fs::directory_iterator(dir.path / "cache" / "json-commander"),
+    fs::directory_iterator());
+  REQUIRE(entries.size() == 1);
+  auto fingerprint = config_file::fingerprint(root);
+  std::vector<config_cache::Source> sources = {
+    {system, *config_cache::stamp(system)}};
+  config_cache::store(
+    entries[0], sources, fingerprint, json{{"level", "cached"}});
+  REQUIRE(config_file::load(root, dir.path) == json{{"level", "cached"}});
+  // A fingerprint the caller already has keys the same entry.
+  std::string error;
+  REQUIRE(
+    config_file::try_load(root, fingerprint, error, dir.path) ==
+    json{{"level", "cached"}});
+  REQUIRE_FALSE(
+    config_file::try_load(root, fingerprint + 1, error, dir.path) ==
+    json{{"level", "cached"}});
+
+  // Changing the file invalidates it.
+  dir.write("etc/tool.json", R"({"level": "changed"})");
+  REQUIRE(config_file::load(root, dir.path) == json{{"level", "changed"}});
+
+  // Without the opt-in nothing is cached.
+  root.config->cache.reset();
+  fs::remove_all(dir.path / "cache");
+  REQUIRE(config_file::load(root, dir.path) == json{{"level", "changed"}});
+  REQUIRE_FALSE(fs::exists(dir.path / "cache"));
+
+  if (saved) {
+    ::setenv("XDG_CACHE_HOME", previous.c_str(), 1);
+  } else {
+    ::unsetenv("XDG_CACHE_HOME");
+  }
+}
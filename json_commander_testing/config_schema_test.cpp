@@ -199,6 +199,16 @@ TEST_CASE(
   REQUIRE(result == json({{"type", "string"}}));
 }
 
+TEST_CASE(
+  "scalar_type_schema: Size and Duration are non-negative integers",
+  "[config_schema]") {
+  for (auto type : {model::ScalarType::Size, model::ScalarType::Duration}) {
+    REQUIRE(
+      config_schema::detail::scalar_type_schema(type) ==
+      json({{"type", "integer"}, {"minimum", 0}}));
+  }
+}
+
 TEST_CASE(
   "scalar_type_schema: Enum without choices maps to {type: string}",
   "[config_schema]") {
@@ -246,6 +256,30 @@ TEST_CASE(
   REQUIRE(result == json({{"type", "array"}, {"items", {{"type", "string"}}}}));
 }
 
+TEST_CASE(
+  "type_spec_schema: ListType cap becomes maxItems", "[config_schema]") {
+  model::ListType lt{};
+  lt.element = model::ScalarType::Int;
+  lt.max_elements = 3;
+  auto result = config_schema::detail::type_spec_schema(lt);
+  REQUIRE(
+    result == json(
+                {{"type", "array"},
+                 {"items", {{"type", "integer"}}},
+                 {"maxItems", 3}}));
+}
+
+TEST_CASE(
+  "type_spec_schema: packed lists are published as arrays",
+  "[config_schema]") {
+  model::ListType lt{};
+  lt.element = model::ScalarType::Size;
+  lt.packed = true;
+  REQUIRE(
+    config_schema::detail::type_spec_schema(lt) ==
+    json{{"type", "array"}, {"items", {{"type", "integer"}, {"minimum", 0}}}});
+}
+
 TEST_CASE(
   "type_spec_schema: PairType produces tuple with items array",
   "[config_schema]") {
@@ -919,3 +953,41 @@ TEST_CASE(
     parse_to_config(root, {"--verbose", "build", "--target", "release"});
   REQUIRE_NOTHROW(validate_config(schema, config));
 }
+
+// ---------------------------------------------------------------------------
+// Phase 9: to_config_file_schema
+// ---------------------------------------------------------------------------
+
+TEST_CASE(
+  "to_config_file_schema: nests subcommands, requires nothing",
+  "[config_schema][file]") {
+  auto opt = make_option({"target"}, model::ScalarType::String);
+  opt.required = true;
+  auto build_cmd = make_command("build", {opt});
+  auto root =
+    make_root_with_commands("mytool", {make_flag({"verbose"})}, {build_cmd});
+  auto schema = config_schema::to_config_file_schema(root);
+  REQUIRE(schema["title"] == "mytool configuration file");
+  REQUIRE(schema["properties"]["verbose"] == json{{"type", "boolean"}});
+  const auto& build = schema["properties"]["build"];
+  REQUIRE(build["properties"]["target"] == json{{"type", "string"}});
+  REQUIRE(build["additionalProperties"] == false);
+  REQUIRE_FALSE(schema.contains("required"));
+  REQUIRE_FALSE(build.contains("required"));
+  REQUIRE_FALSE(schema["properties"].contains("command"));
+}
+
+TEST_CASE(
+  "to_config_file_schema: partial files validate",
+  "[config_schema][file]") {
+  auto build_cmd = make_command(
+    "build", {make_option({"target"}, model::ScalarType::String)});
+  auto root =
+    make_root_with_commands("mytool", {make_flag({"verbose"})}, {build_cmd});
+  auto schema = config_schema::to_config_file_schema(root);
+  REQUIRE_NOTHROW(validate_config(schema, json::object()));
+  REQUIRE_NOTHROW(
+    validate_config(schema, json{{"build", {{"target", "release"}}}}));
+  REQUIRE_THROWS(validate_config(schema, json{{"build", {{"target", 1}}}}));
+  REQUIRE_THROWS(validate_config(schema, json{{"unknown", true}}));
+}
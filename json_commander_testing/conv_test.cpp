@@ -1,6 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include <json_commander/conv.hpp>
 
+#include <cstdint>
+#include <vector>
+
 using namespace json_commander::conv;
 using json = nlohmann::json;
 
@@ -399,3 +402,313 @@ TEST_CASE("round-trip: triple", "[conv]") {
   auto c = triple_conv(int_conv(), int_conv(), int_conv(), ",");
   REQUIRE(c.format(c.parse("255,128,0")) == "255,128,0");
 }
+
+// ---------------------------------------------------------------------------
+// Phase 8: Non-throwing conversion
+// ---------------------------------------------------------------------------
+
+TEST_CASE("try_convert: built-in converter reports the error", "[conv]") {
+  auto c = list_conv(int_conv(), ",");
+  REQUIRE(c.kind == Kind::List);
+  std::string error;
+  REQUIRE_FALSE(try_convert(c, "1,x", error).has_value());
+  REQUIRE(error == "expected integer, got 'x'");
+  REQUIRE(try_convert(c, "1,2", error) == json({1, 2}));
+}
+
+TEST_CASE("try_convert: float range and syntax errors", "[conv]") {
+  std::string error;
+  REQUIRE_FALSE(try_convert(float_conv(), "1e999", error).has_value());
+  REQUIRE(error == "float value out of range: '1e999'");
+  REQUIRE_FALSE(try_convert(float_conv(), "1.5x", error).has_value());
+  REQUIRE(error == "expected float, got '1.5x'");
+}
+
+TEST_CASE("try_convert: falls back to a throwing parse", "[conv]") {
+  Converter c{
+    [](const std::string&) -> json { throw Error("nope"); },
+    [](const json&) { return std::string(); },
+    "X"};
+  std::string error;
+  REQUIRE_FALSE(try_convert(c, "a", error).has_value());
+  REQUIRE(error == "nope");
+}
+
+TEST_CASE("try_convert: pair element errors propagate", "[conv]") {
+  auto c = pair_conv(string_conv(), int_conv(), "=");
+  std::string error;
+  REQUIRE_FALSE(try_convert(c, "k=v", error).has_value());
+  REQUIRE(error == "expected integer, got 'v'");
+  REQUIRE(try_convert(c, "k=1", error) == json({"k", 1}));
+}
+
+// ---------------------------------------------------------------------------
+// Phase 9: Descriptors
+// ---------------------------------------------------------------------------
+
+TEST_CASE("scalar converters carry no payload", "[conv]") {
+  for (const auto& c :
+       {string_conv(),
+        int_conv(),
+        float_conv(),
+        bool_conv(),
+        file_conv(),
+        dir_conv(),
+        path_conv()}) {
+    REQUIRE(c.kind != Kind::Custom);
+    REQUIRE(c.payload == nullptr);
+  }
+  REQUIRE(make(json_commander::model::ScalarType::Int).kind == Kind::Int);
+}
+
+TEST_CASE("copies share the payload", "[conv]") {
+  auto c = pair_conv(enum_conv({"a", "b"}), list_conv(int_conv(), ";"), "=");
+  auto copy = c;
+  REQUIRE(copy.payload == c.payload);
+  REQUIRE(copy.payload->parts[0].kind == Kind::Enum);
+  REQUIRE(copy.parse("a=1;2") == json({"a", {1, 2}}));
+  REQUIRE(copy.format(json({"b", {3}})) == "b=3");
+  REQUIRE_THROWS_AS(copy.parse("c=1"), Error);
+}
+
+TEST_CASE("tuple separators after the last part stay in it", "[conv]") {
+  auto c = pair_conv(string_conv(), string_conv(), "=");
+  REQUIRE(c.parse("k=v=w") == json({"k", "v=w"}));
+  auto t = triple_conv(string_conv(), string_conv(), string_conv(), "::");
+  REQUIRE(t.parse("a::b::c::d") == json({"a", "b", "c::d"}));
+  REQUIRE_THROWS_AS(t.parse("a::b"), Error);
+}
+
+TEST_CASE("custom converters nest inside built-in ones", "[conv]") {
+  Converter upper{
+    [](const std::string& s) -> json {
+      if (s.empty()) { throw Error("empty word"); }
+      std::string out = s;
+      for (auto& ch : out) {
+        ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+      }
+      return out;
+    },
+    [](const json& j) { return j.get<std::string>(); },
+    "WORD"};
+  REQUIRE(upper.kind == Kind::Custom);
+  auto c = list_conv(upper, ",");
+  REQUIRE(c.docv == "WORD,...");
+  REQUIRE(c.parse("a,bc") == json({"A", "BC"}));
+  std::string error;
+  REQUIRE_FALSE(try_convert(c, "a,,b", error).has_value());
+  REQUIRE(error == "empty word");
+}
+
+// ---------------------------------------------------------------------------
+// Phase 10: 64-bit numbers, sizes and durations
+// ---------------------------------------------------------------------------
+
+TEST_CASE("int_conv reads 64-bit integers", "[conv]") {
+  auto c = int_conv();
+  REQUIRE(c.parse("4294967296") == json(std::int64_t{4294967296}));
+  REQUIRE(c.parse("-9223372036854775808") == json(INT64_MIN));
+  REQUIRE(c.format(json(INT64_MAX)) == "9223372036854775807");
+  std::string error;
+  REQUIRE_FALSE(try_convert(c, "-9223372036854775809", error).has_value());
+  REQUIRE(error == "integer out of range: '-9223372036854775809'");
+  REQUIRE_FALSE(try_convert(c, "+1", error).has_value());
+  REQUIRE(error == "expected integer, got '+1'");
+}
+
+TEST_CASE("int_conv reads integers past int64 as uint64", "[conv]") {
+  auto c = int_conv();
+  auto large = c.parse("18446744073709551615");
+  REQUIRE(large.is_number_unsigned());
+  REQUIRE(large == json(UINT64_MAX));
+  REQUIRE(c.format(large) == "18446744073709551615");
+  REQUIRE(c.parse("9223372036854775807").is_number_integer());
+  REQUIRE_FALSE(c.parse("9223372036854775807").is_number_unsigned());
+  std::string error;
+  REQUIRE_FALSE(try_convert(c, "18446744073709551616", error).has_value());
+  REQUIRE(error == "integer out of range: '18446744073709551616'");
+  REQUIRE_FALSE(try_convert(c, "-", error).has_value());
+  REQUIRE(error == "expected integer, got '-'");
+}
+
+TEST_CASE("float_conv reads without the locale", "[conv]") {
+  auto c = float_conv();
+  REQUIRE(c.parse("+2.5") == json(2.5));
+  REQUIRE(c.parse("1e3") == json(1000.0));
+  REQUIRE(c.parse("-0.125") == json(-0.125));
+  REQUIRE_THROWS_AS(c.parse("2,5"), Error);
+  REQUIRE_THROWS_AS(c.parse(" 1"), Error);
+  REQUIRE_THROWS_AS(c.parse("+-1"), Error);
+}
+
+TEST_CASE("size_conv reads binary units", "[conv]") {
+  auto c = size_conv();
+  REQUIRE(c.docv == "SIZE");
+  REQUIRE(c.parse("512") == json(512u));
+  REQUIRE(c.parse("4K") == json(4096u));
+  REQUIRE(c.parse("4k") == json(4096u));
+  REQUIRE(c.parse("4KB") == json(4096u));
+  REQUIRE(c.parse("4KiB") == json(4096u));
+  REQUIRE(c.parse("10B") == json(10u));
+  REQUIRE(c.parse("1.5G") == json(std::uint64_t{1610612736}));
+  REQUIRE(c.parse(".5K") == json(512u));
+  REQUIRE(c.parse("3T") == json(std::uint64_t{3} << 40));
+  REQUIRE(c.parse("15E") == json(std::uint64_t{15} << 60));
+  REQUIRE(c.parse("1.0001K") == json(1024u));
+  REQUIRE(c.format(c.parse("2M")) == "2097152");
+}
+
+TEST_CASE("size_conv rejects malformed sizes", "[conv]") {
+  auto c = size_conv();
+  std::string error;
+  for (const char* bad : {"", "K", "-1K", "1X", "1iB", "1.2.3K", "4 K"}) {
+    REQUIRE_FALSE(try_convert(c, bad, error).has_value());
+    REQUIRE(error == std::string("expected size, got '") + bad + "'");
+  }
+  REQUIRE_FALSE(try_convert(c, "16E", error).has_value());
+  REQUIRE(error == "size out of range: '16E'");
+}
+
+TEST_CASE("duration_conv reads milliseconds", "[conv]") {
+  auto c = duration_conv();
+  REQUIRE(c.docv == "DURATION");
+  REQUIRE(c.parse("250ms") == json(250));
+  REQUIRE(c.parse("2h") == json(7200000));
+  REQUIRE(c.parse("1h30m") == json(5400000));
+  REQUIRE(c.parse("1.5s") == json(1500));
+  REQUIRE(c.parse("1d2s") == json(86402000));
+  REQUIRE(c.parse("0") == json(0));
+  REQUIRE(c.format(json(5400000)) == "1h30m");
+  REQUIRE(c.format(json(250)) == "250ms");
+  REQUIRE(c.format(json(0)) == "0s");
+  REQUIRE(c.format(c.parse("90061001ms")) == "1d1h1m1s1ms");
+}
+
+TEST_CASE("duration_conv rejects malformed durations", "[conv]") {
+  auto c = duration_conv();
+  std::string error;
+  for (const char* bad : {"", "5", "ms", "1x", "1H", "-1s", "1h 2m"}) {
+    REQUIRE_FALSE(try_convert(c, bad, error).has_value());
+    REQUIRE(error == std::string("expected duration, got '") + bad + "'");
+  }
+  REQUIRE_FALSE(try_convert(c, "9999999999999999d", error).has_value());
+  REQUIRE(error == "duration out of range: '9999999999999999d'");
+}
+
+TEST_CASE("make maps size and duration", "[conv]") {
+  using json_commander::model::ScalarType;
+  REQUIRE(make(ScalarType::Size).kind == Kind::Size);
+  REQUIRE(make(ScalarType::Duration).kind == Kind::Duration);
+  auto c = make(json_commander::model::ListType{ScalarType::Size, ","});
+  REQUIRE(c.parse("1K,2K") == json({1024u, 2048u}));
+}
+
+// ---------------------------------------------------------------------------
+// Phase 11: Bulk list parsing
+// ---------------------------------------------------------------------------
+
+TEST_CASE("numeric lists parse in bulk", "[conv]") {
+  std::string text;
+  auto expected = json::array();
+  for (std::int64_t i = 0; i < 100000; ++i) {
+    if (i > 0) text += ',';
+    text += std::to_string(i * 7 - 350000);
+    expected.push_back(i * 7 - 350000);
+  }
+  auto c = list_conv(int_conv(), ",", 100000);
+  REQUIRE(c.parse(text) == expected);
+  REQUIRE_THROWS_AS(list_conv(int_conv()).parse(text), Error);
+
+  REQUIRE(
+    list_conv(float_conv(), ";").parse("1.5;-2;3e2") ==
+    json({1.5, -2.0, 300.0}));
+  REQUIRE(list_conv(size_conv()).parse("1K,2") == json({1024u, 2u}));
+  REQUIRE(list_conv(duration_conv()).parse("1s,2m") == json({1000, 120000}));
+}
+
+TEST_CASE("bulk list reports the first bad element", "[conv]") {
+  std::string error;
+  auto c = list_conv(int_conv());
+  REQUIRE_FALSE(try_convert(c, "1,2,x,y", error).has_value());
+  REQUIRE(error == "expected integer, got 'x'");
+  REQUIRE_FALSE(try_convert(c, "1,,3", error).has_value());
+  REQUIRE(error == "expected integer, got empty string");
+  REQUIRE_FALSE(try_convert(c, "1,2,", error).has_value());
+  REQUIRE(error == "expected integer, got empty string");
+}
+
+TEST_CASE("multi-character list separators", "[conv]") {
+  REQUIRE(list_conv(int_conv(), "::").parse("1::2::3") == json({1, 2, 3}));
+  REQUIRE(
+    list_conv(string_conv(), "::").parse("a:b::c") == json({"a:b", "c"}));
+  REQUIRE(
+    list_conv(string_conv(), ", ").parse("a, b,c") == json({"a", "b,c"}));
+  REQUIRE_THROWS_AS(list_conv(int_conv(), "::", 2).parse("1::2::3"), Error);
+}
+
+TEST_CASE("list element cap comes from the type", "[conv]") {
+  using json_commander::model::ListType;
+  using json_commander::model::ScalarType;
+  auto c = make(ListType{ScalarType::Int, std::nullopt, 2});
+  REQUIRE(c.parse("1,2") == json({1, 2}));
+  std::string error;
+  REQUIRE_FALSE(try_convert(c, "1,2,3", error).has_value());
+  REQUIRE(error == "list exceeds maximum element count (2)");
+  auto uncapped = make(ListType{ScalarType::String, std::nullopt});
+  REQUIRE(uncapped.kind == Kind::List);
+  std::string text(default_max_elements - 1, ',');
+  REQUIRE(try_convert(uncapped, text, error).has_value());
+  REQUIRE_FALSE(try_convert(uncapped, text + ",", error).has_value());
+}
+
+// ---------------------------------------------------------------------------
+// Phase 12: Packed lists
+// ---------------------------------------------------------------------------
+
+TEST_CASE("packed lists convert to one typed binary", "[conv]") {
+  auto ints = list_conv(int_conv(), ",", default_max_elements, true);
+  REQUIRE(is_packed(ints));
+  auto j = ints.parse("1,-2,9007199254740993");
+  REQUIRE(j.is_binary());
+  REQUIRE(j.get_binary().subtype() == std::uint8_t(Packed::Int64));
+  REQUIRE(j.get_binary().size() == 3 * sizeof(std::int64_t));
+  REQUIRE(
+    unpack<std::int64_t>(j) ==
+    std::vector<std::int64_t>{1, -2, 9007199254740993});
+  REQUIRE(ints.format(j) == "1,-2,9007199254740993");
+  REQUIRE(unpack<std::int64_t>(ints.parse("")).empty());
+  REQUIRE_THROWS_AS(unpack<double>(j), Error);
+  std::string error;
+  REQUIRE_FALSE(try_convert(ints, "1,x", error).has_value());
+  REQUIRE(error == "expected integer, got 'x'");
+
+  auto sizes = list_conv(size_conv(), ",", default_max_elements, true);
+  REQUIRE(
+    unpack<std::uint64_t>(sizes.parse("1K,2")) ==
+    std::vector<std::uint64_t>{1024, 2});
+  auto floats = list_conv(float_conv(), ",", default_max_elements, true);
+  REQUIRE(
+    unpack<double>(floats.parse("0.5,2")) == std::vector<double>{0.5, 2});
+}
+
+TEST_CASE("only lists of numbers pack", "[conv]") {
+  auto strings = list_conv(string_conv(), ",", default_max_elements, true);
+  REQUIRE_FALSE(is_packed(strings));
+  REQUIRE(strings.parse("a,b") == json({"a", "b"}));
+  REQUIRE(pack(strings, json{"a"}) == json{"a"});
+}
+
+TEST_CASE("arrays pack and unpack", "[conv]") {
+  using json_commander::model::ListType;
+  using json_commander::model::ScalarType;
+  auto c =
+    make(ListType{ScalarType::Duration, std::nullopt, std::nullopt, true});
+  REQUIRE(is_packed(c));
+  auto packed = pack(c, json{1000, 60000});
+  REQUIRE(packed == c.parse("1s,1m"));
+  REQUIRE(pack(c, json("1s")) == json("1s"));
+  json config = {{"serve", {{"timeouts", packed}}}, {"name", "x"}};
+  REQUIRE(
+    unpack_all(config) ==
+    json{{"serve", {{"timeouts", {1000, 60000}}}}, {"name", "x"}});
+}
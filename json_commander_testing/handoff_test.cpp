@@ -0,0 +1,173 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/handoff.hpp>
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace json_commander;
+using json = nlohmann::json;
+
+namespace {
+
+  // The command line the tests' configs were parsed from.
+  const char* const argv[] = {"serve", "--port", "8080"};
+  constexpr int argc = 3;
+
+  handoff::Payload
+  payload_for(std::string program, json config) {
+    return {std::move(program), std::move(config), handoff::digest(argc, argv)};
+  }
+
+  // Shares `payload` the way exec would, without replacing the process.
+  int
+  hand_over(const handoff::Payload& payload) {
+    int fd = handoff::share(payload);
+    ::setenv(handoff::fd_variable, std::to_string(fd).c_str(), 1);
+    return fd;
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Sharing and receiving
+// ===========================================================================
+
+TEST_CASE("handoff: config round-trips through the descriptor", "[handoff]") {
+  json config = {{"port", 8080}, {"files", {"a", "b"}}, {"verbose", true}};
+  hand_over(payload_for("serve", config));
+
+  std::string error;
+  auto received = handoff::try_receive("serve", argc, argv, error);
+  REQUIRE(error.empty());
+  REQUIRE(received == config);
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+  REQUIRE_FALSE(handoff::receive("serve", argc, argv).has_value());
+}
+
+TEST_CASE("handoff: packed lists keep their type", "[handoff]") {
+  json config = {
+    {"ids", json::binary({1, 0, 0, 0, 0, 0, 0, 0}, 1)}, {"port", 8080}};
+  hand_over(payload_for("serve", config));
+
+  auto received = handoff::receive("serve", argc, argv);
+  REQUIRE(received == config);
+  REQUIRE((*received)["ids"].get_binary().subtype() == 1);
+}
+
+TEST_CASE("handoff: the command path travels along", "[handoff]") {
+  auto payload = payload_for("git", {{"all", true}});
+  payload.command_path = {"remote", "prune"};
+  hand_over(payload);
+
+  std::string error;
+  auto received = handoff::try_receive_payload("git", argc, argv, error);
+  REQUIRE(error.empty());
+  REQUIRE(received == payload);
+}
+
+TEST_CASE("handoff: config for another program is dropped", "[handoff]") {
+  int fd = hand_over(payload_for("serve", {{"port", 1}}));
+
+  std::string error;
+  REQUIRE_FALSE(handoff::try_receive("other", argc, argv, error).has_value());
+  REQUIRE(error.empty());
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+  REQUIRE(::fcntl(fd, F_GETFD) == -1);
+  REQUIRE_FALSE(handoff::receive("serve", argc, argv).has_value());
+}
+
+TEST_CASE("handoff: config for other arguments is dropped", "[handoff]") {
+  const char* const help[] = {"serve", "--help"};
+  const char* const split[] = {"serve", "--port8080"};
+  for (const auto* other : {help, split}) {
+    int fd = hand_over(payload_for("serve", {{"port", 8080}}));
+    std::string error;
+    REQUIRE_FALSE(handoff::try_receive("serve", 2, other, error).has_value());
+    REQUIRE(error.empty());
+    REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+    REQUIRE(::fcntl(fd, F_GETFD) == -1);
+  }
+}
+
+TEST_CASE("handoff: argv[0] is not part of the digest", "[handoff]") {
+  const char* const renamed[] = {"/usr/bin/serve", "--port", "8080"};
+  REQUIRE(handoff::digest(3, renamed) == handoff::digest(argc, argv));
+  REQUIRE(handoff::digest({"ab", "c"}) != handoff::digest({"a", "bc"}));
+  REQUIRE(handoff::digest({}) != handoff::digest({""}));
+}
+
+TEST_CASE("handoff: bad descriptor variable is an error", "[handoff]") {
+  ::setenv(handoff::fd_variable, "seven", 1);
+  std::string error;
+  REQUIRE_FALSE(handoff::try_receive("serve", argc, argv, error).has_value());
+  REQUIRE(error == "JCMD_CONFIG_FD: not a descriptor: seven");
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+  ::setenv(handoff::fd_variable, "seven", 1);
+  REQUIRE_THROWS_AS(handoff::receive("serve", argc, argv), handoff::Error);
+}
+
+TEST_CASE("handoff: standard streams are never a payload", "[handoff]") {
+  for (const char* fd : {"0", "1", "2"}) {
+    ::setenv(handoff::fd_variable, fd, 1);
+    std::string error;
+    REQUIRE_FALSE(handoff::try_receive("serve", argc, argv, error));
+    REQUIRE(error == std::string("JCMD_CONFIG_FD: not a descriptor: ") + fd);
+    REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+    REQUIRE(::fcntl(STDIN_FILENO, F_GETFD) != -1);
+  }
+}
+
+TEST_CASE("handoff: malformed payload is an error", "[handoff]") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  ::close(fds[1]);
+  ::setenv(handoff::fd_variable, std::to_string(fds[0]).c_str(), 1);
+  std::string error;
+  REQUIRE_FALSE(handoff::try_receive("serve", argc, argv, error).has_value());
+  REQUIRE(error == "JCMD_CONFIG_FD: malformed config payload");
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+  ::close(fds[0]);
+}
+
+#ifdef __linux__
+TEST_CASE("handoff: the descriptor is sealed", "[handoff]") {
+  int fd = handoff::share({"serve", {{"port", 1}}});
+  REQUIRE(::write(fd, "x", 1) == -1);
+  REQUIRE(::ftruncate(fd, 0) == -1);
+  ::close(fd);
+}
+#endif
+
+// ===========================================================================
+// Phase 2: Exec
+// ===========================================================================
+
+TEST_CASE("handoff: exec passes the descriptor on", "[handoff]") {
+  pid_t pid = ::fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    try {
+      handoff::exec(
+        {"serve", {{"port", 1}}},
+        {"sh", "-c", "test -e /dev/fd/$JCMD_CONFIG_FD && exit 7"});
+    } catch (...) {
+    }
+    ::_exit(1);
+  }
+  int status = 0;
+  REQUIRE(::waitpid(pid, &status, 0) == pid);
+  REQUIRE(WIFEXITED(status));
+  REQUIRE(WEXITSTATUS(status) == 7);
+}
+
+TEST_CASE("handoff: exec of a missing program throws", "[handoff]") {
+  REQUIRE_THROWS_AS(
+    handoff::exec({"serve", json::object()}, {"/nonexistent/program"}),
+    handoff::Error);
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+  REQUIRE_THROWS_AS(
+    handoff::exec({"serve", json::object()}, {}), handoff::Error);
+}
@@ -0,0 +1,226 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/incremental.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace json_commander;
+
+namespace {
+
+  std::shared_ptr<const incremental::Grammar>
+  make_grammar() {
+    model::Flag verbose{};
+    verbose.names = {"verbose", "v"};
+    verbose.doc = {"Be chatty"};
+
+    model::Option format{};
+    format.names = {"format", "f"};
+    format.doc = {"Output format"};
+    format.type = model::ScalarType::String;
+    format.choices = std::vector<std::string>{"json", "text", "toml"};
+
+    model::Option port{};
+    port.names = {"port"};
+    port.doc = {"Port to bind"};
+    port.type = model::ScalarType::Int;
+
+    model::Positional file{};
+    file.name = "file";
+    file.doc = {"Input file"};
+    file.type = model::ScalarType::File;
+
+    model::Command serve{};
+    serve.name = "serve";
+    serve.doc = {"Start the server"};
+    serve.args = std::vector<model::Argument>{port};
+
+    model::Command show{};
+    show.name = "show";
+    show.doc = {"Show a file"};
+    show.args = std::vector<model::Argument>{file};
+
+    model::Root root{};
+    root.name = "tool";
+    root.doc = {"doc"};
+    root.version = "1.0";
+    root.args = std::vector<model::Argument>{verbose, format};
+    root.commands = std::vector<model::Command>{serve, show};
+    return std::make_shared<const incremental::Grammar>(root);
+  }
+
+  std::vector<std::string>
+  option_names(const incremental::Next& next) {
+    std::vector<std::string> names;
+    for (const auto& info : next.options) {
+      names.push_back(info.long_name);
+    }
+    return names;
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Lookahead
+// ===========================================================================
+
+TEST_CASE(
+  "incremental: empty line offers options and commands", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  auto next = parser.next();
+  REQUIRE_FALSE(next.done);
+  REQUIRE_FALSE(next.value.has_value());
+  REQUIRE(
+    option_names(next) ==
+    std::vector<std::string>{
+      "help", "help-man", "help-completion", "version", "verbose", "format"});
+  REQUIRE(next.commands.size() == 2);
+  REQUIRE(next.commands[0].name == "serve");
+  REQUIRE(next.commands[0].description == "Start the server");
+  REQUIRE_FALSE(next.positional.has_value());
+}
+
+TEST_CASE(
+  "incremental: partial word narrows the candidates", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  REQUIRE(
+    option_names(parser.next("--help")) ==
+    std::vector<std::string>{"help", "help-man", "help-completion"});
+  REQUIRE(
+    option_names(parser.next("-v")) == std::vector<std::string>{"verbose"});
+  auto next = parser.next("se");
+  REQUIRE(next.options.empty());
+  REQUIRE(next.commands.size() == 1);
+  REQUIRE(next.commands[0].name == "serve");
+}
+
+TEST_CASE("incremental: option awaiting its value", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  parser.feed("-f");
+  auto next = parser.next("t");
+  REQUIRE(next.value.has_value());
+  REQUIRE(next.value->name == "--format");
+  REQUIRE(next.value->docv == "STRING");
+  REQUIRE(next.value->choices == std::vector<std::string>{"text", "toml"});
+  REQUIRE(next.options.empty());
+  REQUIRE(next.commands.empty());
+}
+
+TEST_CASE("incremental: --help-completion expects a shell", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  parser.feed("--help-completion");
+  auto next = parser.next();
+  REQUIRE(next.value.has_value());
+  REQUIRE(
+    next.value->choices ==
+    std::vector<std::string>{"bash", "zsh", "fish"});
+}
+
+TEST_CASE("incremental: subcommand switches the level", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  parser.feed("show");
+  REQUIRE(parser.command_path() == std::vector<std::string>{"show"});
+  auto next = parser.next();
+  REQUIRE(
+    option_names(next) ==
+    std::vector<std::string>{"help", "help-man", "help-completion"});
+  REQUIRE(next.commands.empty());
+  REQUIRE(next.positional.has_value());
+  REQUIRE(next.positional->name == "file");
+  REQUIRE(next.positional->is_file);
+
+  parser.feed("a.txt");
+  REQUIRE_FALSE(parser.next().positional.has_value());
+}
+
+TEST_CASE("incremental: after -- only positionals remain", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  parser.feed("show");
+  parser.feed("--");
+  auto next = parser.next();
+  REQUIRE(next.options.empty());
+  REQUIRE(next.positional.has_value());
+}
+
+TEST_CASE("incremental: request decides the line", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  REQUIRE_FALSE(parser.feed("--help"));
+  REQUIRE_FALSE(parser.feed("serve"));
+  REQUIRE(parser.next().done);
+  REQUIRE(std::holds_alternative<parse::HelpRequest>(parser.finish()));
+}
+
+// ===========================================================================
+// Phase 2: Snapshots and results
+// ===========================================================================
+
+TEST_CASE(
+  "incremental: errors are kept as the line goes on", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  REQUIRE(parser.feed("--bogus"));
+  REQUIRE(parser.feed("serve"));
+  REQUIRE(parser.errors().size() == 1);
+  REQUIRE(parser.errors()[0].kind == parse::ErrorKind::UnknownOption);
+  REQUIRE(parser.errors()[0].token == 0u);
+  REQUIRE(parser.command_path() == std::vector<std::string>{"serve"});
+}
+
+TEST_CASE("incremental: copies resume independently", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  parser.feed("--verbose");
+  auto snapshot = parser;
+
+  parser.feed("serve");
+  parser.feed("--port");
+  parser.feed("80");
+  snapshot.feed("show");
+  snapshot.feed("b.txt");
+
+  auto served = std::get<parse::ParseOk>(parser.finish(parse::no_env()));
+  REQUIRE(served.config["verbose"] == true);
+  REQUIRE(served.config["serve"]["port"] == 80);
+  auto shown = std::get<parse::ParseOk>(snapshot.finish(parse::no_env()));
+  REQUIRE(shown.config["show"]["file"] == "b.txt");
+  REQUIRE(snapshot.size() == 3);
+}
+
+TEST_CASE("incremental: finish matches parse_all", "[incremental]") {
+  auto grammar = make_grammar();
+  std::vector<std::vector<std::string>> lines = {
+    {"-vf", "json", "serve", "--port", "8080"},
+    {"--format"},
+    {"serve", "--port", "x", "extra"},
+    {"--help-completion", "tcsh"},
+    {},
+  };
+  for (const auto& line : lines) {
+    incremental::Parser parser(grammar);
+    for (const auto& token : line) {
+      parser.feed(token);
+    }
+    auto expected = parse::parse_all(grammar->spec(), line, parse::no_env());
+    auto actual = parser.finish(parse::no_env());
+    REQUIRE(actual.index() == expected.index());
+    if (auto* ok = std::get_if<parse::ParseOk>(&expected)) {
+      REQUIRE(std::get<parse::ParseOk>(actual).config == ok->config);
+    }
+    if (auto* errors = std::get_if<parse::ParseErrors>(&expected)) {
+      const auto& got = std::get<parse::ParseErrors>(actual).errors;
+      REQUIRE(got.size() == errors->errors.size());
+      for (std::size_t i = 0; i < got.size(); ++i) {
+        REQUIRE(got[i].message == errors->errors[i].message);
+        REQUIRE(got[i].token == errors->errors[i].token);
+      }
+    }
+  }
+}
+
+TEST_CASE("incremental: finish leaves the parser usable", "[incremental]") {
+  incremental::Parser parser(make_grammar());
+  parser.feed("--format");
+  REQUIRE(std::holds_alternative<parse::ParseErrors>(parser.finish()));
+  parser.feed("json");
+  auto ok = std::get<parse::ParseOk>(parser.finish(parse::no_env()));
+  REQUIRE(ok.config["format"] == "json");
+}
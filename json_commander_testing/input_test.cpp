@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/input.hpp>
+
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+using namespace json_commander;
+
+namespace {
+
+  // Both ends of a pipe; the test writes what the stream reads.
+  struct Pipe {
+    int fds[2] = {-1, -1};
+
+    Pipe() { REQUIRE(::pipe(fds) == 0); }
+
+    ~Pipe() {
+      close_write();
+      ::close(fds[0]);
+    }
+
+    int
+    read_end() const {
+      return fds[0];
+    }
+
+    void
+    write(std::string_view data) {
+      REQUIRE(
+        ::write(fds[1], data.data(), data.size()) ==
+        static_cast<ssize_t>(data.size()));
+    }
+
+    void
+    close_write() {
+      if (fds[1] >= 0) { ::close(fds[1]); }
+      fds[1] = -1;
+    }
+  };
+
+  arg::PositionalSpec
+  positional(model::ScalarType type) {
+    model::Positional pos{};
+    pos.name = "items";
+    pos.doc = {"Items"};
+    pos.type = type;
+    pos.repeated = true;
+    pos.from_stdin = "newline";
+    return arg::make(pos);
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Delimited values
+// ===========================================================================
+
+TEST_CASE("input: newline separated values", "[input]") {
+  Pipe pipe;
+  pipe.write("1\n2\r\n\n3");
+  pipe.close_write();
+  input::Stream values(
+    pipe.read_end(), '\n', positional(model::ScalarType::Int));
+  REQUIRE(values.next() == 1);
+  REQUIRE(values.next() == 2);
+  REQUIRE(values.next() == 3);
+  REQUIRE_FALSE(values.next().has_value());
+  REQUIRE_FALSE(values.next().has_value());
+}
+
+TEST_CASE("input: NUL separated values keep newlines", "[input]") {
+  Pipe pipe;
+  pipe.write(std::string_view("a b\0c\nd\0", 8));
+  pipe.close_write();
+  input::Stream values(
+    pipe.read_end(), '\0', positional(model::ScalarType::String));
+  REQUIRE(values.next() == "a b");
+  REQUIRE(values.next() == "c\nd");
+  REQUIRE_FALSE(values.next().has_value());
+}
+
+TEST_CASE("input: a bad value ends the stream", "[input]") {
+  Pipe pipe;
+  pipe.write("1\nx\n3\n");
+  pipe.close_write();
+  input::Stream values(
+    pipe.read_end(), '\n', positional(model::ScalarType::Int));
+  REQUIRE(values.next() == 1);
+  REQUIRE_THROWS_AS(values.next(), input::Error);
+  REQUIRE_FALSE(values.next().has_value());
+}
+
+TEST_CASE("input: default stream is empty", "[input]") {
+  input::Stream values;
+  REQUIRE_FALSE(values.next().has_value());
+}
+
+// ===========================================================================
+// Phase 2: Pipelining
+// ===========================================================================
+
+TEST_CASE("input: values arrive before the input ends", "[input]") {
+  Pipe pipe;
+  input::Stream values(
+    pipe.read_end(), '\n', positional(model::ScalarType::String));
+  pipe.write("first\n");
+  REQUIRE(values.next() == "first");
+  pipe.write("sec");
+  pipe.write("ond\n");
+  REQUIRE(values.next() == "second");
+  pipe.close_write();
+  REQUIRE_FALSE(values.next().has_value());
+}
+
+TEST_CASE("input: more input than the queue holds", "[input]") {
+  Pipe pipe;
+  input::Stream values(
+    pipe.read_end(), '\n', positional(model::ScalarType::Int), 4);
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    data += std::to_string(i) + "\n";
+  }
+  pipe.write(data);
+  pipe.close_write();
+  for (int i = 0; i < 1000; ++i) {
+    REQUIRE(values.next() == i);
+  }
+  REQUIRE_FALSE(values.next().has_value());
+}
+
+TEST_CASE("input: stopping early does not wait for the input", "[input]") {
+  Pipe pipe;
+  {
+    input::Stream values(
+      pipe.read_end(), '\n', positional(model::ScalarType::Int), 1);
+    pipe.write("1\n2\n3\n");
+    REQUIRE(values.next() == 1);
+    // The writer stays open: the reader is blocked and must be woken.
+  }
+  pipe.write("4\n");
+}
@@ -0,0 +1,262 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/memo.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace json_commander;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+  struct TempDir {
+    fs::path path;
+    explicit TempDir(const std::string& name)
+        : path(fs::temp_directory_path() / name) {
+      fs::remove_all(path);
+      fs::create_directories(path);
+    }
+    ~TempDir() { fs::remove_all(path); }
+  };
+
+  // Points XDG_CACHE_HOME at a directory for the lifetime of the guard.
+  struct CacheHome {
+    std::string previous;
+    bool had = false;
+    explicit CacheHome(const fs::path& dir) {
+      if (const char* value = std::getenv("XDG_CACHE_HOME")) {
+        previous = value;
+        had = true;
+      }
+      ::setenv("XDG_CACHE_HOME", dir.c_str(), 1);
+    }
+    ~CacheHome() {
+      if (had) {
+        ::setenv("XDG_CACHE_HOME", previous.c_str(), 1);
+      } else {
+        ::unsetenv("XDG_CACHE_HOME");
+      }
+    }
+  };
+
+  struct Argv {
+    std::vector<std::string> storage;
+    std::vector<const char*> ptrs;
+    Argv(std::initializer_list<std::string> args) : storage(args) {
+      for (const auto& s : storage) {
+        ptrs.push_back(s.c_str());
+      }
+    }
+    int
+    argc() const {
+      return static_cast<int>(ptrs.size());
+    }
+    const char* const*
+    argv() const {
+      return ptrs.data();
+    }
+  };
+
+  model::Root
+  make_root() {
+    model::Option level{};
+    level.names = {"level"};
+    level.doc = {"doc"};
+    level.type = model::ScalarType::String;
+    level.env = model::EnvBinding{"JCMD_MEMO_LEVEL"};
+
+    model::Positional input{};
+    input.name = "input";
+    input.doc = {"doc"};
+    input.type = model::ScalarType::File;
+    input.must_exist = true;
+
+    model::Command build{};
+    build.name = "build";
+    build.doc = {"doc"};
+    build.args = std::vector<model::Argument>{input};
+
+    model::Root root{};
+    root.name = "gen";
+    root.doc = {"doc"};
+    root.args = std::vector<model::Argument>{level};
+    root.commands = std::vector<model::Command>{build};
+    root.parsing = model::Parsing{};
+    root.parsing->memoize = true;
+    return root;
+  }
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Keys
+// ===========================================================================
+
+TEST_CASE("memo: opting in", "[memo]") {
+  auto root = make_root();
+  REQUIRE(memo::enabled(root));
+  root.parsing->memoize = false;
+  REQUIRE_FALSE(memo::enabled(root));
+  root.parsing.reset();
+  REQUIRE_FALSE(memo::enabled(root));
+}
+
+TEST_CASE("memo: key covers arguments, env and schema", "[memo]") {
+  auto root = make_root();
+  ::unsetenv("JCMD_MEMO_LEVEL");
+  Argv a{"gen", "build", "x"};
+  auto key = memo::key(root, a.argc(), a.argv());
+  REQUIRE(key.has_value());
+  REQUIRE(memo::key(root, a.argc(), a.argv()) == key);
+
+  // argv[0] is not part of it.
+  Argv renamed{"/usr/bin/gen", "build", "x"};
+  REQUIRE(memo::key(root, renamed.argc(), renamed.argv()) == key);
+
+  Argv b{"gen", "build", "y"};
+  REQUIRE(memo::key(root, b.argc(), b.argv()) != key);
+
+  ::setenv("JCMD_MEMO_LEVEL", "high", 1);
+  REQUIRE(memo::key(root, a.argc(), a.argv()) != key);
+  ::unsetenv("JCMD_MEMO_LEVEL");
+
+  auto changed = root;
+  changed.version = "2.0";
+  REQUIRE(memo::key(changed, a.argc(), a.argv()) != key);
+
+  // A profile worked out once serves every key of its root.
+  auto profile = memo::profile(root);
+  REQUIRE(profile.env == std::vector<std::string>{"JCMD_MEMO_LEVEL"});
+  REQUIRE(profile.fingerprint == config_file::fingerprint(root));
+  REQUIRE(memo::key(root, profile, a.argc(), a.argv()) == key);
+}
+
+TEST_CASE("memo: key follows config file stamps", "[memo]") {
+  TempDir dir("jcmd_memo_config");
+  auto root = make_root();
+  model::ConfigPaths paths{};
+  paths.system = (dir.path / "gen.json").string();
+  root.config = model::Config{"json", paths};
+  Argv a{"gen"};
+
+  auto none = memo::key(root, a.argc(), a.argv(), dir.path);
+  std::ofstream(dir.path / "gen.json") << R"({"level": "a"})";
+  auto one = memo::key(root, a.argc(), a.argv(), dir.path);
+  REQUIRE(one != none);
+  std::ofstream(dir.path / "gen.json") << R"({"level": "ab"})";
+  REQUIRE(memo::key(root, a.argc(), a.argv(), dir.path) != one);
+}
+
+TEST_CASE("memo: response files are not remembered", "[memo]") {
+  auto root = make_root();
+  Argv a{"gen", "@args.txt"};
+  REQUIRE(memo::key(root, a.argc(), a.argv()).has_value());
+  root.parsing->response_files = model::ResponseFiles{};
+  REQUIRE_FALSE(memo::key(root, a.argc(), a.argv()).has_value());
+}
+
+// ===========================================================================
+// Phase 2: Entries
+// ===========================================================================
+
+TEST_CASE("memo: stored entries are found again", "[memo]") {
+  TempDir dir("jcmd_memo_store");
+  CacheHome home(dir.path);
+  auto root = make_root();
+  memo::Entry entry{{{"level", "high"}}, {}};
+
+  REQUIRE_FALSE(memo::lookup(root, "k1").has_value());
+  REQUIRE(memo::store(root, "k1", entry));
+  REQUIRE(memo::lookup(root, "k1") == entry);
+  REQUIRE_FALSE(memo::lookup(root, "k2").has_value());
+  REQUIRE(fs::is_directory(dir.path / "json-commander" / "memo"));
+}
+
+TEST_CASE("memo: the oldest entries are dropped past the cap", "[memo]") {
+  TempDir dir("jcmd_memo_cap");
+  CacheHome home(dir.path);
+  auto root = make_root();
+  memo::Entry entry{{{"level", "high"}}, {}};
+  auto memo_dir = dir.path / "json-commander" / "memo";
+
+  REQUIRE(memo::store(root, "old", entry, 2));
+  REQUIRE(memo::store(root, "mid", entry, 2));
+  // Make the order unambiguous whatever the file system's time resolution.
+  auto now = fs::file_time_type::clock::now();
+  for (const auto& [key, age] : {std::pair{"old", 2}, std::pair{"mid", 1}}) {
+    auto path = config_cache::entry_path(memo_dir, root.name, key);
+    fs::last_write_time(path, now - std::chrono::hours(age));
+  }
+  REQUIRE(memo::store(root, "new", entry, 2));
+  REQUIRE_FALSE(memo::lookup(root, "old").has_value());
+  REQUIRE(memo::lookup(root, "mid") == entry);
+  REQUIRE(memo::lookup(root, "new") == entry);
+
+  // Other programs' entries are not counted or touched.
+  auto other = make_root();
+  other.name = "other";
+  REQUIRE(memo::store(other, "k", entry, 1));
+  REQUIRE(memo::lookup(root, "mid") == entry);
+
+  memo::clear(root);
+  REQUIRE_FALSE(memo::lookup(root, "mid").has_value());
+  REQUIRE_FALSE(memo::lookup(root, "new").has_value());
+  REQUIRE(memo::lookup(other, "k") == entry);
+}
+
+TEST_CASE("memo: rewriting an entry does not prune", "[memo]") {
+  TempDir dir("jcmd_memo_rewrite");
+  CacheHome home(dir.path);
+  auto root = make_root();
+  memo::Entry entry{{{"level", "high"}}, {}};
+
+  REQUIRE(memo::store(root, "a", entry, 2));
+  REQUIRE(memo::store(root, "b", entry, 2));
+  // Only a new entry can take the count past the cap.
+  REQUIRE(memo::store(root, "b", entry, 1));
+  REQUIRE(memo::lookup(root, "a") == entry);
+  auto memo_dir = dir.path / "json-commander" / "memo";
+  auto past = fs::file_time_type::clock::now() - std::chrono::hours(1);
+  for (const auto* key : {"a", "b"}) {
+    fs::last_write_time(
+      config_cache::entry_path(memo_dir, root.name, key), past);
+  }
+  REQUIRE(memo::store(root, "c", entry, 1));
+  REQUIRE_FALSE(memo::lookup(root, "a").has_value());
+  REQUIRE_FALSE(memo::lookup(root, "b").has_value());
+  REQUIRE(memo::lookup(root, "c") == entry);
+}
+
+TEST_CASE("memo: must_exist paths are checked again", "[memo]") {
+  TempDir dir("jcmd_memo_exists");
+  CacheHome home(dir.path);
+  auto root = make_root();
+  auto input = (dir.path / "in.txt").string();
+  std::ofstream(input) << "x";
+  memo::Entry entry{{{"build", {{"input", input}}}}, {"build"}};
+
+  REQUIRE(memo::store(root, "k", entry));
+  REQUIRE(memo::lookup(root, "k") == entry);
+  fs::remove(input);
+  REQUIRE_FALSE(memo::lookup(root, "k").has_value());
+}
+
+TEST_CASE("memo: stdin positionals are not remembered", "[memo]") {
+  TempDir dir("jcmd_memo_stdin");
+  CacheHome home(dir.path);
+  auto root = make_root();
+  auto& build = (*root.commands)[0];
+  auto& input = std::get<model::Positional>((*build.args)[0]);
+  input.must_exist.reset();
+  input.repeated = true;
+  input.from_stdin = "newline";
+  memo::Entry entry{{{"build", json::object()}}, {"build"}};
+  REQUIRE_FALSE(memo::store(root, "k", entry));
+  REQUIRE_FALSE(memo::lookup(root, "k").has_value());
+}
@@ -259,6 +259,19 @@ TEST_CASE("Option argument", "[metaschema][args][option]") {
             {"choices", {"json", "yaml", "toml"}}}}}}));
   }
 
+  SECTION("option with size and duration types") {
+    for (const char* type : {"size", "duration"}) {
+      expect_valid(
+        schema,
+        app(
+          {{"args",
+            {{{"kind", "option"},
+              {"names", {"limit"}},
+              {"doc", {"Limit"}},
+              {"type", type}}}}}));
+    }
+  }
+
   SECTION("option with list type") {
     expect_valid(
       schema,
@@ -271,6 +284,36 @@ TEST_CASE("Option argument", "[metaschema][args][option]") {
              {{"list", {{"element", "string"}, {"separator", ","}}}}}}}}}));
   }
 
+  SECTION("list with element cap") {
+    auto with_cap = [](const json& cap) {
+      return app(
+        {{"args",
+          {{{"kind", "option"},
+            {"names", {"ids"}},
+            {"doc", {"Ids"}},
+            {"type",
+             {{"list", {{"element", "int"}, {"max_elements", cap}}}}}}}}});
+    };
+    expect_valid(schema, with_cap(100000));
+    expect_invalid(schema, with_cap(0));
+    expect_invalid(schema, with_cap("many"));
+  }
+
+  SECTION("packed lists must hold numbers") {
+    auto packed = [](const char* element) {
+      return app(
+        {{"args",
+          {{{"kind", "option"},
+            {"names", {"ids"}},
+            {"doc", {"Ids"}},
+            {"type",
+             {{"list", {{"element", element}, {"packed", true}}}}}}}}});
+    };
+    expect_valid(schema, packed("int"));
+    expect_valid(schema, packed("duration"));
+    expect_invalid(schema, packed("string"));
+  }
+
   SECTION("option with pair type") {
     expect_valid(
       schema,
@@ -385,6 +428,45 @@ TEST_CASE("Positional argument", "[metaschema][args][positional]") {
         {{"args",
           {{{"kind", "positional"}, {"name", "input"}, {"doc", {"Input"}}}}}}));
   }
+
+  SECTION("positional read from stdin") {
+    expect_valid(
+      schema,
+      app(
+        {{"args",
+          {{{"kind", "positional"},
+            {"name", "files"},
+            {"doc", {"Input files"}},
+            {"type", "file"},
+            {"repeated", true},
+            {"from_stdin", "nul"}}}}}));
+  }
+
+  SECTION("positional read from stdin must be repeated") {
+    expect_invalid(
+      schema,
+      app(
+        {{"args",
+          {{{"kind", "positional"},
+            {"name", "files"},
+            {"doc", {"Input files"}},
+            {"type", "file"},
+            {"from_stdin", "newline"}}}}}));
+  }
+
+  SECTION("positional read from stdin cannot be required") {
+    expect_invalid(
+      schema,
+      app(
+        {{"args",
+          {{{"kind", "positional"},
+            {"name", "files"},
+            {"doc", {"Input files"}},
+            {"type", "file"},
+            {"required", true},
+            {"repeated", true},
+            {"from_stdin", "newline"}}}}}));
+  }
 }
 
 // ---------------------------------------------------------------------------
@@ -715,6 +797,25 @@ TEST_CASE("Config specification", "[metaschema][config]") {
           {{"format", "toml"}, {"paths", {{"local", ".myapp.toml"}}}}}}));
   }
 
+  SECTION("config with drop-in directory") {
+    expect_valid(
+      schema,
+      app(
+        {{"config",
+          {{"format", "json"},
+           {"paths", {{"drop_in", "/etc/myapp/conf.d"}}}}}}));
+    expect_invalid(
+      schema,
+      app({{"config", {{"format", "json"}, {"paths", {{"drop_in", 1}}}}}}));
+  }
+
+  SECTION("config with cache") {
+    expect_valid(
+      schema, app({{"config", {{"format", "json"}, {"cache", true}}}}));
+    expect_invalid(
+      schema, app({{"config", {{"format", "json"}, {"cache", "yes"}}}}));
+  }
+
   SECTION("config missing format") {
     expect_invalid(schema, app({{"config", {{"paths", {}}}}}));
   }
@@ -734,6 +835,67 @@ TEST_CASE("Config specification", "[metaschema][config]") {
   }
 }
 
+// ---------------------------------------------------------------------------
+// Parser settings
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Parsing settings", "[metaschema][parsing]") {
+  auto schema = load_metaschema();
+
+  SECTION("abbreviations enabled") {
+    expect_valid(schema, app({{"parsing", {{"abbreviations", true}}}}));
+  }
+
+  SECTION("empty parsing object") {
+    expect_valid(schema, app({{"parsing", json::object()}}));
+  }
+
+  SECTION("abbreviations must be boolean") {
+    expect_invalid(schema, app({{"parsing", {{"abbreviations", "yes"}}}}));
+  }
+
+  SECTION("unknown parsing setting") {
+    expect_invalid(schema, app({{"parsing", {{"fuzzy", true}}}}));
+  }
+
+  SECTION("response files") {
+    expect_valid(
+      schema, app({{"parsing", {{"response_files", json::object()}}}}));
+    expect_valid(
+      schema,
+      app(
+        {{"parsing",
+          {{"response_files", {{"delimiter", "nul"}, {"max_depth", 0}}}}}}));
+  }
+
+  SECTION("memoize") {
+    expect_valid(schema, app({{"parsing", {{"memoize", true}}}}));
+    expect_invalid(schema, app({{"parsing", {{"memoize", 1}}}}));
+  }
+
+  SECTION("response file delimiter must be known") {
+    expect_invalid(
+      schema,
+      app({{"parsing", {{"response_files", {{"delimiter", "tab"}}}}}}));
+  }
+
+  SECTION("response file depth must not be negative") {
+    expect_invalid(
+      schema,
+      app({{"parsing", {{"response_files", {{"max_depth", -1}}}}}}));
+  }
+
+  SECTION("parsing not allowed on subcommands") {
+    expect_invalid(
+      schema,
+      app(
+        {{"commands",
+          {{{"name", "sub"},
+            {"doc", {"A subcommand"}},
+            {"parsing", {{"abbreviations", true}}}}}}}));
+  }
+}
+
 // ---------------------------------------------------------------------------
 // Cross-cutting: unknown properties rejected
 // ---------------------------------------------------------------------------
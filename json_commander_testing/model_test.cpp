@@ -46,6 +46,8 @@ TEST_CASE("ScalarType round-trip", "[model][leaf]") {
     round_trip(ScalarType::File);
     round_trip(ScalarType::Dir);
     round_trip(ScalarType::Path);
+    round_trip(ScalarType::Size);
+    round_trip(ScalarType::Duration);
   }
 
   SECTION("serializes to expected strings") {
@@ -57,6 +59,8 @@ TEST_CASE("ScalarType round-trip", "[model][leaf]") {
     REQUIRE(json(ScalarType::File) == "file");
     REQUIRE(json(ScalarType::Dir) == "dir");
     REQUIRE(json(ScalarType::Path) == "path");
+    REQUIRE(json(ScalarType::Size) == "size");
+    REQUIRE(json(ScalarType::Duration) == "duration");
   }
 }
 
@@ -82,6 +86,18 @@ TEST_CASE("ListType round-trip", "[model][leaf]") {
     json j = {{"list", {{"element", "int"}}}};
     round_trip_json<ListType>(j);
   }
+
+  SECTION("packed") {
+    round_trip(ListType{ScalarType::Float, ";", std::nullopt, true});
+    json j = {{"list", {{"element", "int"}, {"packed", true}}}};
+    round_trip_json<ListType>(j);
+  }
+
+  SECTION("with element cap") {
+    round_trip(ListType{ScalarType::Int, std::nullopt, 100000});
+    json j = {{"list", {{"element", "float"}, {"max_elements", 5}}}};
+    round_trip_json<ListType>(j);
+  }
 }
 
 TEST_CASE("PairType round-trip", "[model][leaf]") {
@@ -439,6 +455,7 @@ TEST_CASE("Positional round-trip", "[model][args]") {
     p.repeated = true;
     p.must_exist = true;
     p.docs = "ARGUMENTS";
+    p.from_stdin = "nul";
     round_trip(p);
   }
 
@@ -462,7 +479,8 @@ TEST_CASE("Positional round-trip", "[model][args]") {
       {"required", true},
       {"repeated", true},
       {"must_exist", true},
-      {"docs", "ARGUMENTS"}};
+      {"docs", "ARGUMENTS"},
+      {"from_stdin", "newline"}};
     round_trip_json<Positional>(j);
   }
 }
@@ -700,6 +718,13 @@ TEST_CASE("ConfigPaths round-trip", "[model][config]") {
     json j = {{"local", ".myapp.toml"}};
     round_trip_json<ConfigPaths>(j);
   }
+
+  SECTION("drop-in directory") {
+    ConfigPaths cp{"/etc/myapp/config.json", std::nullopt, std::nullopt};
+    cp.drop_in = "/etc/myapp/conf.d";
+    round_trip(cp);
+    round_trip_json<ConfigPaths>(json{{"drop_in", "/etc/myapp/conf.d"}});
+  }
 }
 
 TEST_CASE("Config round-trip", "[model][config]") {
@@ -722,6 +747,14 @@ TEST_CASE("Config round-trip", "[model][config]") {
     round_trip_json<Config>(j);
   }
 
+  SECTION("with cache") {
+    Config c;
+    c.format = "json";
+    c.cache = true;
+    round_trip(c);
+    round_trip_json<Config>(json{{"format", "json"}, {"cache", false}});
+  }
+
   SECTION("from full JSON") {
     json j = {
       {"format", "json"},
@@ -857,6 +890,42 @@ TEST_CASE("Root round-trip", "[model][command]") {
       {"config", {{"format", "json"}}}};
     round_trip_json<Root>(j);
   }
+
+  SECTION("root with parsing settings") {
+    Root r;
+    r.name = "myapp";
+    r.doc = {"A test application"};
+    r.parsing = Parsing{true};
+    round_trip(r);
+  }
+
+  SECTION("from JSON with parsing settings") {
+    json j = {
+      {"name", "myapp"},
+      {"doc", {"A test application"}},
+      {"parsing", {{"abbreviations", true}}}};
+    round_trip_json<Root>(j);
+  }
+
+  SECTION("from JSON with memoize") {
+    json j = {
+      {"name", "myapp"},
+      {"doc", {"A test application"}},
+      {"parsing", {{"memoize", true}}}};
+    round_trip_json<Root>(j);
+  }
+
+  SECTION("from JSON with response files") {
+    json j = {
+      {"name", "myapp"},
+      {"doc", {"A test application"}},
+      {"parsing",
+       {{"response_files", {{"delimiter", "nul"}, {"max_depth", 2}}}}}};
+    round_trip_json<Root>(j);
+    auto r = j.get<Root>();
+    REQUIRE(r.parsing->response_files->delimiter == "nul");
+    REQUIRE(r.parsing->response_files->max_depth == 2);
+  }
 }
 
 // ===========================================================================
@@ -1,6 +1,17 @@
 #include <catch2/catch_test_macros.hpp>
 #include <json_commander/parse.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+
 using namespace json_commander;
 using json = nlohmann::json;
 
@@ -1315,3 +1326,1129 @@ TEST_CASE(
   REQUIRE(std::holds_alternative<parse::CompletionRequest>(result));
   REQUIRE(std::get<parse::CompletionRequest>(result).shell == "bash");
 }
+
+// ===========================================================================
+// Phase 15: Zero-copy argv entry point
+// ===========================================================================
+
+TEST_CASE(
+  "split_long_option: parts are views into the token", "[parse][phase15]") {
+  std::string token = "--output=file.txt";
+  auto split = parse::detail::split_long_option(token);
+  REQUIRE(split.name == "output");
+  REQUIRE(split.value == "file.txt");
+  // Views point into the original token rather than into copies
+  REQUIRE(split.name.data() == token.data() + 2);
+  REQUIRE(split.value->data() == token.data() + 9);
+}
+
+TEST_CASE(
+  "NameIndex: lookup_short resolves single-character names",
+  "[parse][phase15]") {
+  std::vector<arg::ArgSpec> args = {
+    make_flag({"verbose", "v"}),
+    make_option({"output", "o"}),
+  };
+  auto index = parse::detail::build_index(args);
+  REQUIRE(index.lookup_short('v')->arg_index == 0);
+  REQUIRE(index.lookup_short('o')->kind == parse::detail::MatchKind::Option);
+  REQUIRE_FALSE(index.lookup_short('x').has_value());
+}
+
+TEST_CASE(
+  "parse: argc/argv overload skips the program name", "[parse][phase15]") {
+  auto root = make_root("tool");
+  auto files = make_positional("files");
+  files.repeated = true;
+  root.args = {
+    arg::ArgSpec{make_flag({"verbose", "v"})},
+    arg::ArgSpec{make_option({"output", "o"})},
+    arg::ArgSpec{files},
+  };
+  const char* argv[] = {"tool", "-v", "--output=out.txt", "a", "b", nullptr};
+  auto result = parse::parse(root, 5, argv, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["verbose"] == true);
+  REQUIRE(ok.config["output"] == "out.txt");
+  REQUIRE(ok.config["files"] == json::array({"a", "b"}));
+}
+
+TEST_CASE("parse: argc/argv overload with only argv[0]", "[parse][phase15]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_flag({"verbose"})}};
+  const char* argv[] = {"tool", nullptr};
+  auto result = parse::parse(root, 1, argv, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["verbose"] == false);
+}
+
+TEST_CASE(
+  "parse: argc/argv overload matches vector overload", "[parse][phase15]") {
+  auto sub = make_command("build");
+  sub.args = {arg::ArgSpec{make_option({"target", "t"})}};
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_flag({"verbose", "v"})}};
+  root.commands = {sub};
+
+  const char* argv[] = {"tool", "-v", "build", "-t", "release"};
+  std::vector<std::string> args = {"-v", "build", "-t", "release"};
+  auto from_argv = parse::parse(root, 5, argv, parse::no_env());
+  auto from_vector = parse::parse(root, args, parse::no_env());
+  REQUIRE(
+    std::get<parse::ParseOk>(from_argv).config ==
+    std::get<parse::ParseOk>(from_vector).config);
+}
+
+// ===========================================================================
+// Phase 16: Slots and key handles
+// ===========================================================================
+
+TEST_CASE("parse: slots record the source of each value", "[parse][phase16]") {
+  auto root = make_root("tool");
+  auto output = make_option({"output"});
+  output.default_value = json("stdout");
+  auto level = make_option({"level"});
+  level.env = arg::EnvSpec{"LEVEL", std::nullopt};
+  root.args = {
+    arg::ArgSpec{make_flag({"verbose"})},
+    arg::ArgSpec{output},
+    arg::ArgSpec{level},
+    arg::ArgSpec{make_option({"name"})},
+  };
+  auto result =
+    parse::parse(root, {"--verbose"}, make_env({{"LEVEL", "debug"}}));
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.levels.size() == 1);
+  const auto& values = ok.levels[0];
+  REQUIRE(values.find("verbose")->source == parse::Source::Cli);
+  REQUIRE(values.find("verbose")->count == 1);
+  REQUIRE(values.find("output")->source == parse::Source::Default);
+  REQUIRE(values.find("level")->source == parse::Source::Env);
+  REQUIRE(values.find("level")->value == "debug");
+  REQUIRE(values.find("name")->source == parse::Source::Unset);
+  REQUIRE(values.find("missing") == nullptr);
+  REQUIRE_FALSE(ok.config.contains("name"));
+}
+
+TEST_CASE("parse: key handles index slots directly", "[parse][phase16]") {
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_flag({"verbose", "v"})},
+    arg::ArgSpec{make_positional("file")},
+  };
+  root.table =
+    std::make_shared<const cmd::LevelTable>(cmd::make_table(root.args));
+  auto key = root.table->key("file");
+  REQUIRE(key.has_value());
+
+  auto result = parse::parse(root, {"-vv", "a.txt"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.levels[0][*key].value == "a.txt");
+  REQUIRE(ok.levels[0].find("verbose")->count == 2);
+}
+
+TEST_CASE("parse: arguments sharing a dest share a slot", "[parse][phase16]") {
+  auto root = make_root("tool");
+  auto quiet = make_flag({"quiet"});
+  quiet.dest = "mode";
+  auto mode = make_option({"mode"});
+  root.args = {arg::ArgSpec{quiet}, arg::ArgSpec{mode}};
+  auto table = cmd::make_table(root.args);
+  REQUIRE(table.keys == std::vector<std::string>{"mode"});
+  REQUIRE(table.key_of == std::vector<cmd::KeyHandle>{0, 0});
+
+  auto result = parse::parse(root, {"--mode", "loud"}, parse::no_env());
+  REQUIRE(std::get<parse::ParseOk>(result).config["mode"] == "loud");
+}
+
+TEST_CASE("parse: one slot level per command on the path", "[parse][phase16]") {
+  auto sub = make_command("build");
+  sub.args = {arg::ArgSpec{make_option({"target"})}};
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_flag({"verbose"})}};
+  root.commands = {sub};
+
+  auto result =
+    parse::parse(root, {"build", "--target", "x"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.levels.size() == 2);
+  REQUIRE(ok.levels[0].find("verbose")->source == parse::Source::Default);
+  REQUIRE(ok.levels[1].find("target")->value == "x");
+  REQUIRE(ok.config["build"]["target"] == "x");
+}
+
+TEST_CASE(
+  "parse: level tables are taken as built, whatever the option count",
+  "[parse][phase16]") {
+  auto sub = make_command("build");
+  sub.args = {arg::ArgSpec{make_option({"target"})}};
+  auto root = make_root("tool");
+  for (int i = 0; i < 2000; ++i) {
+    root.args.push_back(make_option({"opt-" + std::to_string(i)}));
+  }
+  root.commands = {sub};
+  root.table =
+    std::make_shared<const cmd::LevelTable>(cmd::make_table(root.args));
+  root.commands[0].table = std::make_shared<const cmd::LevelTable>(
+    cmd::make_table(root.commands[0].args));
+
+  // Selecting a table must not read the args: a check that walked (or
+  // hashed) them would cost time in proportion to the option count on
+  // every parse. Renaming an option behind the table's back shows it.
+  std::get<arg::OptionSpec>(root.args[1999]).names = {"renamed"};
+  auto result = parse::parse(
+    root, {"--opt-1999", "x", "build", "--target", "y"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.levels[0].table == root.table);
+  REQUIRE(ok.levels[1].table == root.commands[0].table);
+  REQUIRE(ok.config["build"]["target"] == "y");
+}
+
+// ===========================================================================
+// Phase 17: Abbreviations
+// ===========================================================================
+
+namespace {
+
+  cmd::RootSpec
+  make_abbreviating_root() {
+    auto root = make_root("tool");
+    root.parsing = model::Parsing{true};
+    return root;
+  }
+
+} // namespace
+
+TEST_CASE("abbreviations: off by default", "[parse][phase17]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_flag({"verbose"})}};
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"--verb"}, parse::no_env()),
+    "unknown option: --verb");
+}
+
+TEST_CASE("abbreviations: unique prefix of a long option", "[parse][phase17]") {
+  auto root = make_abbreviating_root();
+  root.args = {
+    arg::ArgSpec{make_flag({"verbose"})},
+    arg::ArgSpec{make_option({"output"})},
+  };
+  auto result =
+    parse::parse(root, {"--verb", "--out=a.txt"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["verbose"] == true);
+  REQUIRE(ok.config["output"] == "a.txt");
+}
+
+TEST_CASE("abbreviations: exact match beats prefix", "[parse][phase17]") {
+  auto root = make_abbreviating_root();
+  root.args = {
+    arg::ArgSpec{make_flag({"all"})},
+    arg::ArgSpec{make_flag({"all-files"})},
+  };
+  auto result = parse::parse(root, {"--all"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["all"] == true);
+  REQUIRE(ok.config["all-files"] == false);
+}
+
+TEST_CASE("abbreviations: aliases of one option agree", "[parse][phase17]") {
+  auto root = make_abbreviating_root();
+  root.args = {arg::ArgSpec{make_flag({"color", "colour"})}};
+  auto result = parse::parse(root, {"--col"}, parse::no_env());
+  REQUIRE(std::get<parse::ParseOk>(result).config["color"] == true);
+}
+
+TEST_CASE("abbreviations: ambiguous prefix throws", "[parse][phase17]") {
+  auto root = make_abbreviating_root();
+  root.args = {
+    arg::ArgSpec{make_flag({"verbose"})},
+    arg::ArgSpec{make_flag({"verify"})},
+  };
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"--ver"}, parse::no_env()),
+    "ambiguous option: --ver (could be --version, --verbose, --verify)");
+}
+
+TEST_CASE("abbreviations: built-ins match exactly", "[parse][phase17]") {
+  auto root = make_abbreviating_root();
+  root.args = {arg::ArgSpec{make_flag({"verbose"})}};
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"--he"}, parse::no_env()), "unknown option: --he");
+}
+
+TEST_CASE("abbreviations: unique prefix of a subcommand", "[parse][phase17]") {
+  auto root = make_abbreviating_root();
+  root.commands = {make_command("parse"), make_command("config-schema")};
+  auto result = parse::parse(root, {"conf"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.command_path == std::vector<std::string>{"config-schema"});
+  REQUIRE(ok.config["command"] == "config-schema");
+}
+
+TEST_CASE("abbreviations: ambiguous subcommand throws", "[parse][phase17]") {
+  auto root = make_abbreviating_root();
+  root.commands = {make_command("commit"), make_command("config")};
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"co"}, parse::no_env()),
+    "ambiguous command: co (could be commit, config)");
+}
+
+// ===========================================================================
+// Phase 18: Suggestions for unknown names
+// ===========================================================================
+
+TEST_CASE("suggestions: misspelled long option", "[parse][phase18]") {
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_flag({"verbose"})},
+    arg::ArgSpec{make_option({"output"})},
+  };
+  try {
+    parse::parse(root, {"--verbsoe"}, parse::no_env());
+    FAIL("expected parse::Error");
+  } catch (const parse::Error& e) {
+    REQUIRE(e.suggestions() == std::vector<std::string>{"--verbose"});
+    REQUIRE(
+      std::string(e.what()) ==
+      "unknown option: --verbsoe (did you mean --verbose?)");
+  }
+}
+
+TEST_CASE("suggestions: built-in options are candidates", "[parse][phase18]") {
+  auto root = make_root("tool");
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"--halp"}, parse::no_env()),
+    "unknown option: --halp (did you mean --help?)");
+}
+
+TEST_CASE("suggestions: several close names", "[parse][phase18]") {
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_flag({"debug"})},
+    arg::ArgSpec{make_flag({"debut"})},
+  };
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"--debux"}, parse::no_env()),
+    "unknown option: --debux (did you mean --debug or --debut?)");
+}
+
+TEST_CASE("suggestions: nothing close enough", "[parse][phase18]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_flag({"verbose"})}};
+  try {
+    parse::parse(root, {"--quiet"}, parse::no_env());
+    FAIL("expected parse::Error");
+  } catch (const parse::Error& e) {
+    REQUIRE(e.suggestions().empty());
+    REQUIRE(std::string(e.what()) == "unknown option: --quiet");
+  }
+}
+
+TEST_CASE("suggestions: misspelled subcommand", "[parse][phase18]") {
+  auto root = make_root("tool");
+  root.commands = {make_command("commit"), make_command("status")};
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"stauts"}, parse::no_env()),
+    "unknown command: stauts (did you mean status?)");
+}
+
+TEST_CASE(
+  "suggestions: stray word after -- stays positional", "[parse][phase18]") {
+  auto root = make_root("tool");
+  root.commands = {make_command("status")};
+  REQUIRE_THROWS_WITH(
+    parse::parse(root, {"--", "stauts"}, parse::no_env()),
+    "unexpected positional argument: stauts");
+}
+
+// ===========================================================================
+// Phase 19: Non-throwing parse
+// ===========================================================================
+
+TEST_CASE("try_parse: success holds the parse result", "[parse][phase19]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_option({"count"}, model::ScalarType::Int)}};
+  auto result = parse::try_parse(root, {"--count", "3"}, parse::no_env());
+  REQUIRE(result.has_value());
+  auto& ok = std::get<parse::ParseOk>(result.value());
+  REQUIRE(ok.config["count"] == 3);
+}
+
+TEST_CASE("try_parse: stray and unknown tokens", "[parse][phase19]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_flag({"verbose"})}};
+  auto result = parse::try_parse(root, {"x", "--verbsoe"}, parse::no_env());
+  REQUIRE_FALSE(result);
+  const auto& error = result.error();
+  REQUIRE(error.kind == parse::ErrorKind::UnexpectedArgument);
+  REQUIRE(error.token == 0u);
+  REQUIRE(error.arg == "x");
+
+  auto typo =
+    parse::try_parse(root, {"--verbose", "--verbsoe"}, parse::no_env());
+  REQUIRE(typo.error().kind == parse::ErrorKind::UnknownOption);
+  REQUIRE(typo.error().token == 1u);
+  REQUIRE(typo.error().arg == "--verbsoe");
+  REQUIRE(typo.error().suggestions == std::vector<std::string>{"--verbose"});
+}
+
+TEST_CASE(
+  "try_parse: conversion failure names the value token", "[parse][phase19]") {
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_option({"count", "c"}, model::ScalarType::Int)}};
+  auto result = parse::try_parse(root, {"-c", "many"}, parse::no_env());
+  REQUIRE(result.error().kind == parse::ErrorKind::InvalidValue);
+  REQUIRE(result.error().token == 1u);
+  REQUIRE(result.error().arg == "-c");
+  REQUIRE(result.error().message == "option -c: expected integer, got 'many'");
+}
+
+TEST_CASE("try_parse: missing value points at the option", "[parse][phase19]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_option({"output"})}};
+  auto result = parse::try_parse(root, {"--output"}, parse::no_env());
+  REQUIRE(result.error().kind == parse::ErrorKind::MissingValue);
+  REQUIRE(result.error().token == 0u);
+}
+
+TEST_CASE("try_parse: errors after the command line", "[parse][phase19]") {
+  auto root = make_root("tool");
+  auto opt = make_option({"level"}, model::ScalarType::Int);
+  opt.env = arg::EnvSpec{"LEVEL", std::nullopt};
+  auto req = make_option({"name"});
+  req.validator = validate::required();
+  root.args = {arg::ArgSpec{opt}, arg::ArgSpec{req}};
+
+  auto env = parse::try_parse(root, {}, make_env({{"LEVEL", "high"}}));
+  REQUIRE(env.error().kind == parse::ErrorKind::InvalidEnv);
+  REQUIRE_FALSE(env.error().token.has_value());
+  REQUIRE(env.error().arg == "LEVEL");
+
+  auto missing = parse::try_parse(root, {}, parse::no_env());
+  REQUIRE(missing.error().kind == parse::ErrorKind::ValidationFailed);
+  REQUIRE(missing.error().arg == "name");
+  REQUIRE(missing.error().message == "name is required");
+}
+
+TEST_CASE("try_parse: custom converters may still throw", "[parse][phase19]") {
+  auto root = make_root("tool");
+  auto opt = make_option({"mode"});
+  opt.converter = conv::Converter{
+    [](const std::string& s) -> json {
+      if (s != "fast") { throw conv::Error("not fast"); }
+      return s;
+    },
+    [](const json& j) { return j.get<std::string>(); },
+    "MODE"};
+  root.args = {arg::ArgSpec{opt}};
+  auto result = parse::try_parse(root, {"--mode=slow"}, parse::no_env());
+  REQUIRE(result.error().kind == parse::ErrorKind::InvalidValue);
+  REQUIRE(result.error().message == "option --mode: not fast");
+}
+
+TEST_CASE(
+  "parse: thrown error carries the structured info", "[parse][phase19]") {
+  auto root = make_root("tool");
+  root.commands = {make_command("status")};
+  try {
+    parse::parse(root, {"stauts"}, parse::no_env());
+    FAIL("expected parse::Error");
+  } catch (const parse::Error& e) {
+    REQUIRE(e.info().has_value());
+    REQUIRE(e.info()->kind == parse::ErrorKind::UnknownCommand);
+    REQUIRE(e.info()->token == 0u);
+    REQUIRE(std::string(e.what()) == e.info()->message);
+  }
+}
+
+TEST_CASE(
+  "try_parse: argc/argv tokens skip the program name", "[parse][phase19]") {
+  auto root = make_root("tool");
+  const char* argv[] = {"tool", "--nope"};
+  auto result = parse::try_parse(root, 2, argv, parse::no_env());
+  REQUIRE(result.error().token == 0u);
+}
+
+// ===========================================================================
+// Phase 20: Collecting all errors
+// ===========================================================================
+
+namespace {
+
+  const std::vector<parse::ErrorInfo>&
+  errors_of(const parse::ParseResult& result) {
+    return std::get<parse::ParseErrors>(result).errors;
+  }
+
+} // namespace
+
+TEST_CASE("parse_all: reports every command-line error", "[parse][phase20]") {
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_flag({"verbose"})},
+    arg::ArgSpec{make_option({"count", "c"}, model::ScalarType::Int)},
+    arg::ArgSpec{make_positional("input")},
+  };
+  auto result = parse::parse_all(
+    root,
+    {"--verbsoe", "-c", "x", "-q", "in.txt", "extra"},
+    parse::no_env());
+  const auto& errors = errors_of(result);
+  REQUIRE(errors.size() == 4);
+  REQUIRE(errors[0].kind == parse::ErrorKind::UnknownOption);
+  REQUIRE(errors[0].token == 0u);
+  REQUIRE(errors[1].kind == parse::ErrorKind::InvalidValue);
+  REQUIRE(errors[1].token == 2u);
+  REQUIRE(errors[2].kind == parse::ErrorKind::UnknownOption);
+  REQUIRE(errors[2].arg == "-q");
+  REQUIRE(errors[3].kind == parse::ErrorKind::UnexpectedArgument);
+  REQUIRE(errors[3].arg == "extra");
+}
+
+TEST_CASE("parse_all: validation errors follow", "[parse][phase20]") {
+  auto root = make_root("tool");
+  auto name = make_option({"name"});
+  name.validator = validate::required();
+  auto dir = make_option({"dir"}, model::ScalarType::Dir);
+  dir.validator = validate::must_exist_dir();
+  root.args = {arg::ArgSpec{name}, arg::ArgSpec{dir}};
+  auto result = parse::parse_all(
+    root, {"--bogus", "--dir", "/nonexistent/dir"}, parse::no_env());
+  const auto& errors = errors_of(result);
+  REQUIRE(errors.size() == 3);
+  REQUIRE(errors[0].kind == parse::ErrorKind::UnknownOption);
+  REQUIRE(errors[1].message == "name is required");
+  REQUIRE(errors[2].message == "dir: /nonexistent/dir is not a directory");
+}
+
+TEST_CASE(
+  "parse_all: rejected value is not reported twice", "[parse][phase20]") {
+  auto root = make_root("tool");
+  auto count = make_option({"count"}, model::ScalarType::Int);
+  count.validator = validate::required();
+  count.default_value = json(1);
+  root.args = {arg::ArgSpec{count}};
+  auto result = parse::parse_all(root, {"--count", "many"}, parse::no_env());
+  const auto& errors = errors_of(result);
+  REQUIRE(errors.size() == 1);
+  REQUIRE(errors[0].kind == parse::ErrorKind::InvalidValue);
+}
+
+TEST_CASE("parse_all: positionals after a bad one", "[parse][phase20]") {
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_positional("count", model::ScalarType::Int)},
+    arg::ArgSpec{make_positional("name")},
+  };
+  auto result = parse::parse_all(root, {"x", "bob"}, parse::no_env());
+  const auto& errors = errors_of(result);
+  REQUIRE(errors.size() == 1);
+  REQUIRE(errors[0].arg == "count");
+}
+
+TEST_CASE("parse_all: errors in subcommands", "[parse][phase20]") {
+  auto root = make_root("tool");
+  auto build = make_command("build");
+  build.args = {arg::ArgSpec{make_flag({"release"})}};
+  root.commands = {build};
+  auto result =
+    parse::parse_all(root, {"build", "--relase", "--x"}, parse::no_env());
+  const auto& errors = errors_of(result);
+  REQUIRE(errors.size() == 2);
+  REQUIRE(errors[0].suggestions == std::vector<std::string>{"--release"});
+}
+
+TEST_CASE("parse_all: clean input parses normally", "[parse][phase20]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_flag({"verbose"})}};
+  auto result = parse::parse_all(root, {"--verbose"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["verbose"] == true);
+  REQUIRE(std::holds_alternative<parse::HelpRequest>(
+    parse::parse_all(root, {"--help"}, parse::no_env())));
+}
+
+TEST_CASE("parse_all: errors before --help still win", "[parse][phase20]") {
+  auto root = make_root("tool");
+  auto result = parse::parse_all(root, {"--nope", "--help"}, parse::no_env());
+  REQUIRE(errors_of(result).size() == 1);
+}
+
+// ===========================================================================
+// Phase 21: Event-driven parsing
+// ===========================================================================
+
+TEST_CASE("stream: events arrive in command-line order", "[parse][phase21]") {
+  auto root = make_root("tool");
+  auto build = make_command("build");
+  build.args = {
+    arg::ArgSpec{make_option({"jobs", "j"}, model::ScalarType::Int)}};
+  root.args = {arg::ArgSpec{make_flag({"verbose", "v"})}};
+  root.commands = {build};
+
+  std::vector<std::string> seen;
+  auto result = parse::stream(
+    root,
+    {"-v", "build", "--jobs=4"},
+    [&](const parse::Event& event) {
+      std::visit(
+        [&](const auto& e) {
+          using T = std::decay_t<decltype(e)>;
+          if constexpr (std::is_same_v<T, parse::CommandEvent>) {
+            seen.push_back("command " + std::string(e.name));
+          } else if constexpr (std::is_same_v<T, parse::PositionalEvent>) {
+            seen.push_back("positional " + std::string(e.dest));
+          } else {
+            seen.push_back(
+              std::string(e.name) + " " + std::string(e.dest) + "=" +
+              e.value.dump() + " @" + std::to_string(e.token));
+          }
+        },
+        event);
+      return false;
+    },
+    parse::no_env());
+  REQUIRE(
+    seen == std::vector<std::string>{
+              "-v verbose=true @0", "command build", "--jobs jobs=4 @2"});
+  // Values the handler leaves are stored as usual.
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["verbose"] == true);
+  REQUIRE(ok.config["build"]["jobs"] == 4);
+}
+
+TEST_CASE("stream: taken values stay out of the config", "[parse][phase21]") {
+  auto root = make_root("tool");
+  auto files = make_positional("files");
+  files.repeated = true;
+  files.validator = validate::required();
+  auto level = make_option({"level"}, model::ScalarType::Int);
+  level.default_value = json(3);
+  root.args = {arg::ArgSpec{files}, arg::ArgSpec{level}};
+
+  std::vector<std::string> paths;
+  auto result = parse::stream(
+    root,
+    {"a", "b", "c"},
+    [&](const parse::Event& event) {
+      auto* pos = std::get_if<parse::PositionalEvent>(&event);
+      if (pos == nullptr) { return false; }
+      paths.push_back(pos->value.get<std::string>());
+      return true;
+    },
+    parse::no_env());
+  REQUIRE(paths == std::vector<std::string>{"a", "b", "c"});
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE_FALSE(ok.config.contains("files"));
+  REQUIRE(ok.config["level"] == 3);
+  const auto* slot = ok.levels[0].find("files");
+  REQUIRE(slot->count == 3);
+  REQUIRE(slot->streamed);
+}
+
+TEST_CASE("stream: repeated flags report their count", "[parse][phase21]") {
+  auto root = make_root("tool");
+  auto verbose = make_flag({"v"});
+  verbose.repeated = true;
+  root.args = {arg::ArgSpec{verbose}};
+  std::vector<json> values;
+  parse::stream(
+    root,
+    {"-vv", "-v"},
+    [&](const parse::Event& event) {
+      values.push_back(std::get<parse::FlagEvent>(event).value);
+      return false;
+    },
+    parse::no_env());
+  REQUIRE(values == std::vector<json>{1, 2, 3});
+}
+
+TEST_CASE("try_stream: conversion errors are reported", "[parse][phase21]") {
+  auto root = make_root("tool");
+  root.args = {arg::ArgSpec{make_option({"count"}, model::ScalarType::Int)}};
+  int events = 0;
+  auto result = parse::try_stream(
+    root,
+    {"--count", "x"},
+    [&](const parse::Event&) {
+      ++events;
+      return true;
+    },
+    parse::no_env());
+  REQUIRE_FALSE(result);
+  REQUIRE(result.error().kind == parse::ErrorKind::InvalidValue);
+  REQUIRE(events == 0);
+}
+
+// ===========================================================================
+// Phase 22: Response files
+// ===========================================================================
+
+namespace {
+
+  // Writes `content` to a file under /tmp, removed again on destruction.
+  struct ResponseFile {
+    std::string path;
+
+    ResponseFile(const std::string& name, std::string_view content)
+        : path("/tmp/commander_parse_test_" + name) {
+      std::ofstream out(path, std::ios::binary);
+      out << content;
+    }
+
+    ~ResponseFile() { std::remove(path.c_str()); }
+  };
+
+  cmd::RootSpec
+  make_response_root(model::ResponseFiles responses = {}) {
+    auto root = make_root("tool");
+    auto files = make_positional("files");
+    files.repeated = true;
+    root.args = {
+      arg::ArgSpec{make_flag({"verbose", "v"})},
+      arg::ArgSpec{make_option({"output", "o"})},
+      arg::ArgSpec{files},
+    };
+    root.parsing = model::Parsing{};
+    root.parsing->response_files = responses;
+    return root;
+  }
+
+} // namespace
+
+TEST_CASE("response files: off by default", "[parse][phase22]") {
+  ResponseFile list("off", "a\nb\n");
+  auto root = make_response_root();
+  root.parsing.reset();
+  auto result = parse::parse(root, {"@" + list.path}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["files"] == json::array({"@" + list.path}));
+}
+
+TEST_CASE("response files: newline-delimited", "[parse][phase22]") {
+  ResponseFile list("lines", "-v\r\n--output\nout.txt\n\na b\nc");
+  auto root = make_response_root();
+  auto result =
+    parse::parse(root, {"x", "@" + list.path, "y"}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["verbose"] == true);
+  REQUIRE(ok.config["output"] == "out.txt");
+  REQUIRE(ok.config["files"] == json::array({"x", "a b", "c", "y"}));
+}
+
+TEST_CASE("response files: NUL-delimited", "[parse][phase22]") {
+  using namespace std::string_view_literals;
+  ResponseFile list("nul", "a\nb\0c\0"sv);
+  auto root = make_response_root({"nul", std::nullopt});
+  auto result = parse::parse(root, {"@" + list.path}, parse::no_env());
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["files"] == json::array({"a\nb", "c"}));
+}
+
+TEST_CASE("response files: nesting is bounded", "[parse][phase22]") {
+  ResponseFile inner("inner", "deep\n");
+  ResponseFile outer("outer", "shallow\n@" + inner.path + "\n");
+
+  auto nested = make_response_root();
+  auto ok = std::get<parse::ParseOk>(
+    parse::parse(nested, {"@" + outer.path}, parse::no_env()));
+  REQUIRE(ok.config["files"] == json::array({"shallow", "deep"}));
+
+  auto flat = make_response_root({std::nullopt, 0});
+  auto result = parse::try_parse(flat, {"-v", "@" + outer.path});
+  REQUIRE_FALSE(result);
+  REQUIRE(result.error().kind == parse::ErrorKind::BadResponseFile);
+  REQUIRE(result.error().token == 1u);
+  REQUIRE(result.error().arg == "@" + inner.path);
+}
+
+TEST_CASE("response files: self-reference stops", "[parse][phase22]") {
+  std::string path = "/tmp/commander_parse_test_self";
+  ResponseFile self("self", "@" + path + "\n");
+  auto result = parse::try_parse(make_response_root(), {"@" + path});
+  REQUIRE_FALSE(result);
+  REQUIRE(result.error().message.ends_with("nested too deeply"));
+}
+
+TEST_CASE(
+  "response files: errors point at the @ argument", "[parse][phase22]") {
+  ResponseFile list("bad", "--bogus\n");
+  auto root = make_response_root();
+  auto result = parse::try_parse(root, {"a", "@" + list.path});
+  REQUIRE_FALSE(result);
+  REQUIRE(result.error().kind == parse::ErrorKind::UnknownOption);
+  REQUIRE(result.error().token == 1u);
+
+  auto missing = parse::try_parse(root, {"@/nonexistent/commander_list"});
+  REQUIRE_FALSE(missing);
+  REQUIRE(missing.error().kind == parse::ErrorKind::BadResponseFile);
+  REQUIRE(missing.error().token == 0u);
+}
+
+TEST_CASE("response files: not expanded after --", "[parse][phase22]") {
+  ResponseFile list("dashdash", "a\n--\n@x\n");
+  auto root = make_response_root();
+  auto literal =
+    parse::parse(root, {"--", "@" + list.path}, parse::no_env());
+  REQUIRE(
+    std::get<parse::ParseOk>(literal).config["files"] ==
+    json::array({"@" + list.path}));
+  auto inside = parse::parse(root, {"@" + list.path}, parse::no_env());
+  REQUIRE(
+    std::get<parse::ParseOk>(inside).config["files"] ==
+    json::array({"a", "@x"}));
+}
+
+// ===========================================================================
+// Phase 23: Environment snapshots
+// ===========================================================================
+
+namespace {
+
+  cmd::RootSpec
+  make_snapshot_root() {
+    auto level = make_option({"level"});
+    level.env = arg::EnvSpec{"JCMD_TEST_LEVEL", std::nullopt};
+    auto target = make_option({"target"});
+    target.env = arg::EnvSpec{"JCMD_TEST_TARGET", std::nullopt};
+    auto sub = make_command("build");
+    sub.args = {arg::ArgSpec{target}};
+    auto root = make_root("tool");
+    root.args = {arg::ArgSpec{level}};
+    root.commands = {sub};
+    return root;
+  }
+
+} // namespace
+
+TEST_CASE(
+  "env snapshot: copies the bound variables only", "[parse][phase23]") {
+  ::setenv("JCMD_TEST_LEVEL", "high", 1);
+  ::setenv("JCMD_TEST_TARGET", "release", 1);
+  ::setenv("JCMD_TEST_UNBOUND", "x", 1);
+  parse::EnvSnapshot snapshot(make_snapshot_root());
+  REQUIRE(snapshot.get("JCMD_TEST_LEVEL") == "high");
+  REQUIRE(snapshot.get("JCMD_TEST_TARGET") == "release");
+  REQUIRE_FALSE(snapshot.get("JCMD_TEST_UNBOUND").has_value());
+  ::unsetenv("JCMD_TEST_LEVEL");
+  ::unsetenv("JCMD_TEST_TARGET");
+  ::unsetenv("JCMD_TEST_UNBOUND");
+}
+
+TEST_CASE(
+  "env snapshot: later changes are not seen", "[parse][phase23]") {
+  ::setenv("JCMD_TEST_LEVEL", "low", 1);
+  auto root = make_snapshot_root();
+  auto env = parse::env_snapshot(root);
+  ::setenv("JCMD_TEST_LEVEL", "high", 1);
+  ::setenv("JCMD_TEST_TARGET", "release", 1);
+
+  auto first = parse::parse(root, {"build"}, env);
+  auto& ok = std::get<parse::ParseOk>(first);
+  REQUIRE(ok.config["level"] == "low");
+  REQUIRE_FALSE(ok.config["build"].contains("target"));
+
+  auto fresh = parse::parse(root, {"build"}, parse::env_snapshot(root));
+  auto& now = std::get<parse::ParseOk>(fresh);
+  REQUIRE(now.config["level"] == "high");
+  REQUIRE(now.config["build"]["target"] == "release");
+  ::unsetenv("JCMD_TEST_LEVEL");
+  ::unsetenv("JCMD_TEST_TARGET");
+}
+
+TEST_CASE(
+  "env snapshot: matches the getenv lookup", "[parse][phase23]") {
+  ::setenv("JCMD_TEST_LEVEL", "", 1);
+  auto root = make_snapshot_root();
+  auto expected = parse::parse(root, {"build"});
+  auto actual = parse::parse(root, {"build"}, parse::env_snapshot(root));
+  REQUIRE(
+    std::get<parse::ParseOk>(actual).config ==
+    std::get<parse::ParseOk>(expected).config);
+  REQUIRE(std::get<parse::ParseOk>(actual).config["level"] == "");
+  ::unsetenv("JCMD_TEST_LEVEL");
+}
+
+// ===========================================================================
+// Phase 24: Config file values
+// ===========================================================================
+
+namespace {
+
+  cmd::RootSpec
+  make_file_root() {
+    auto level = make_option({"level"});
+    level.env = arg::EnvSpec{"JCMD_TEST_LEVEL", std::nullopt};
+    level.default_value = "low";
+    auto output = make_option({"output"});
+    output.default_value = "out.txt";
+    auto port = make_option({"port"}, model::ScalarType::Int);
+    port.validator = validate::required();
+    auto sub = make_command("serve");
+    sub.args = {arg::ArgSpec{port}};
+    auto root = make_root("tool");
+    root.args = {
+      arg::ArgSpec{make_flag({"verbose"})},
+      arg::ArgSpec{level},
+      arg::ArgSpec{output}};
+    root.commands = {sub};
+    return root;
+  }
+
+} // namespace
+
+TEST_CASE(
+  "config files: fill in what nothing else set", "[parse][phase24]") {
+  auto root = make_file_root();
+  json files = {{"verbose", true}, {"output", "file.txt"}};
+  auto result = parse::parse(root, {}, parse::no_env(), &files);
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["verbose"] == true);
+  REQUIRE(ok.config["output"] == "file.txt");
+  REQUIRE(ok.config["level"] == "low");
+  REQUIRE(ok.levels[0].find("output")->source == parse::Source::File);
+  REQUIRE(ok.levels[0].find("level")->source == parse::Source::Default);
+}
+
+TEST_CASE(
+  "config files: rank below the command line and env", "[parse][phase24]") {
+  auto root = make_file_root();
+  json files = {{"level", "mid"}, {"output", "file.txt"}};
+  auto env = [](std::string_view var) -> std::optional<std::string> {
+    if (var == "JCMD_TEST_LEVEL") { return "high"; }
+    return std::nullopt;
+  };
+  auto result = parse::parse(root, {"--output", "cli.txt"}, env, &files);
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(ok.config["output"] == "cli.txt");
+  REQUIRE(ok.config["level"] == "high");
+  REQUIRE(ok.levels[0].find("level")->source == parse::Source::Env);
+}
+
+TEST_CASE(
+  "config files: subcommand values nest by name", "[parse][phase24]") {
+  auto root = make_file_root();
+  json files = {{"serve", {{"port", 8080}}}};
+  auto result = parse::parse(root, {"serve"}, parse::no_env(), &files);
+  REQUIRE(std::get<parse::ParseOk>(result).config["serve"]["port"] == 8080);
+
+  // A file value satisfies required; without one the parse still fails.
+  REQUIRE_THROWS_AS(
+    parse::parse(root, {"serve"}, parse::no_env()), parse::Error);
+  json other = {{"serve", "not an object"}};
+  REQUIRE_THROWS_AS(
+    parse::parse(root, {"serve"}, parse::no_env(), &other), parse::Error);
+}
+
+// ===========================================================================
+// Phase 25: Memory resources
+// ===========================================================================
+
+namespace {
+
+  // Every operator new of the test program, counted by the replacement
+  // below.
+  std::atomic<std::size_t> heap_allocations{0};
+
+  // Counts what goes through it; the memory comes from `upstream`.
+  class CountingResource : public std::pmr::memory_resource {
+  public:
+    explicit CountingResource(std::pmr::memory_resource* upstream)
+        : upstream_(upstream) {}
+
+    std::size_t allocations = 0;
+
+  private:
+    void*
+    do_allocate(std::size_t bytes, std::size_t alignment) override {
+      ++allocations;
+      return upstream_->allocate(bytes, alignment);
+    }
+
+    void
+    do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+      upstream_->deallocate(p, bytes, alignment);
+    }
+
+    bool
+    do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream_;
+  };
+
+} // namespace
+
+void*
+operator new(std::size_t bytes) {
+  ++heap_allocations;
+  if (void* p = std::malloc(bytes == 0 ? 1 : bytes)) { return p; }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+TEST_CASE(
+  "memory: scratch state comes from the given resource", "[parse][phase25]") {
+  auto root = make_file_root();
+  std::vector<std::string> args = {"--verbose", "serve", "--port", "80"};
+  CountingResource counting(std::pmr::new_delete_resource());
+  auto result = parse::parse(root, args, parse::no_env(), nullptr, &counting);
+  auto& ok = std::get<parse::ParseOk>(result);
+  REQUIRE(counting.allocations > 0);
+  REQUIRE(ok.levels.get_allocator().resource() == &counting);
+  REQUIRE(ok.levels[1].slots.get_allocator().resource() == &counting);
+
+  auto plain = parse::parse(root, args, parse::no_env());
+  REQUIRE(ok.config == std::get<parse::ParseOk>(plain).config);
+  REQUIRE(ok.config["serve"]["port"] == 80);
+}
+
+TEST_CASE(
+  "memory: config outlives a monotonic arena", "[parse][phase25]") {
+  auto root = make_file_root();
+  const char* argv[] = {"tool", "--level", "high", "serve", "--port", "1"};
+  json config;
+  {
+    std::array<std::byte, 1024> buffer;
+    std::pmr::monotonic_buffer_resource arena(
+      buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    auto result = parse::try_parse(
+      root, 6, argv, parse::no_env(), nullptr, &arena);
+    REQUIRE(result.has_value());
+    config = std::move(std::get<parse::ParseOk>(result.value()).config);
+  }
+  REQUIRE(config["level"] == "high");
+  REQUIRE(config["serve"]["port"] == 1);
+}
+
+TEST_CASE(
+  "memory: a token costs only the value it becomes", "[parse][phase25]") {
+  auto root = make_file_root();
+  root.table =
+    std::make_shared<const cmd::LevelTable>(cmd::make_table(root.args));
+  root.commands[0].table = std::make_shared<const cmd::LevelTable>(
+    cmd::make_table(root.commands[0].args));
+  auto tree = cmd::shared_index(root);
+  std::array<std::byte, 4096> buffer;
+  std::pmr::monotonic_buffer_resource arena(
+    buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+  parse::detail::Cursor cursor(root, tree, nullptr, &arena);
+  parse::detail::Diagnostics diag;
+  // Too long for the small string buffer: a copy would be on the heap.
+  std::string level(40, 'h');
+  std::string port(30, '0');
+  port += "80";
+
+  auto allocations = [&](std::string_view token) {
+    auto before = heap_allocations.load();
+    bool fed = cursor.feed(token, diag);
+    auto made = heap_allocations.load() - before;
+    return fed ? made : std::size_t(-1);
+  };
+  REQUIRE(allocations("--verbose") == 0);
+  REQUIRE(allocations("--level") == 0);
+  // The JSON string the value becomes, and its buffer.
+  REQUIRE(allocations(level) == 2);
+  // The command path's buffer; the level's slots come from the arena.
+  REQUIRE(allocations("serve") == 1);
+  REQUIRE(allocations("--port") == 0);
+  // Numbers are read from the token in place.
+  REQUIRE(allocations(port) == 0);
+  REQUIRE(diag.errors.empty());
+}
+
+TEST_CASE(
+  "memory: errors are collected with an arena", "[parse][phase25]") {
+  auto root = make_file_root();
+  std::pmr::monotonic_buffer_resource arena;
+  auto result = parse::parse_all(
+    root,
+    {"--bogus", "serve", "--port", "x"},
+    parse::no_env(),
+    nullptr,
+    &arena);
+  REQUIRE(std::get<parse::ParseErrors>(result).errors.size() == 2);
+}
+
+// ===========================================================================
+// Phase 26: Sizes, durations and 64-bit integers
+// ===========================================================================
+
+TEST_CASE(
+  "typed values: sizes and durations become integers", "[parse][phase26]") {
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_option({"offset"}, model::ScalarType::Int)},
+    arg::ArgSpec{make_option({"limit"}, model::ScalarType::Size)},
+    arg::ArgSpec{make_option({"timeout"}, model::ScalarType::Duration)}};
+  auto result = parse::parse(
+    root,
+    {"--offset", "8589934592", "--limit", "1.5G", "--timeout", "1m30s"},
+    parse::no_env());
+  auto& config = std::get<parse::ParseOk>(result).config;
+  REQUIRE(config["offset"] == 8589934592);
+  REQUIRE(config["limit"] == 1610612736u);
+  REQUIRE(config["timeout"] == 90000);
+
+  auto bad = parse::try_parse(root, {"--limit", "lots"}, parse::no_env());
+  REQUIRE(bad.error().kind == parse::ErrorKind::InvalidValue);
+  REQUIRE(bad.error().message == "option --limit: expected size, got 'lots'");
+}
+
+// ===========================================================================
+// Phase 27: Packed lists
+// ===========================================================================
+
+TEST_CASE(
+  "packed lists: every source gives the same binary", "[parse][phase27]") {
+  model::ListType ids{model::ScalarType::Int, std::nullopt};
+  ids.packed = true;
+  model::Option weights{};
+  weights.names = {"weights"};
+  weights.doc = {"doc"};
+  weights.type =
+    model::ListType{model::ScalarType::Float, ";", std::nullopt, true};
+  weights.default_value = json{0.5, 2};
+  auto repeated = make_option({"range"}, ids);
+  repeated.repeated = true;
+  auto root = make_root("tool");
+  root.args = {
+    arg::ArgSpec{make_option({"ids"}, ids)},
+    arg::ArgSpec{arg::make(weights)},
+    arg::ArgSpec{repeated}};
+
+  json files = {{"ids", {4, 5}}, {"range", {{1, 2}, {3}}}};
+  auto result = parse::parse(root, {"--ids", "4,5"}, parse::no_env());
+  auto& cli = std::get<parse::ParseOk>(result).config;
+  REQUIRE(cli["ids"].is_binary());
+  REQUIRE(
+    conv::unpack<std::int64_t>(cli["ids"]) == std::vector<std::int64_t>{4, 5});
+  REQUIRE(
+    conv::unpack<double>(cli["weights"]) == std::vector<double>{0.5, 2});
+
+  auto from_file = parse::parse(root, {}, parse::no_env(), &files);
+  auto& file = std::get<parse::ParseOk>(from_file).config;
+  REQUIRE(file["ids"] == cli["ids"]);
+  REQUIRE(file["range"].size() == 2);
+  REQUIRE(file["range"][1].is_binary());
+  REQUIRE(
+    conv::unpack_all(file) ==
+    json{{"ids", {4, 5}}, {"weights", {0.5, 2.0}}, {"range", {{1, 2}, {3}}}});
+
+  auto twice = parse::parse(
+    root, {"--range", "1,2", "--range", "3"}, parse::no_env());
+  REQUIRE(std::get<parse::ParseOk>(twice).config["range"] == file["range"]);
+}
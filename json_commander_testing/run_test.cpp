@@ -1,6 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include <json_commander/run.hpp>
 
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
 using namespace json_commander;
 using json = nlohmann::json;
 
@@ -98,6 +103,29 @@ TEST_CASE("run: defaults applied", "[run]") {
   REQUIRE(captured["output"] == "out.txt");
 }
 
+TEST_CASE("run: packed lists pass config validation", "[run]") {
+  model::ListType ids{};
+  ids.element = model::ScalarType::Int;
+  ids.packed = true;
+  model::Option option;
+  option.names = {"ids"};
+  option.doc = {"Ids."};
+  option.type = ids;
+  auto cli = make_test_cli();
+  cli.args->push_back(option);
+  Argv args{"test-app", "--ids", "1,2,3"};
+
+  json captured;
+  int rc =
+    json_commander::run(cli, args.argc(), args.argv(), [&](const json& config) {
+      captured = config;
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(captured["ids"].is_binary());
+  REQUIRE(conv::unpack_all(captured["ids"]) == json::array({1, 2, 3}));
+}
+
 TEST_CASE("run: callback return value propagated", "[run]") {
   auto cli = make_test_cli();
   Argv args{"test-app"};
@@ -164,6 +192,23 @@ TEST_CASE("run: parse error returns 1, callback not called", "[run]") {
   REQUIRE_FALSE(called);
 }
 
+TEST_CASE("run: typo prints a hint instead of the help page", "[run]") {
+  auto cli = make_test_cli();
+  Argv args{"test-app", "--outptu", "x"};
+
+  std::ostringstream err;
+  auto* old_buf = std::cerr.rdbuf(err.rdbuf());
+  int rc = json_commander::run(
+    cli, args.argc(), args.argv(), [](const json&) { return 0; });
+  std::cerr.rdbuf(old_buf);
+
+  REQUIRE(rc == 1);
+  REQUIRE(
+    err.str() ==
+    "test-app: unknown option: --outptu (did you mean --output?)\n"
+    "Try 'test-app --help' for more information.\n");
+}
+
 // ===========================================================================
 // Tests for run(const std::string &, ...)  — JSON string overload
 // ===========================================================================
@@ -382,6 +427,330 @@ TEST_CASE("run: missing nested subcommand shows help and returns 1", "[run]") {
   REQUIRE_FALSE(called);
 }
 
+// ===========================================================================
+// Tests for configs handed over by a parent process
+// ===========================================================================
+
+TEST_CASE("run: inherited config skips parsing", "[run]") {
+  auto cli = make_test_cli();
+  Argv args{"test-app", "--bogus"};
+  int fd = handoff::share(
+    {"test-app",
+     {{"output", "inherited.txt"}},
+     handoff::digest(args.argc(), args.argv())});
+  ::setenv(handoff::fd_variable, std::to_string(fd).c_str(), 1);
+
+  json captured;
+  int rc =
+    json_commander::run(cli, args.argc(), args.argv(), [&](const json& config) {
+      captured = config;
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(captured["output"] == "inherited.txt");
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+}
+
+TEST_CASE("run: config inherited for other arguments is ignored", "[run]") {
+  auto cli = make_test_cli();
+  Argv parent{"test-app", "--output", "parent.txt"};
+  int fd = handoff::share(
+    {"test-app",
+     {{"output", "parent.txt"}},
+     handoff::digest(parent.argc(), parent.argv())});
+  ::setenv(handoff::fd_variable, std::to_string(fd).c_str(), 1);
+  Argv args{"test-app", "--output", "child.txt"};
+
+  json captured;
+  int rc =
+    json_commander::run(cli, args.argc(), args.argv(), [&](const json& config) {
+      captured = config;
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(captured["output"] == "child.txt");
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+  REQUIRE(::fcntl(fd, F_GETFD) == -1);
+}
+
+TEST_CASE("run: unreadable inherited config falls back to parsing", "[run]") {
+  auto cli = make_test_cli();
+  ::setenv(handoff::fd_variable, "-1", 1);
+  Argv args{"test-app", "--output", "parsed.txt"};
+
+  json captured;
+  int rc =
+    json_commander::run(cli, args.argc(), args.argv(), [&](const json& config) {
+      captured = config;
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(captured["output"] == "parsed.txt");
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+}
+
+// ===========================================================================
+// Tests for declared config files
+// ===========================================================================
+
+TEST_CASE("run: declared config file fills unset options", "[run]") {
+  auto path = std::filesystem::temp_directory_path() / "jcmd_run_config.json";
+  std::ofstream(path) << R"({"output": "from-file.txt"})";
+  auto cli = make_test_cli();
+  model::ConfigPaths paths{};
+  paths.system = path.string();
+  cli.config = model::Config{"json", paths};
+
+  json captured;
+  Argv none{"test-app"};
+  int rc = json_commander::run(
+    cli, none.argc(), none.argv(), [&](const json& config) {
+      captured = config;
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(captured["output"] == "from-file.txt");
+
+  Argv given{"test-app", "-o", "cli.txt"};
+  rc = json_commander::run(
+    cli, given.argc(), given.argv(), [&](const json& config) {
+      captured = config;
+      return 0;
+    });
+  REQUIRE(captured["output"] == "cli.txt");
+
+  std::ofstream(path) << "{";
+  bool called = false;
+  rc = json_commander::run(cli, none.argc(), none.argv(), [&](const json&) {
+    called = true;
+    return 0;
+  });
+  REQUIRE(rc == 1);
+  REQUIRE_FALSE(called);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("run: a broken config file does not block --help", "[run]") {
+  auto path = std::filesystem::temp_directory_path() / "jcmd_run_broken.json";
+  std::ofstream(path) << "{";
+  auto cli = make_test_cli();
+  model::ConfigPaths paths{};
+  paths.system = path.string();
+  cli.config = model::Config{"json", paths};
+
+  bool called = false;
+  auto main_fn = [&](const json&) {
+    called = true;
+    return 0;
+  };
+  Argv help{"test-app", "--help"};
+  REQUIRE(json_commander::run(cli, help.argc(), help.argv(), main_fn) == 0);
+  Argv version{"test-app", "--version"};
+  REQUIRE(
+    json_commander::run(cli, version.argc(), version.argv(), main_fn) == 0);
+  Argv bad{"test-app", "--bogus"};
+  REQUIRE(json_commander::run(cli, bad.argc(), bad.argv(), main_fn) == 1);
+  REQUIRE_FALSE(called);
+  std::filesystem::remove(path);
+}
+
+// ===========================================================================
+// Tests for memoized invocations
+// ===========================================================================
+
+TEST_CASE("run: repeated invocation reuses the remembered config", "[run]") {
+  auto dir = std::filesystem::temp_directory_path() / "jcmd_run_memo";
+  std::filesystem::remove_all(dir);
+  const char* saved = std::getenv("XDG_CACHE_HOME");
+  std::string previous = saved ? saved : "";
+  ::setenv("XDG_CACHE_HOME", dir.c_str(), 1);
+
+  auto cli = make_test_cli();
+  cli.parsing = model::Parsing{};
+  cli.parsing->memoize = true;
+  json captured;
+  auto capture = [&](const json& config) {
+    captured = config;
+    return 0;
+  };
+  Argv given{"test-app", "-o", "a.txt"};
+  REQUIRE(json_commander::run(cli, given.argc(), given.argv(), capture) == 0);
+  REQUIRE(captured["output"] == "a.txt");
+
+  // Replace the remembered config: a hit hands it over without parsing.
+  auto key = memo::key(cli, given.argc(), given.argv());
+  REQUIRE(key.has_value());
+  REQUIRE(memo::lookup(cli, *key) == memo::Entry{captured, {}});
+  memo::store(cli, *key, {json{{"output", "remembered"}}, {}});
+  REQUIRE(json_commander::run(cli, given.argc(), given.argv(), capture) == 0);
+  REQUIRE(captured["output"] == "remembered");
+
+  Argv other{"test-app", "-o", "b.txt"};
+  REQUIRE(json_commander::run(cli, other.argc(), other.argv(), capture) == 0);
+  REQUIRE(captured["output"] == "b.txt");
+
+  if (saved) {
+    ::setenv("XDG_CACHE_HOME", previous.c_str(), 1);
+  } else {
+    ::unsetenv("XDG_CACHE_HOME");
+  }
+  std::filesystem::remove_all(dir);
+}
+
+// ===========================================================================
+// Tests for positionals read from stdin
+// ===========================================================================
+
+namespace {
+
+  model::Root
+  make_stdin_cli() {
+    model::Positional items;
+    items.name = "items";
+    items.doc = {"Numbers to add."};
+    items.type = model::ScalarType::Int;
+    items.repeated = true;
+    items.from_stdin = "newline";
+
+    model::Root root;
+    root.name = "sum";
+    root.doc = {"Adds numbers."};
+    root.args = std::vector<model::Argument>{items};
+    return root;
+  }
+
+  // Replaces stdin with a pipe holding `data` for the test's duration.
+  struct StdinPipe {
+    int saved = ::dup(STDIN_FILENO);
+
+    explicit StdinPipe(const std::string& data) {
+      int fds[2];
+      REQUIRE(::pipe(fds) == 0);
+      REQUIRE(
+        ::write(fds[1], data.data(), data.size()) ==
+        static_cast<ssize_t>(data.size()));
+      ::close(fds[1]);
+      ::dup2(fds[0], STDIN_FILENO);
+      ::close(fds[0]);
+    }
+
+    ~StdinPipe() {
+      ::dup2(saved, STDIN_FILENO);
+      ::close(saved);
+    }
+  };
+
+} // namespace
+
+TEST_CASE("run: repeated positional read from stdin", "[run]") {
+  auto cli = make_stdin_cli();
+  StdinPipe in("1\n2\n3\n");
+  Argv args{"sum"};
+
+  json config;
+  int total = 0;
+  int rc = json_commander::run(
+    cli,
+    args.argc(),
+    args.argv(),
+    [&](const json& c, input::Stream& values) {
+      config = c;
+      while (auto value = values.next()) {
+        total += value->get<int>();
+      }
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(total == 6);
+  REQUIRE_FALSE(config.contains("items"));
+}
+
+TEST_CASE("run: command line values leave stdin alone", "[run]") {
+  auto cli = make_stdin_cli();
+  StdinPipe in("1\n2\n");
+  Argv args{"sum", "10", "20"};
+
+  json config;
+  bool streamed = true;
+  int rc = json_commander::run(
+    cli,
+    args.argc(),
+    args.argv(),
+    [&](const json& c, input::Stream& values) {
+      config = c;
+      streamed = values.next().has_value();
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(config["items"] == json::array({10, 20}));
+  REQUIRE_FALSE(streamed);
+}
+
+TEST_CASE("run: bad value on stdin returns 1", "[run]") {
+  auto cli = make_stdin_cli();
+  StdinPipe in("1\nseven\n");
+  Argv args{"sum"};
+
+  int rc = json_commander::run(
+    cli, args.argc(), args.argv(), [&](const json&, input::Stream& values) {
+      while (values.next()) {}
+      return 0;
+    });
+  REQUIRE(rc == 1);
+}
+
+TEST_CASE("run: subcommand positional read from stdin", "[run]") {
+  auto sum = make_stdin_cli();
+  model::Command add;
+  add.name = "add";
+  add.doc = {"Adds numbers."};
+  add.args = sum.args;
+  model::Root root;
+  root.name = "calc";
+  root.doc = {"A calculator."};
+  root.commands = std::vector<model::Command>{add};
+  StdinPipe in("4\n5\n");
+  Argv args{"calc", "add"};
+
+  int total = 0;
+  int rc = json_commander::run(
+    root,
+    args.argc(),
+    args.argv(),
+    [&](const json&, input::Stream& values) {
+      while (auto value = values.next()) {
+        total += value->get<int>();
+      }
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(total == 9);
+}
+
+TEST_CASE("run: inherited config does not replace stdin values", "[run]") {
+  auto cli = make_stdin_cli();
+  StdinPipe in("1\n2\n");
+  Argv args{"sum"};
+  int fd = handoff::share(
+    {"sum", json::object(), handoff::digest(args.argc(), args.argv())});
+  ::setenv(handoff::fd_variable, std::to_string(fd).c_str(), 1);
+
+  int total = 0;
+  int rc = json_commander::run(
+    cli,
+    args.argc(),
+    args.argv(),
+    [&](const json&, input::Stream& values) {
+      while (auto value = values.next()) {
+        total += value->get<int>();
+      }
+      return 0;
+    });
+  REQUIRE(rc == 0);
+  REQUIRE(total == 3);
+  REQUIRE(std::getenv(handoff::fd_variable) == nullptr);
+}
+
 // ===========================================================================
 // Tests for run_file
 // ===========================================================================
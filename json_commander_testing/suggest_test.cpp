@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/suggest.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace json_commander;
+
+// ===========================================================================
+// Phase 1: Bounded edit distance
+// ===========================================================================
+
+TEST_CASE("Matcher: identical strings", "[suggest]") {
+  suggest::Matcher m("verbose");
+  REQUIRE(m.distance("verbose", 0) == 0u);
+}
+
+TEST_CASE("Matcher: single edits", "[suggest]") {
+  suggest::Matcher m("verbose");
+  REQUIRE(m.distance("verbos", 1) == 1u);   // deletion
+  REQUIRE(m.distance("verboose", 1) == 1u); // insertion
+  REQUIRE(m.distance("verbese", 1) == 1u);  // substitution
+  REQUIRE(m.distance("verbsoe", 2) == 2u);  // transposition
+}
+
+TEST_CASE("Matcher: distance above bound is rejected", "[suggest]") {
+  suggest::Matcher m("verbose");
+  REQUIRE_FALSE(m.distance("quiet", 3).has_value());
+  REQUIRE_FALSE(m.distance("verbsoe", 1).has_value());
+  REQUIRE_FALSE(m.distance("v", 2).has_value());
+}
+
+TEST_CASE("Matcher: empty query and candidate", "[suggest]") {
+  REQUIRE(suggest::Matcher("").distance("ab", 2) == 2u);
+  REQUIRE(suggest::Matcher("ab").distance("", 2) == 2u);
+  REQUIRE_FALSE(suggest::Matcher("").distance("abc", 2).has_value());
+}
+
+TEST_CASE("Matcher: agrees with the DP distance", "[suggest]") {
+  std::mt19937 rng(7);
+  for (int iter = 0; iter < 2000; ++iter) {
+    std::string a(rng() % 80, 'a');
+    std::string b(rng() % 80, 'a');
+    for (auto& c : a) {
+      c = static_cast<char>('a' + rng() % 4);
+    }
+    for (auto& c : b) {
+      c = static_cast<char>('a' + rng() % 4);
+    }
+    auto expected = suggest::detail::levenshtein(a, b);
+    auto got = suggest::Matcher(a).distance(b, 100);
+    REQUIRE(got == expected);
+  }
+}
+
+// ===========================================================================
+// Phase 2: Nearest names
+// ===========================================================================
+
+TEST_CASE("default_bound: a third of the length, from 1 to 3", "[suggest]") {
+  REQUIRE(suggest::default_bound(1) == 1);
+  REQUIRE(suggest::default_bound(6) == 2);
+  REQUIRE(suggest::default_bound(30) == 3);
+}
+
+TEST_CASE("nearest: closest first, ties in lexical order", "[suggest]") {
+  std::vector<std::string> names = {"status", "stash", "start", "commit"};
+  auto result = suggest::nearest("stat", names, 2);
+  REQUIRE(result == std::vector<std::string>{"start", "stash", "status"});
+}
+
+TEST_CASE("nearest: honours the limit", "[suggest]") {
+  std::vector<std::string> names = {"aa", "ab", "ac", "ad"};
+  REQUIRE(suggest::nearest("a", names, 1, 2).size() == 2);
+}
+
+TEST_CASE("nearest: skips exact matches and far names", "[suggest]") {
+  std::vector<std::string> names = {"build", "bulid", "deploy"};
+  REQUIRE(
+    suggest::nearest("build", names, 2) == std::vector<std::string>{"bulid"});
+}
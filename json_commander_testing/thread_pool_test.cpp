@@ -0,0 +1,86 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace json_commander;
+
+// ===========================================================================
+// Phase 1: Loops
+// ===========================================================================
+
+TEST_CASE("Pool: runs every index exactly once", "[thread_pool]") {
+  thread_pool::Pool pool(4);
+  REQUIRE(pool.size() == 4);
+  std::vector<std::atomic<int>> hits(1000);
+  pool.parallel_for(hits.size(), [&](std::size_t i) { ++hits[i]; });
+  for (const auto& h : hits) {
+    REQUIRE(h.load() == 1);
+  }
+}
+
+TEST_CASE("Pool: fewer indices than threads", "[thread_pool]") {
+  thread_pool::Pool pool(8);
+  std::atomic<int> sum{0};
+  pool.parallel_for(3, [&](std::size_t i) { sum += static_cast<int>(i); });
+  REQUIRE(sum.load() == 3);
+  pool.parallel_for(0, [&](std::size_t) { sum = -1; });
+  REQUIRE(sum.load() == 3);
+}
+
+TEST_CASE("Pool: single thread runs on the caller", "[thread_pool]") {
+  thread_pool::Pool pool(1);
+  auto caller = std::this_thread::get_id();
+  bool same = true;
+  pool.parallel_for(10, [&](std::size_t) {
+    same = same && std::this_thread::get_id() == caller;
+  });
+  REQUIRE(same);
+}
+
+TEST_CASE("Pool: is reusable across loops", "[thread_pool]") {
+  thread_pool::Pool pool(3);
+  for (int round = 0; round < 50; ++round) {
+    std::atomic<int> count{0};
+    pool.parallel_for(97, [&](std::size_t) { ++count; });
+    REQUIRE(count.load() == 97);
+  }
+}
+
+// ===========================================================================
+// Phase 2: Stealing and errors
+// ===========================================================================
+
+TEST_CASE("Pool: idle threads steal from a slow share", "[thread_pool]") {
+  thread_pool::Pool pool(4);
+  // All the slow indices start out in the first thread's share.
+  std::vector<std::thread::id> ran_on(64);
+  pool.parallel_for(ran_on.size(), [&](std::size_t i) {
+    if (i < 16) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }
+    ran_on[i] = std::this_thread::get_id();
+  });
+  bool shared = false;
+  for (std::size_t i = 1; i < 16; ++i) {
+    shared = shared || ran_on[i] != ran_on[0];
+  }
+  REQUIRE(shared);
+}
+
+TEST_CASE("Pool: rethrows the first exception", "[thread_pool]") {
+  thread_pool::Pool pool(4);
+  REQUIRE_THROWS_AS(
+    pool.parallel_for(
+      100,
+      [](std::size_t i) {
+        if (i == 42) { throw std::runtime_error("boom"); }
+      }),
+    std::runtime_error);
+  // The pool stays usable afterwards.
+  std::atomic<int> count{0};
+  pool.parallel_for(10, [&](std::size_t) { ++count; });
+  REQUIRE(count.load() == 10);
+}
@@ -586,3 +586,26 @@ TEST_CASE(
   REQUIRE_THROWS_AS(v.check("--input", std::nullopt), Error);
   REQUIRE_THROWS_AS(v.check("--input", std::nullopt), Error);
 }
+
+// ---------------------------------------------------------------------------
+// Phase 8: Non-throwing validation
+// ---------------------------------------------------------------------------
+
+TEST_CASE("try_validate: built-in validators report a message", "[validate]") {
+  auto v = all_of({required(), must_exist_dir()});
+  REQUIRE(v.try_check);
+  REQUIRE(try_validate(v, "out", std::nullopt) == "out is required");
+  REQUIRE(
+    try_validate(v, "out", json("/nonexistent/dir")) ==
+    "out: /nonexistent/dir is not a directory");
+  REQUIRE_FALSE(try_validate(v, "out", json("/")).has_value());
+}
+
+TEST_CASE("try_validate: falls back to a throwing check", "[validate]") {
+  Validator v{
+    [](const std::string& name, const std::optional<json>&) {
+      throw Error(name + " is bad");
+    },
+    "custom"};
+  REQUIRE(try_validate(v, "x", json(1)) == "x is bad");
+}
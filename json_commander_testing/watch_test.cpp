@@ -0,0 +1,257 @@
+#include <catch2/catch_test_macros.hpp>
+#include <json_commander/watch.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace json_commander;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace {
+
+  struct TempDir {
+    fs::path path;
+    explicit TempDir(const std::string& name)
+        : path(fs::temp_directory_path() / name) {
+      fs::remove_all(path);
+      fs::create_directories(path);
+    }
+    ~TempDir() { fs::remove_all(path); }
+
+    // Writes through a temporary file and a rename, as editors do.
+    void
+    write(const std::string& name, const std::string& text) const {
+      auto file = path / name;
+      fs::create_directories(file.parent_path());
+      auto temp = path / (name + ".new");
+      std::ofstream(temp) << text;
+      fs::rename(temp, file);
+    }
+  };
+
+  model::Root
+  make_root(const TempDir& dir) {
+    model::Option level{};
+    level.names = {"level"};
+    level.doc = {"doc"};
+    level.type = model::ScalarType::String;
+
+    model::Option port{};
+    port.names = {"port"};
+    port.doc = {"doc"};
+    port.type = model::ScalarType::Int;
+
+    model::Command serve{};
+    serve.name = "serve";
+    serve.doc = {"doc"};
+    serve.args = std::vector<model::Argument>{port};
+
+    model::ConfigPaths paths{};
+    paths.system = (dir.path / "etc" / "tool.json").string();
+    paths.drop_in = (dir.path / "conf.d").string();
+
+    model::Root root{};
+    root.name = "tool";
+    root.doc = {"doc"};
+    root.args = std::vector<model::Argument>{level};
+    root.commands = std::vector<model::Command>{serve};
+    root.config = model::Config{"json", paths};
+    return root;
+  }
+
+  // Collects what the watcher thread reports.
+  struct Events {
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::vector<watch::Update> updates;
+    std::vector<std::string> errors;
+
+    watch::ChangeFn
+    on_change() {
+      return [this](const watch::Update& update) {
+        std::lock_guard lock(mutex);
+        updates.push_back(update);
+        arrived.notify_all();
+      };
+    }
+
+    watch::ErrorFn
+    on_error() {
+      return [this](const std::string& message) {
+        std::lock_guard lock(mutex);
+        errors.push_back(message);
+        arrived.notify_all();
+      };
+    }
+
+    bool
+    wait_for(std::size_t count, std::size_t error_count = 0) {
+      std::unique_lock lock(mutex);
+      return arrived.wait_for(lock, 10s, [&] {
+        return updates.size() >= count && errors.size() >= error_count;
+      });
+    }
+  };
+
+} // namespace
+
+// ===========================================================================
+// Phase 1: Loading and publishing
+// ===========================================================================
+
+TEST_CASE("watch: starts with the merged files", "[watch]") {
+  TempDir dir("jcmd_watch_start");
+  dir.write("etc/tool.json", R"({"level": "system"})");
+  dir.write("conf.d/10.json", R"({"serve": {"port": 80}})");
+  Events events;
+  watch::Watcher watcher(
+    make_root(dir), events.on_change(), events.on_error(), dir.path, 20ms);
+  REQUIRE(
+    *watcher.current() ==
+    json{{"level", "system"}, {"serve", {{"port", 80}}}});
+}
+
+TEST_CASE("watch: bad files at start throw", "[watch]") {
+  TempDir dir("jcmd_watch_bad_start");
+  dir.write("etc/tool.json", "{");
+  REQUIRE_THROWS_AS(
+    watch::Watcher(make_root(dir), nullptr, nullptr, dir.path),
+    config_file::Error);
+}
+
+TEST_CASE("watch: refresh publishes a diff of what changed", "[watch]") {
+  TempDir dir("jcmd_watch_refresh");
+  dir.write("etc/tool.json", R"({"level": "system"})");
+  Events events;
+  watch::Watcher watcher(
+    make_root(dir), events.on_change(), events.on_error(), dir.path, 1h);
+  auto before = watcher.current();
+
+  dir.write("conf.d/10.json", R"({"level": "fragment"})");
+  std::string error;
+  REQUIRE(watcher.refresh(error));
+  auto after = watcher.current();
+  REQUIRE(*after == json{{"level", "fragment"}});
+  // The reader holding the old config still has it.
+  REQUIRE(*before == json{{"level", "system"}});
+  REQUIRE(events.wait_for(1));
+
+  // Nothing changed: nothing published.
+  REQUIRE(watcher.refresh(error));
+  REQUIRE(watcher.current() == after);
+  std::lock_guard lock(events.mutex);
+  REQUIRE(events.updates.size() == 1);
+  REQUIRE(events.updates[0].config == after);
+  json patch = {{{"op", "replace"}, {"path", "/level"}, {"value", "fragment"}}};
+  REQUIRE(events.updates[0].diff == patch);
+}
+
+TEST_CASE("watch: on_change runs on the watcher thread", "[watch]") {
+  TempDir dir("jcmd_watch_callback_thread");
+  dir.write("etc/tool.json", R"({"level": "system"})");
+  watch::Watcher* self = nullptr;
+  Events events;
+  auto record = events.on_change();
+  std::thread::id caller = std::this_thread::get_id();
+  std::thread::id ran_on;
+  std::string inner_error;
+  bool inner = false;
+  watch::Watcher watcher(
+    make_root(dir),
+    [&](const watch::Update& update) {
+      // Neither on the caller's thread nor under the Watcher's locks, so
+      // calling back into it is fine.
+      ran_on = std::this_thread::get_id();
+      inner = self->refresh(inner_error);
+      record(update);
+    },
+    nullptr,
+    dir.path,
+    1h);
+  self = &watcher;
+
+  dir.write("etc/tool.json", R"({"level": "edited"})");
+  std::string error;
+  REQUIRE(watcher.refresh(error));
+  REQUIRE(events.wait_for(1));
+  std::lock_guard lock(events.mutex);
+  REQUIRE(ran_on != caller);
+  REQUIRE(inner);
+  REQUIRE(inner_error.empty());
+  REQUIRE(*events.updates[0].config == json{{"level", "edited"}});
+}
+
+TEST_CASE("watch: rejected edits keep the last good config", "[watch]") {
+  TempDir dir("jcmd_watch_reject");
+  dir.write("etc/tool.json", R"({"level": "system"})");
+  watch::Watcher watcher(make_root(dir), nullptr, nullptr, dir.path, 1h);
+  dir.write("etc/tool.json", R"({"level": )");
+  std::string error;
+  REQUIRE_FALSE(watcher.refresh(error));
+  REQUIRE(error.ends_with(": invalid JSON"));
+  REQUIRE(*watcher.current() == json{{"level", "system"}});
+}
+
+// ===========================================================================
+// Phase 2: Watching
+// ===========================================================================
+
+TEST_CASE("watch: edits are picked up in the background", "[watch]") {
+  TempDir dir("jcmd_watch_background");
+  dir.write("etc/tool.json", R"({"level": "system"})");
+  Events events;
+  watch::Watcher watcher(
+    make_root(dir), events.on_change(), events.on_error(), dir.path, 20ms);
+
+  dir.write("etc/tool.json", R"({"level": "edited", "serve": {"port": 1}})");
+  REQUIRE(events.wait_for(1));
+  REQUIRE(
+    *watcher.current() == json{{"level", "edited"}, {"serve", {{"port", 1}}}});
+
+  dir.write("conf.d/10.json", R"({"serve": {"port": 2}})");
+  REQUIRE(events.wait_for(2));
+  std::lock_guard lock(events.mutex);
+  REQUIRE(
+    events.updates[1].diff ==
+    json::parse(R"([{"op": "replace", "path": "/serve/port", "value": 2}])"));
+}
+
+TEST_CASE("watch: background errors go to on_error", "[watch]") {
+  TempDir dir("jcmd_watch_background_error");
+  dir.write("etc/tool.json", R"({"level": "system"})");
+  Events events;
+  watch::Watcher watcher(
+    make_root(dir), events.on_change(), events.on_error(), dir.path, 20ms);
+
+  dir.write("etc/tool.json", "[]");
+  REQUIRE(events.wait_for(0, 1));
+  REQUIRE(*watcher.current() == json{{"level", "system"}});
+}
+
+TEST_CASE("watch: directories created later are watched", "[watch]") {
+  TempDir dir("jcmd_watch_late_dir");
+  dir.write("etc/tool.json", R"({"level": "system"})");
+  auto root = make_root(dir);
+  root.config->paths->drop_in = (dir.path / "late" / "conf.d").string();
+  Events events;
+  // Only the temporary directory itself exists above late/conf.d.
+  watch::Watcher watcher(
+    root, events.on_change(), events.on_error(), dir.path / "etc", 20ms);
+
+  dir.write("late/conf.d/10.json", R"({"level": "late"})");
+  REQUIRE(events.wait_for(1));
+  REQUIRE(*watcher.current() == json{{"level", "late"}});
+
+  dir.write("late/conf.d/20.json", R"({"serve": {"port": 3}})");
+  REQUIRE(events.wait_for(2));
+  REQUIRE(
+    *watcher.current() == json{{"level", "late"}, {"serve", {{"port", 3}}}});
+}
@@ -1,6 +1,8 @@
 export interface ValidationError {
   path?: string;
   message: string;
+  /** Index in argv of the offending argument (parseArgs only). */
+  token?: number;
 }
 
 export interface ErrorResult {
@@ -27,11 +29,49 @@ export interface SchemaResult {
   schema: Record<string, unknown>;
 }
 
+export interface OptionCandidate {
+  long?: string;
+  short?: string;
+  description: string;
+  takesValue: boolean;
+}
+
+export interface CommandCandidate {
+  name: string;
+  description: string;
+}
+
+/** A value the next word fills: an option's argument or a positional. */
+export interface ExpectedValue {
+  name: string;
+  docv: string;
+  description: string;
+  isFile: boolean;
+  isDir: boolean;
+  isPath: boolean;
+  choices: string[];
+}
+
+export interface CompletionResult {
+  success: true;
+  /** The line is decided (e.g. --help); nothing more is read. */
+  done: boolean;
+  commandPath: string[];
+  options: OptionCandidate[];
+  commands: CommandCandidate[];
+  /** Set when the next word is this option's argument. */
+  value?: ExpectedValue;
+  positional?: ExpectedValue;
+  /** Errors in argv so far. */
+  errors: ValidationError[];
+}
+
 export type ValidateResult = SuccessResult | ErrorResult;
 export type HelpResult = TextResult | ErrorResult;
 export type ManpageResult = TextResult | ErrorResult;
 export type ConfigSchemaResult = SchemaResult | ErrorResult;
 export type ParseResult = ConfigResult | ErrorResult;
+export type CompleteResult = CompletionResult | ErrorResult;
 
 export function init(): Promise<void>;
 export function validateSchema(schemaJson: string): ValidateResult;
@@ -39,3 +79,4 @@ export function generateHelp(schemaJson: string, commandPath?: string[]): HelpRe
 export function generateManpage(schemaJson: string, commandPath?: string[]): ManpageResult;
 export function generateConfigSchema(schemaJson: string, commandPath?: string[]): ConfigSchemaResult;
 export function parseArgs(schemaJson: string, argv: string[], env?: Record<string, string>): ParseResult;
+export function completeArgs(schemaJson: string, argv: string[], partial?: string): CompleteResult;
@@ -55,3 +55,9 @@ export function parseArgs(schemaJson, argv, env) {
   if (env) input.env = env;
   return callWasm('parseArgs', input);
 }
+
+export function completeArgs(schemaJson, argv, partial) {
+  const input = { schemaJson, argv };
+  if (partial) input.partial = partial;
+  return callWasm('completeArgs', input);
+}
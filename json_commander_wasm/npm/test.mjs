@@ -6,6 +6,7 @@ import {
   generateManpage,
   generateConfigSchema,
   parseArgs,
+  completeArgs,
 } from './index.js';
 
 const SCHEMA = JSON.stringify({
@@ -173,6 +174,33 @@ test('parseArgs: unknown option returns error', () => {
   assertEqual(result.success, false, 'Expected failure');
 });
 
+test('parseArgs: reports every error at once', () => {
+  const result = parseArgs(SCHEMA, ['--unknown', 'in.txt', 'extra']);
+  assertEqual(result.success, false, 'Expected failure');
+  assertEqual(result.errors.length, 2, 'Expected two errors');
+  assertEqual(result.errors[0].token, 0, 'Expected token index 0');
+  assertEqual(result.errors[1].token, 2, 'Expected token index 2');
+});
+
+test('completeArgs: lists matching options', () => {
+  const result = completeArgs(SCHEMA, [], '--ou');
+  assert(result.success, `Expected success, got: ${JSON.stringify(result)}`);
+  assertEqual(result.options.length, 1, 'Expected one option');
+  assertEqual(result.options[0].long, '--output', 'Expected --output');
+});
+
+test('completeArgs: expects an option value', () => {
+  const result = completeArgs(SCHEMA, ['-v', '--output']);
+  assertEqual(result.value.name, '--output', 'Expected --output value');
+  assertEqual(result.options.length, 0, 'Expected no options');
+});
+
+test('completeArgs: resumes after an edit', () => {
+  completeArgs(SCHEMA, ['-v', 'in.txt']);
+  const result = completeArgs(SCHEMA, ['-v']);
+  assertEqual(result.positional.name, 'input', 'Expected the input positional');
+});
+
 // --- Summary ---
 
 console.log(`\nResults: ${passed} passed, ${failed} failed`);
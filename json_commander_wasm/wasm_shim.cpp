@@ -1,11 +1,15 @@
 // json_commander_wasm/wasm_shim.cpp
 //
 // Wasm shim layer: adapts the json-commander C++ library for browser use.
-// Exposes five stateless functions via Emscripten embind, each accepting
-// and returning JSON-encoded strings.
+// Exposes six functions via Emscripten embind, each accepting and returning
+// JSON-encoded strings. All are stateless except for completeArgs, which
+// keeps the parser state of the last line it saw so each keystroke only
+// parses the tokens that changed.
 
 #include <json_commander/cmd.hpp>
+#include <json_commander/command_index.hpp>
 #include <json_commander/config_schema.hpp>
+#include <json_commander/incremental.hpp>
 #include <json_commander/manpage.hpp>
 #include <json_commander/parse.hpp>
 #include <json_commander/schema_loader.hpp>
@@ -13,6 +17,8 @@
 #include <emscripten/bind.h>
 #include <nlohmann/json.hpp>
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -70,27 +76,98 @@ namespace json_commander::wasm {
       return path;
     }
 
-    std::vector<std::string>
+    // The model and command index of the last schema a help, man page or
+    // config schema call saw, so calls for one schema load and index it
+    // once, as completeArgs does with its grammar.
+    struct SchemaCache {
+      std::string schemaJson;
+      model::Root root;
+      std::optional<command_index::Index> index;
+    };
+
+    const SchemaCache&
+    indexedSchema(const std::string& schemaJson) {
+      static SchemaCache cache;
+      if (!cache.index || cache.schemaJson != schemaJson) {
+        auto root = loadSchema(schemaJson);
+        cache.index = command_index::make(root);
+        cache.root = std::move(root);
+        cache.schemaJson = schemaJson;
+      }
+      return cache;
+    }
+
+    // Validates that the command path exists in the model.
+    void
     findCommand(
-      const model::Root& root, const std::vector<std::string>& commandPath) {
-      // Validate that the command path exists in the model
-      const std::vector<model::Command>* commands =
-        root.commands.has_value() ? &(*root.commands) : nullptr;
+      const command_index::Index& index,
+      const std::vector<std::string>& commandPath) {
+      auto node = command_index::Index::root;
       for (const auto& name : commandPath) {
-        if (commands == nullptr) {
+        auto next = index.child(node, name);
+        if (!next.has_value()) {
           throw schema::Error("Unknown subcommand: " + name);
         }
-        bool found = false;
-        for (const auto& cmd : *commands) {
-          if (cmd.name == name) {
-            commands = cmd.commands.has_value() ? &(*cmd.commands) : nullptr;
-            found = true;
-            break;
-          }
-        }
-        if (!found) { throw schema::Error("Unknown subcommand: " + name); }
+        node = *next;
       }
-      return commandPath;
+    }
+
+    // The grammar of the last schema completeArgs saw, and the parser state
+    // after each token of the last line: states[k] has read k tokens.
+    struct CompletionCache {
+      std::string schemaJson;
+      std::shared_ptr<const incremental::Grammar> grammar;
+      std::vector<std::string> tokens;
+      std::vector<incremental::Parser> states;
+    };
+
+    CompletionCache&
+    completionCache() {
+      static CompletionCache cache;
+      return cache;
+    }
+
+    // Returns the parser state after `argv`, resuming from the longest
+    // prefix of it the cache has already parsed.
+    const incremental::Parser&
+    resume(
+      const std::string& schemaJson, const std::vector<std::string>& argv) {
+      auto& cache = completionCache();
+      if (!cache.grammar || cache.schemaJson != schemaJson) {
+        cache.grammar = std::make_shared<const incremental::Grammar>(
+          loadSchema(schemaJson));
+        cache.schemaJson = schemaJson;
+        cache.tokens.clear();
+        cache.states.assign(1, incremental::Parser(cache.grammar));
+      }
+      std::size_t common = 0;
+      while (common < cache.tokens.size() && common < argv.size() &&
+             cache.tokens[common] == argv[common]) {
+        ++common;
+      }
+      cache.tokens.resize(common);
+      cache.states.erase(
+        cache.states.begin() + static_cast<std::ptrdiff_t>(common + 1),
+        cache.states.end());
+      for (std::size_t i = common; i < argv.size(); ++i) {
+        auto state = cache.states.back();
+        state.feed(argv[i]);
+        cache.tokens.push_back(argv[i]);
+        cache.states.push_back(std::move(state));
+      }
+      return cache.states.back();
+    }
+
+    json
+    expectedJson(const incremental::Expected& expected) {
+      return {
+        {"name", expected.name},
+        {"docv", expected.docv},
+        {"description", expected.description},
+        {"isFile", expected.is_file},
+        {"isDir", expected.is_dir},
+        {"isPath", expected.is_path},
+        {"choices", expected.choices}};
     }
 
   } // namespace detail
@@ -115,10 +192,11 @@ namespace json_commander::wasm {
     return detail::catchAll([&]() -> json {
              auto input = json::parse(inputJson);
              auto schemaJson = input["schemaJson"].get<std::string>();
-             auto root = detail::loadSchema(schemaJson);
+             const auto& cached = detail::indexedSchema(schemaJson);
              auto commandPath = detail::parseCommandPath(input);
-             detail::findCommand(root, commandPath);
-             auto text = manpage::to_plain_text(root, commandPath);
+             detail::findCommand(*cached.index, commandPath);
+             auto text =
+               manpage::to_plain_text(cached.root, *cached.index, commandPath);
              return {{"success", true}, {"text", text}};
            })
       .dump();
@@ -129,10 +207,11 @@ namespace json_commander::wasm {
     return detail::catchAll([&]() -> json {
              auto input = json::parse(inputJson);
              auto schemaJson = input["schemaJson"].get<std::string>();
-             auto root = detail::loadSchema(schemaJson);
+             const auto& cached = detail::indexedSchema(schemaJson);
              auto commandPath = detail::parseCommandPath(input);
-             detail::findCommand(root, commandPath);
-             auto text = manpage::to_groff(root, commandPath);
+             detail::findCommand(*cached.index, commandPath);
+             auto text =
+               manpage::to_groff(cached.root, *cached.index, commandPath);
              return {{"success", true}, {"text", text}};
            })
       .dump();
@@ -143,10 +222,11 @@ namespace json_commander::wasm {
     return detail::catchAll([&]() -> json {
              auto input = json::parse(inputJson);
              auto schemaJson = input["schemaJson"].get<std::string>();
-             auto root = detail::loadSchema(schemaJson);
+             const auto& cached = detail::indexedSchema(schemaJson);
              auto commandPath = detail::parseCommandPath(input);
-             detail::findCommand(root, commandPath);
-             auto schema = config_schema::to_config_schema(root, commandPath);
+             detail::findCommand(*cached.index, commandPath);
+             auto schema = config_schema::to_config_schema(
+               cached.root, *cached.index, commandPath);
              return {{"success", true}, {"schema", schema}};
            })
       .dump();
@@ -201,13 +281,14 @@ namespace json_commander::wasm {
 
              // Compile and parse
              auto spec = cmd::make(root);
-             auto result = parse::parse(spec, argv, envLookup);
+             auto result = parse::parse_all(spec, argv, envLookup);
 
              return std::visit(
                [](auto&& r) -> json {
                  using T = std::decay_t<decltype(r)>;
                  if constexpr (std::is_same_v<T, parse::ParseOk>) {
-                   return {{"success", true}, {"config", r.config}};
+                   return {
+                     {"success", true}, {"config", conv::unpack_all(r.config)}};
                  } else if constexpr (std::is_same_v<T, parse::HelpRequest>) {
                    return detail::errorResponse(
                      "Use generateHelp() for help text instead of --help");
@@ -225,6 +306,14 @@ namespace json_commander::wasm {
                                         parse::CompletionRequest>) {
                    return detail::errorResponse(
                      "Shell completion is not available in the browser");
+                 } else if constexpr (std::is_same_v<T, parse::ParseErrors>) {
+                   json errors = json::array();
+                   for (const auto& error : r.errors) {
+                     json err = {{"message", error.message}};
+                     if (error.token) { err["token"] = *error.token; }
+                     errors.push_back(std::move(err));
+                   }
+                   return {{"success", false}, {"errors", std::move(errors)}};
                  }
                },
                result);
@@ -232,6 +321,69 @@ namespace json_commander::wasm {
       .dump();
   }
 
+  std::string
+  completeArgs(const std::string& inputJson) {
+    return detail::catchAll([&]() -> json {
+             auto input = json::parse(inputJson);
+             auto schemaJson = input["schemaJson"].get<std::string>();
+
+             // The complete words before the cursor; `partial` is the word
+             // being typed
+             std::vector<std::string> argv;
+             if (input.contains("argv") && input["argv"].is_array()) {
+               for (const auto& arg : input["argv"]) {
+                 argv.push_back(arg.get<std::string>());
+               }
+             }
+             auto partial = input.value("partial", std::string());
+
+             const auto& parser = detail::resume(schemaJson, argv);
+             auto next = parser.next(partial);
+
+             json options = json::array();
+             for (const auto& info : next.options) {
+               json option = {
+                 {"description", info.description},
+                 {"takesValue", info.takes_value}};
+               if (!info.long_name.empty()) {
+                 option["long"] = "--" + info.long_name;
+               }
+               if (!info.short_name.empty()) {
+                 option["short"] = "-" + info.short_name;
+               }
+               options.push_back(std::move(option));
+             }
+             json commands = json::array();
+             for (const auto& command : next.commands) {
+               commands.push_back(
+                 {{"name", command.name},
+                  {"description", command.description}});
+             }
+             json errors = json::array();
+             for (const auto& error : parser.errors()) {
+               json err = {{"message", error.message}};
+               if (error.token) { err["token"] = *error.token; }
+               errors.push_back(std::move(err));
+             }
+
+             json result = {
+               {"success", true},
+               {"done", next.done},
+               {"commandPath", parser.command_path()},
+               {"options", std::move(options)},
+               {"commands", std::move(commands)},
+               {"errors", std::move(errors)}};
+             if (next.value) {
+               result["value"] = detail::expectedJson(*next.value);
+             }
+             if (next.positional) {
+               result["positional"] = detail::expectedJson(*next.positional);
+             }
+             return result;
+           })
+      .dump();
+  }
+
 } // namespace json_commander::wasm
 
 // ---------------------------------------------------------------------------
@@ -246,4 +398,5 @@ EMSCRIPTEN_BINDINGS(json_commander_wasm) {
   emscripten::function(
     "generateConfigSchema", &json_commander::wasm::generateConfigSchema);
   emscripten::function("parseArgs", &json_commander::wasm::parseArgs);
+  emscripten::function("completeArgs", &json_commander::wasm::completeArgs);
 }
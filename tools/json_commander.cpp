@@ -4,22 +4,29 @@
 //   validate       Validate a schema against the metaschema
 //   config-schema  Generate a JSON Schema for runtime configuration
 //   parse          Parse arguments against a schema, output config
+//   exec           Parse arguments once, then run a program with the config
 //   help           Generate plain-text help for a schema
 //   man            Generate a groff man page for a schema
 
 #include <json_commander/cmd.hpp>
 #include <json_commander/completion.hpp>
 #include <json_commander/config_schema.hpp>
+#include <json_commander/handoff.hpp>
 #include <json_commander/manpage.hpp>
 #include <json_commander/model_emit.hpp>
 #include <json_commander/parse.hpp>
 #include <json_commander/run.hpp>
 #include <json_commander/schema_loader.hpp>
+#include <json_commander/thread_pool.hpp>
 
 #include "json_commander_schema.hpp"
 
+#include <array>
+#include <cstddef>
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace json_commander;
@@ -43,7 +50,9 @@ int
 do_validate(const nlohmann::json& config) {
   auto schema_file = config.at("schema-file").get<std::string>();
   schema::Loader loader;
-  loader.load(schema_file);
+  // Compiling it catches what the metaschema cannot, such as two
+  // subcommands with one name.
+  cmd::make(loader.load(schema_file));
   std::cout << "ok\n";
   return 0;
 }
@@ -64,6 +73,137 @@ do_config_schema(const nlohmann::json& config) {
   return 0;
 }
 
+// Records are processed in blocks, so each pool loop has plenty of work
+// while memory stays bounded however long stdin is.
+constexpr std::size_t batch_block_size = 4096;
+
+nlohmann::json
+error_record(const parse::ErrorInfo& error) {
+  nlohmann::json record = {
+    {"kind", parse::to_string(error.kind)},
+    {"message", error.message},
+  };
+  if (error.token) { record["token"] = *error.token; }
+  if (!error.arg.empty()) { record["arg"] = error.arg; }
+  return record;
+}
+
+// The output line for one parsed record. Successful parses carry the
+// config, failed ones their errors, and requests such as --help name
+// the request.
+nlohmann::json
+result_record(const parse::ParseResult& result) {
+  return std::visit(
+    [](const auto& r) -> nlohmann::json {
+      using T = std::decay_t<decltype(r)>;
+      if constexpr (std::is_same_v<T, parse::ParseOk>) {
+        return {{"config", conv::unpack_all(r.config)}};
+      } else if constexpr (std::is_same_v<T, parse::ParseErrors>) {
+        auto errors = nlohmann::json::array();
+        for (const auto& error : r.errors) {
+          errors.push_back(error_record(error));
+        }
+        return {{"errors", std::move(errors)}};
+      } else if constexpr (std::is_same_v<T, parse::HelpRequest>) {
+        return {{"request", "help"}, {"command_path", r.command_path}};
+      } else if constexpr (std::is_same_v<T, parse::ManpageRequest>) {
+        return {{"request", "manpage"}, {"command_path", r.command_path}};
+      } else if constexpr (std::is_same_v<T, parse::VersionRequest>) {
+        return {{"request", "version"}};
+      } else if constexpr (std::is_same_v<T, parse::CompletionRequest>) {
+        return {{"request", "completion"}, {"shell", r.shell}};
+      }
+    },
+    result);
+}
+
+// A record is a JSON array of argument strings (without the program name),
+// or an object holding that array under "argv". Returns the output line and
+// whether the record parsed without errors.
+std::pair<std::string, bool>
+process_record(
+  const cmd::RootSpec& spec,
+  const parse::EnvLookup& env,
+  const std::string& line,
+  bool all_errors) {
+  std::vector<std::string> args;
+  try {
+    auto record = nlohmann::json::parse(line);
+    const auto& argv = record.is_object() ? record.at("argv") : record;
+    args = argv.get<std::vector<std::string>>();
+  } catch (const nlohmann::json::exception& e) {
+    nlohmann::json error = {
+      {"kind", "invalid_record"},
+      {"message", e.what()},
+    };
+    return {nlohmann::json{{"errors", {error}}}.dump(), false};
+  }
+
+  // The parser's scratch state lives on the stack unless the record is
+  // unusually long, and is dropped with the result below.
+  std::array<std::byte, 4096> scratch;
+  std::pmr::monotonic_buffer_resource memory(scratch.data(), scratch.size());
+  parse::ParseResult result;
+  if (all_errors) {
+    result = parse::parse_all(spec, args, env, nullptr, &memory);
+  } else if (
+    auto first = parse::try_parse(spec, args, env, nullptr, &memory)) {
+    result = std::move(first).value();
+  } else {
+    result = parse::ParseErrors{{first.error()}};
+  }
+  bool ok = !std::holds_alternative<parse::ParseErrors>(result);
+  return {result_record(result).dump(), ok};
+}
+
+// parse --batch: the schema is loaded and compiled once, then every stdin
+// record is parsed against it on a thread pool. Output order matches input
+// order; blank lines are skipped.
+int
+do_parse_batch(const model::Root& root, const nlohmann::json& config) {
+  std::size_t jobs = 0;
+  if (config.contains("jobs")) {
+    auto n = config.at("jobs").get<int>();
+    if (n < 1) {
+      std::cerr << "error: --jobs must be at least 1\n";
+      return 1;
+    }
+    jobs = static_cast<std::size_t>(n);
+  }
+  const bool all_errors = config.at("all-errors").get<bool>();
+
+  auto spec = cmd::make(root);
+  // Every record sees the environment as it was when the batch started.
+  auto env = parse::env_snapshot(spec);
+  thread_pool::Pool pool(jobs);
+  std::ios::sync_with_stdio(false);
+
+  bool failed = false;
+  std::vector<std::string> lines;
+  std::vector<std::pair<std::string, bool>> outputs;
+  auto flush = [&] {
+    outputs.assign(lines.size(), {});
+    pool.parallel_for(lines.size(), [&](std::size_t i) {
+      outputs[i] = process_record(spec, env, lines[i], all_errors);
+    });
+    for (const auto& [text, ok] : outputs) {
+      std::cout << text << '\n';
+      failed = failed || !ok;
+    }
+    lines.clear();
+  };
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) { continue; }
+    lines.push_back(std::move(line));
+    if (lines.size() == batch_block_size) { flush(); }
+  }
+  flush();
+  std::cout.flush();
+  return failed ? 1 : 0;
+}
+
 int
 do_parse(const nlohmann::json& config) {
   auto schema_file = config.at("schema-file").get<std::string>();
@@ -75,14 +215,91 @@ do_parse(const nlohmann::json& config) {
 
   schema::Loader loader;
   auto root = loader.load(schema_file);
+  if (config.at("batch").get<bool>()) {
+    if (!schema_args.empty()) {
+      std::cerr << "error: --batch reads arguments from stdin, not the "
+                   "command line\n";
+      return 1;
+    }
+    return do_parse_batch(root, config);
+  }
   auto spec = cmd::make(root);
-  auto result = parse::parse(spec, schema_args);
+  auto result = config.at("all-errors").get<bool>()
+                  ? parse::parse_all(spec, schema_args)
+                  : parse::parse(spec, schema_args);
 
   if (auto* ok = std::get_if<parse::ParseOk>(&result)) {
-    std::cout << ok->config.dump(2) << "\n";
+    std::cout << conv::unpack_all(ok->config).dump(2) << "\n";
+    return 0;
+  }
+
+  if (auto* failed = std::get_if<parse::ParseErrors>(&result)) {
+    for (const auto& error : failed->errors) {
+      std::cerr << "error: " << error.message << "\n";
+    }
+    return 1;
+  }
+
+  if (auto* help = std::get_if<parse::HelpRequest>(&result)) {
+    std::cout << manpage::to_plain_text(root, help->command_path);
+    return 0;
+  }
+
+  if (auto* man = std::get_if<parse::ManpageRequest>(&result)) {
+    std::cout << manpage::to_groff(root, man->command_path);
+    return 0;
+  }
+
+  if (std::holds_alternative<parse::VersionRequest>(result)) {
+    if (root.version) {
+      std::cout << root.name << " version " << *root.version << "\n";
+    }
     return 0;
   }
 
+  return 1;
+}
+
+// exec: the arguments are parsed and validated here, once; the program is
+// then exec'd with the same arguments and the config handed over, so a
+// json-commander program (or a wrapper chain ending in one) picks it up
+// with run() or inherited_config() instead of parsing again. Requests such
+// as --help are answered here and the program is not run.
+int
+do_exec(const nlohmann::json& config) {
+  auto schema_file = config.at("schema-file").get<std::string>();
+  std::vector<std::string> argv = {config.at("program").get<std::string>()};
+  if (config.contains("program-args")) {
+    for (const auto& arg : config.at("program-args")) {
+      argv.push_back(arg.get<std::string>());
+    }
+  }
+
+  schema::Loader loader;
+  auto root = loader.load(schema_file);
+  auto spec = cmd::make(root);
+  auto result = parse::parse(spec, {argv.begin() + 1, argv.end()});
+
+  if (auto* ok = std::get_if<parse::ParseOk>(&result)) {
+    auto leaf = spec.index->find(ok->command_path);
+    if (leaf.has_value() && spec.index->child_count(*leaf) > 0) {
+      std::cerr << "error: missing subcommand\n";
+      return 1;
+    }
+    try {
+      auto schema =
+        config_schema::to_config_schema(root, *spec.index, ok->command_path);
+      nlohmann::json_schema::json_validator validator;
+      validator.set_root_schema(schema);
+      validator.validate(conv::unpack_all(ok->config));
+    } catch (const std::exception& e) {
+      std::cerr << "error: config failed schema validation: " << e.what()
+                << "\n";
+      return 1;
+    }
+    handoff::exec({root.name, ok->config, 0, ok->command_path}, argv);
+  }
+
   if (auto* help = std::get_if<parse::HelpRequest>(&result)) {
     std::cout << manpage::to_plain_text(root, help->command_path);
     return 0;
@@ -156,6 +373,7 @@ dispatch(const parse::ParseOk& ok) {
   if (command == "validate") return do_validate(cmd_config);
   if (command == "config-schema") return do_config_schema(cmd_config);
   if (command == "parse") return do_parse(cmd_config);
+  if (command == "exec") return do_exec(cmd_config);
   if (command == "help") return do_help(cmd_config);
   if (command == "man") return do_man(cmd_config);
   if (command == "codegen") return do_codegen(cmd_config);